@@ -1,11 +1,14 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
 layout(location = 3) in vec2 fragUV;
+layout(location = 4) flat in uint fragTextureIndex;
 
-layout(binding = 1) uniform sampler2D texSampler;
+// ODBindlessTextures, partially bound: only the elements objects point at are valid
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
 layout(location = 0) out vec4 outColor;
 
@@ -23,11 +26,6 @@ layout(set = 0, binding = 0) uniform UBO {
   int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
-  mat4 modelMatrix; 
-  mat4 normalMatrix;
-} push;
-
 void main() {
   vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
   vec3 specularLight = vec3(0.0);
@@ -58,7 +56,8 @@ void main() {
 
   vec4 lightingColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
 
-  vec4 textureColor = texture(texSampler, fragUV);
+  // objects of one multi draw can pick different textures
+  vec4 textureColor = texture(textures[nonuniformEXT(fragTextureIndex)], fragUV);
 
   outColor = vec4(lightingColor.rgb * textureColor.rgb, 1.0);
 }
\ No newline at end of file
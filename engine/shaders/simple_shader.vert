@@ -9,6 +9,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out uint fragTextureIndex;
 
 struct PointLight {
   vec4 position;
@@ -24,19 +25,32 @@ layout(set = 0, binding = 0) uniform UBO {
   int numLights;
 } ubo;
 
+struct ObjectData {
+  mat4 modelMatrix;
+  mat3 normalMatrix;
+  uint textureIndex; // element of textures[], set 1
+};
+
+// written by SimpleRendererSystem every frame
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+// indirect draws carry the object index in firstInstance, direct draws push it
 layout(push_constant) uniform Push {
-  mat4 modelMatrix; 
-  mat4 normalMatrix;
+  uint objectIndex;
 } push;
 
 void main() {
-  vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+  ObjectData object = objects[push.objectIndex + gl_InstanceIndex];
+  vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
 
   gl_Position = ubo.projection * ubo.view * positionWorld;
 
   // vec3 normalWorldSpace = normalize(mat3(push.modelMatrix) * normal); only works if scale is uniform
-  fragNormalWorld =normalize(mat3(push.normalMatrix) * normal); 
+  fragNormalWorld =normalize(object.normalMatrix * normal); 
   fragPosWorld = positionWorld.xyz;
   fragColor = color;
   fragUV = uv;
+  fragTextureIndex = object.textureIndex;
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#version 450
+
+// CompactVertex inputs, the fragment stage is shared with simple_shader.vert
+layout(location = 0) in vec4 position; // unorm, dequantized by push.modelMatrix
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 normal;   // octahedral
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out uint fragTextureIndex;
+
+struct PointLight {
+  vec4 position;
+  vec4 color;
+};
+
+layout(set = 0, binding = 0) uniform UBO {
+  mat4 projection;
+  mat4 view;
+  mat4 inverseView;
+  vec4 ambientLightColor;
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+struct ObjectData {
+  mat4 modelMatrix; // model matrix * mesh dequantization transform
+  mat3 normalMatrix;
+  uint textureIndex;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+  ObjectData objects[];
+};
+
+layout(push_constant) uniform Push {
+  uint objectIndex;
+} push;
+
+vec3 octahedralDecode(vec2 p) {
+  vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+  if (n.z < 0.0) {
+    n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  }
+  return normalize(n);
+}
+
+void main() {
+  ObjectData object = objects[push.objectIndex + gl_InstanceIndex];
+  vec4 positionWorld = object.modelMatrix * vec4(position.xyz, 1.0);
+
+  gl_Position = ubo.projection * ubo.view * positionWorld;
+
+  fragNormalWorld = normalize(object.normalMatrix * octahedralDecode(normal));
+  fragPosWorld = positionWorld.xyz;
+  fragColor = color.rgb;
+  fragUV = uv;
+  fragTextureIndex = object.textureIndex;
+}
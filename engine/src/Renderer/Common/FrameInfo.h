@@ -6,10 +6,18 @@
 //lib
 #include <vulkan/vulkan.h>
 
+// std
+#include <array>
+
 namespace ODEngine {
+    class ODAssetRegistry;
 
     # define MAX_LIGHTS 10
 
+    // dynamic uniform bindings of the global set, in binding order:
+    // 0 = GlobalUbo, 4 = ComputeShaderUbo
+    constexpr uint32_t GLOBAL_DYNAMIC_OFFSET_COUNT = 2;
+
     struct PointLight {
         glm::vec4 position{};
         glm::vec4 color{};
@@ -32,6 +40,10 @@ namespace ODEngine {
         VkDescriptorSet globalDescriptorSet;
         ODGameObject::Map& gameObjects;
         VkBuffer particleBuffer;
+        std::array<uint32_t, GLOBAL_DYNAMIC_OFFSET_COUNT> globalDynamicOffsets{};
+        VkExtent2D extent{};
+        // resolves ODGameObject::model and texture, collects the texture streaming requests
+        ODAssetRegistry* assets = nullptr;
     };
     
     struct ComputeShaderUbo {
@@ -0,0 +1,66 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace ODEngine {
+    class ODModel;
+    class ODTextureHandler;
+    class ODSampler;
+    class ODAssetRegistry;
+
+    // Generational index into one of ODAssetRegistry's slot arrays. Copying a handle is free;
+    // references are counted explicitly through ODAssetRegistry::retain/release, or held by an
+    // ODAssetRef. A handle whose slot was freed and reused no longer resolves (its generation
+    // is behind).
+    template<typename T>
+    struct ODAssetHandle {
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        uint32_t index = INVALID_INDEX;
+        uint32_t generation = 0;
+
+        bool isValid() const { return index != INVALID_INDEX; }
+        bool operator==(const ODAssetHandle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const ODAssetHandle& other) const { return !(*this == other); }
+    };
+
+    using ODModelHandle = ODAssetHandle<ODModel>;
+    using ODTextureHandle = ODAssetHandle<ODTextureHandler>;
+    using ODSamplerHandle = ODAssetHandle<ODSampler>;
+
+    // Owning handle: holds a reference of its own on the asset it points at, retained when
+    // assigned and released when replaced or destroyed. It converts to the plain handle to
+    // resolve it. Main thread only, and it must not outlive the registry.
+    template<typename T>
+    class ODAssetRef {
+        public:
+            ODAssetRef() = default;
+            ODAssetRef(ODAssetRegistry& registry, ODAssetHandle<T> handle);
+            ~ODAssetRef();
+
+            ODAssetRef(const ODAssetRef& other);
+            ODAssetRef& operator=(const ODAssetRef& other);
+            ODAssetRef(ODAssetRef&& other) noexcept;
+            ODAssetRef& operator=(ODAssetRef&& other) noexcept;
+
+            // retains handle (an empty handle clears the reference), releases the previous one
+            void reset(ODAssetRegistry& registry, ODAssetHandle<T> handle);
+            void reset();
+
+            ODAssetHandle<T> get() const { return m_handle; }
+            operator ODAssetHandle<T>() const { return m_handle; }
+            bool isValid() const { return m_handle.isValid(); }
+
+        private:
+            ODAssetRegistry* m_registry = nullptr;
+            ODAssetHandle<T> m_handle{};
+    };
+
+    // defined for these in ODAssetRegistry.cpp
+    using ODModelRef = ODAssetRef<ODModel>;
+    using ODTextureRef = ODAssetRef<ODTextureHandler>;
+    using ODSamplerRef = ODAssetRef<ODSampler>;
+}
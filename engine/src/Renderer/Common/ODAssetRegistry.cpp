@@ -0,0 +1,635 @@
+#include "ODAssetRegistry.h"
+#include "ODMeshCache.h"
+#include "../Vulkan/ODSwapChain.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace ODEngine {
+
+    ODAssetRegistry::ODAssetRegistry(ODDevice &device, uint64_t memoryBudget)
+        : m_device(device), m_memoryBudget(memoryBudget), m_textureFormat(ODTextureHandler::chooseFormat(device)),
+          m_bindlessTextures(device), m_streamer(device) {
+        createPlaceholderModel();
+        m_streamer.setModelResidentCheck([this](uint64_t hash) { return m_models.byContent.count(hash) > 0; });
+        m_streamer.setTextureResidentCheck([this](uint64_t hash) { return m_textures.byContent.count(hash) > 0; });
+    }
+
+    ODAssetRegistry::~ODAssetRegistry() = default;
+
+    std::string ODAssetRegistry::canonicalPath(const std::string &filepath) {
+        std::error_code error;
+        // absolute first, weakly_canonical leaves relative paths to missing files as they are
+        std::filesystem::path path = std::filesystem::absolute(filepath, error);
+        if (!error) {
+            path = std::filesystem::weakly_canonical(path, error);
+        }
+        return error ? filepath : path.generic_string();
+    }
+
+    ODModelHandle ODAssetRegistry::loadModel(const std::string &filepath, const ODVertexCompressionSettings &compression,
+        LoadMode mode, ModelCallback onDone) {
+        std::string key = canonicalPath(filepath);
+        if (compression.enabled) {
+            // compact and full vertices of the same file are different assets
+            key += "?compact=" + std::to_string(compression.maxPositionError) + "," +
+                std::to_string(compression.maxNormalErrorDegrees) + "," + std::to_string(compression.maxUvError) +
+                "," + std::to_string(compression.maxColorError);
+        }
+
+        bool created = false;
+        ODModelHandle handle = acquire(m_models, key, created);
+        if (created && mode == LoadMode::Async) {
+            uint32_t index = handle.index;
+            m_streamer.loadModel(filepath, compression,
+                [this, index](ODStreamResult<ODModel> &result) { complete(m_models, index, result); });
+        } else if (created) {
+            ODStreamResult<ODModel> result{};
+            result.path = filepath;
+            try {
+                result.contentHash = ODAssetStreamer::hashModel(filepath, compression);
+                if (result.contentHash != 0 && m_models.byContent.count(result.contentHash) > 0) {
+                    result.duplicate = true;
+                } else {
+                    result.asset = ODModel::createModelFromFile(m_device, filepath, compression);
+                    result.bytes = result.asset->getMemorySize();
+                }
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                std::cerr << "failed to load model " << filepath << ": " << e.what() << std::endl;
+            }
+            complete(m_models, handle.index, result);
+        }
+        whenDone(m_models, handle, std::move(onDone));
+        return handle;
+    }
+
+    ODTextureHandle ODAssetRegistry::loadTexture(const std::string &filepath, LoadMode mode, TextureCallback onDone) {
+        if (mode == LoadMode::Blocking) {
+            return loadTextures({filepath}, mode, std::move(onDone)).front();
+        }
+        bool created = false;
+        ODTextureHandle handle = acquire(m_textures, canonicalPath(filepath), created);
+        if (created) {
+            uint32_t index = handle.index;
+            m_streamer.loadTexture(filepath, m_textureFormat,
+                [this, index](ODStreamResult<ODTextureHandler> &result) { complete(m_textures, index, result); });
+        }
+        whenDone(m_textures, handle, std::move(onDone));
+        return handle;
+    }
+
+    std::vector<ODTextureHandle> ODAssetRegistry::loadTextures(const std::vector<std::string> &filepaths,
+        LoadMode mode, TextureCallback onDone) {
+        std::vector<ODTextureHandle> handles;
+        handles.reserve(filepaths.size());
+        if (mode == LoadMode::Async) {
+            for (const std::string &filepath : filepaths) {
+                handles.push_back(loadTexture(filepath, mode, onDone));
+            }
+            return handles;
+        }
+
+        // every new file starts decoding before the first upload
+        std::vector<std::pair<size_t, std::future<ODAssetStreamer::DecodedTexture>>> decoding;
+        for (size_t i = 0; i < filepaths.size(); i++) {
+            bool created = false;
+            handles.push_back(acquire(m_textures, canonicalPath(filepaths[i]), created));
+            if (created) {
+                decoding.emplace_back(i, m_streamer.decodeTexture(filepaths[i], m_textureFormat));
+            }
+        }
+        for (auto &[i, future] : decoding) {
+            ODStreamResult<ODTextureHandler> result{};
+            result.path = filepaths[i];
+            try {
+                ODAssetStreamer::DecodedTexture decoded = future.get();
+                result.contentHash = decoded.contentHash;
+                // a copy of a file decoded earlier in the batch is a duplicate too
+                if (result.contentHash != 0 && m_textures.byContent.count(result.contentHash) > 0) {
+                    result.duplicate = true;
+                } else {
+                    result.asset = std::make_unique<ODTextureHandler>(m_device);
+                    result.asset->addTexture(decoded.image);
+                    result.bytes = result.asset->getMemorySize();
+                }
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                std::cerr << "failed to load texture " << filepaths[i] << ": " << e.what() << std::endl;
+            }
+            complete(m_textures, handles[i].index, result);
+        }
+        for (ODTextureHandle handle : handles) {
+            whenDone(m_textures, handle, onDone);
+        }
+        return handles;
+    }
+
+    ODModelHandle ODAssetRegistry::addModel(const std::string &name, const ODModel::Builder &builder,
+        const ODVertexCompressionSettings &compression) {
+        bool created = false;
+        ODModelHandle handle = acquire(m_models, name, created);
+        if (created) {
+            ODStreamResult<ODModel> result{};
+            result.path = name;
+            try {
+                result.asset = std::make_unique<ODModel>(m_device, builder, compression);
+                result.bytes = result.asset->getMemorySize();
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                std::cerr << "failed to create model " << name << ": " << e.what() << std::endl;
+            }
+            complete(m_models, handle.index, result);
+        }
+        return handle;
+    }
+
+    ODTextureHandle ODAssetRegistry::addTexture(const std::string &name, const uint8_t *encoded, size_t size) {
+        bool created = false;
+        ODTextureHandle handle = acquire(m_textures, name, created);
+        if (created) {
+            ODStreamResult<ODTextureHandler> result{};
+            result.path = name;
+            // hashed like ODAssetStreamer::hashFile, the same image as a file is a duplicate
+            result.contentHash = ODMeshCache::hashBytes(encoded, size);
+            try {
+                if (m_textures.byContent.count(result.contentHash) > 0) {
+                    result.duplicate = true;
+                } else {
+                    result.asset = std::make_unique<ODTextureHandler>(m_device);
+                    result.asset->addTexture(ODTextureHandler::decode(encoded, size, m_textureFormat));
+                    result.bytes = result.asset->getMemorySize();
+                }
+            } catch (const std::exception &e) {
+                result.error = e.what();
+                result.asset.reset();
+                std::cerr << "failed to create texture " << name << ": " << e.what() << std::endl;
+            }
+            complete(m_textures, handle.index, result);
+        }
+        return handle;
+    }
+
+    ODSamplerHandle ODAssetRegistry::loadSampler(const ODSamplerSettings &settings) {
+        bool created = false;
+        ODSamplerHandle handle = acquire(m_samplers, settings, created);
+        if (created) {
+            auto &slot = m_samplers.slots[handle.index];
+            slot.asset = std::make_unique<ODSampler>(m_device, settings);
+            slot.state = State::Resident;
+            m_samplers.assets[handle.index] = slot.asset.get();
+        }
+        return handle;
+    }
+
+    void ODAssetRegistry::retain(ODModelHandle handle) { retain(m_models, handle); }
+    void ODAssetRegistry::retain(ODTextureHandle handle) { retain(m_textures, handle); }
+    void ODAssetRegistry::retain(ODSamplerHandle handle) { retain(m_samplers, handle); }
+    void ODAssetRegistry::release(ODModelHandle handle) { release(m_models, handle); }
+    void ODAssetRegistry::release(ODTextureHandle handle) { release(m_textures, handle); }
+    void ODAssetRegistry::release(ODSamplerHandle handle) { release(m_samplers, handle); }
+
+    void ODAssetRegistry::requestTextureResolution(ODTextureHandle handle, float pixels) {
+        if (!isLive(m_textures, handle)) {
+            return;
+        }
+        // the feedback goes to the slot owning the GPU texture
+        uint32_t index = handle.index;
+        if (m_textures.slots[index].aliasOf != NO_SLOT) {
+            index = m_textures.slots[index].aliasOf;
+        }
+        if (index >= m_textureFeedback.size()) {
+            m_textureFeedback.resize(m_textures.slots.size());
+        }
+        TextureFeedback &feedback = m_textureFeedback[index];
+        if (feedback.frame != m_frame) {
+            feedback = {m_frame, pixels};
+        } else {
+            feedback.pixels = std::max(feedback.pixels, pixels);
+        }
+    }
+
+    void ODAssetRegistry::update() {
+        m_streamer.update();
+        m_frame++;
+
+        releaseRetiredAssets();
+        evictUnreferenced();
+        streamTextureLevels();
+    }
+
+    void ODAssetRegistry::evictUnreferenced() {
+        // Unreferenced and no longer used by a frame in flight. Failed loads and aliases hold
+        // no memory of their own and go right away (an alias pins the asset it points to), the
+        // rest waits for the budget. Samplers are few and untracked, they stay.
+        struct Candidate {
+            uint64_t releasedFrame;
+            bool texture;
+            uint32_t index;
+        };
+        std::vector<Candidate> candidates;
+        auto collect = [&](auto &pool, bool texture) {
+            for (uint32_t index = 0; index < pool.slots.size(); index++) {
+                auto &slot = pool.slots[index];
+                if (slot.refCount > 0 || slot.state == State::Loading ||
+                    m_frame - slot.releasedFrame <= ODSwapChain::MAX_FRAMES_IN_FLIGHT) {
+                    continue;
+                }
+                if (slot.state == State::Failed || slot.aliasOf != NO_SLOT) {
+                    evict(pool, index);
+                } else {
+                    candidates.push_back({slot.releasedFrame, texture, index});
+                }
+            }
+        };
+        collect(m_models, false);
+        collect(m_textures, true);
+        if (getResidentBytes() <= m_memoryBudget) {
+            return;
+        }
+
+        // least recently released first
+        std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) { return a.releasedFrame < b.releasedFrame; });
+        for (const Candidate &candidate : candidates) {
+            if (getResidentBytes() <= m_memoryBudget) {
+                break;
+            }
+            if (candidate.texture) {
+                evict(m_textures, candidate.index);
+            } else {
+                evict(m_models, candidate.index);
+            }
+        }
+    }
+
+    void ODAssetRegistry::releaseRetiredAssets() {
+        std::erase_if(m_retiredTextures, [this](const RetiredTexture &retired) {
+            if (m_frame - retired.frame <= ODSwapChain::MAX_FRAMES_IN_FLIGHT) {
+                return false;
+            }
+            m_bindlessTextures.remove(retired.texture->getBindlessIndex());
+            return true;
+        });
+        std::erase_if(m_retiredModels, [this](const RetiredModel &retired) {
+            return m_frame - retired.frame > ODSwapChain::MAX_FRAMES_IN_FLIGHT;
+        });
+    }
+
+    void ODAssetRegistry::streamTextureLevels() {
+        m_textureFeedback.resize(m_textures.slots.size());
+        float initialResolution = static_cast<float>(m_streamer.getInitialTextureResolution());
+
+        // Level each resident texture should start at: what its requests of the last frames
+        // need, its initial levels once nothing requested it for a while
+        struct Residency {
+            uint32_t index;
+            uint32_t firstLevel;
+            uint32_t wantedLevel;
+            uint64_t requestFrame;
+        };
+        std::vector<Residency> missing;
+        std::vector<Residency> trimmable;
+        for (uint32_t index = 0; index < m_textures.slots.size(); index++) {
+            const auto &slot = m_textures.slots[index];
+            if (slot.asset == nullptr || slot.asset->getSource().levels.empty()) {
+                continue;
+            }
+            const TextureFeedback &feedback = m_textureFeedback[index];
+            bool requested = feedback.frame > 0 && m_frame - feedback.frame <= TEXTURE_FEEDBACK_FRAMES;
+            Residency residency{index, slot.asset->getFirstLevel(),
+                ODTextureHandler::getLevelForResolution(slot.asset->getSource(),
+                    requested ? feedback.pixels : initialResolution),
+                feedback.frame};
+            if (residency.wantedLevel < residency.firstLevel) {
+                missing.push_back(residency);
+            } else if (residency.wantedLevel > residency.firstLevel) {
+                trimmable.push_back(residency);
+            }
+        }
+        // most missing detail first, the least recently requested give their levels back first
+        std::sort(missing.begin(), missing.end(), [](const Residency &a, const Residency &b) {
+            return a.firstLevel - a.wantedLevel > b.firstLevel - b.wantedLevel;
+        });
+        std::sort(trimmable.begin(), trimmable.end(),
+            [](const Residency &a, const Residency &b) { return a.requestFrame < b.requestFrame; });
+
+        size_t nextTrim = 0;
+        auto trimUntil = [&](uint64_t residentBytes) {
+            while (getResidentBytes() > residentBytes && nextTrim < trimmable.size()) {
+                const Residency &trim = trimmable[nextTrim++];
+                setTextureFirstLevel(trim.index, trim.wantedLevel);
+            }
+            return getResidentBytes() <= residentBytes;
+        };
+
+        // stream-in uploads get a budget of the streamer's size, one texture always goes
+        uint64_t bytesPerFrame = m_streamer.getBytesPerFrame();
+        uint64_t uploaded = 0;
+        for (const Residency &texture : missing) {
+            const auto &slot = m_textures.slots[texture.index];
+            const ODTextureHandler::Image &source = slot.asset->getSource();
+            auto residentSize = [&source](uint32_t firstLevel) {
+                uint64_t size = 0;
+                for (uint32_t level = firstLevel; level < source.levels.size(); level++) {
+                    size += source.levels[level].size;
+                }
+                return size;
+            };
+            // fewer new levels at once when all of them do not fit this frame
+            uint32_t level = texture.wantedLevel;
+            while (level + 1 < texture.firstLevel && uploaded + residentSize(level) > bytesPerFrame) {
+                level++;
+            }
+            uint64_t size = residentSize(level);
+            if (uploaded > 0 && uploaded + size > bytesPerFrame) {
+                break;
+            }
+            uint64_t growth = size - slot.bytes;
+            if (growth > m_memoryBudget || !trimUntil(m_memoryBudget - growth)) {
+                break;
+            }
+            if (setTextureFirstLevel(texture.index, level)) {
+                uploaded += size;
+            }
+        }
+        // models or new textures may have gone over the budget too
+        trimUntil(m_memoryBudget);
+    }
+
+    bool ODAssetRegistry::setTextureFirstLevel(uint32_t index, uint32_t firstLevel) {
+        auto &slot = m_textures.slots[index];
+        if (m_bindlessTextures.getTextureCount() >= m_bindlessTextures.getCapacity()) {
+            return false;
+        }
+        auto texture = std::make_unique<ODTextureHandler>(m_device);
+        try {
+            texture->addTexture(slot.asset->getSource(), firstLevel);
+        } catch (const std::exception &e) {
+            std::cerr << "failed to stream texture " << slot.key << ": " << e.what() << std::endl;
+            return false;
+        }
+        texture->setBindlessIndex(m_bindlessTextures.add(texture->descriptorInfo()));
+
+        m_textures.residentBytes = m_textures.residentBytes - slot.bytes + texture->getMemorySize();
+        slot.bytes = texture->getMemorySize();
+        // frames in flight still sample the previous one through its bindless element
+        m_retiredTextures.push_back({m_frame, std::move(slot.asset)});
+        slot.asset = std::move(texture);
+        // aliases resolve to the owner's texture
+        for (uint32_t other = 0; other < m_textures.slots.size(); other++) {
+            if (other == index || m_textures.slots[other].aliasOf == index) {
+                m_textures.assets[other] = slot.asset.get();
+            }
+        }
+        return true;
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    ODAssetHandle<T> ODAssetRegistry::acquire(Pool<T, Key, KeyHash> &pool, const Key &key, bool &created) {
+        auto it = pool.byKey.find(key);
+        if (it != pool.byKey.end()) {
+            ODAssetHandle<T> handle{it->second, pool.generations[it->second]};
+            retain(pool, handle);
+            created = false;
+            return handle;
+        }
+
+        uint32_t index;
+        if (!pool.freeSlots.empty()) {
+            index = pool.freeSlots.back();
+            pool.freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(pool.slots.size());
+            pool.slots.emplace_back();
+            pool.generations.push_back(0);
+            pool.assets.push_back(nullptr);
+        }
+        auto &slot = pool.slots[index];
+        slot.key = key;
+        slot.refCount = 1;
+        pool.byKey.emplace(key, index);
+        created = true;
+        return {index, pool.generations[index]};
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    void ODAssetRegistry::retain(Pool<T, Key, KeyHash> &pool, ODAssetHandle<T> handle) {
+        if (!isLive(pool, handle)) {
+            throw std::runtime_error("retaining a stale asset handle!");
+        }
+        pool.slots[handle.index].refCount++;
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    void ODAssetRegistry::release(Pool<T, Key, KeyHash> &pool, ODAssetHandle<T> handle) {
+        if (!isLive(pool, handle)) {
+            return;
+        }
+        auto &slot = pool.slots[handle.index];
+        assert(slot.refCount > 0 && "asset released more times than retained");
+        if (--slot.refCount == 0) {
+            slot.releasedFrame = m_frame;
+        }
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    void ODAssetRegistry::complete(Pool<T, Key, KeyHash> &pool, uint32_t index, ODStreamResult<T> &result) {
+        if constexpr (std::is_same_v<T, ODTextureHandler>) {
+            if (result.asset != nullptr) {
+                try {
+                    result.asset->setBindlessIndex(m_bindlessTextures.add(result.asset->descriptorInfo()));
+                } catch (const std::exception &e) {
+                    result.error = e.what();
+                    result.asset.reset();
+                    std::cerr << "failed to load texture " << result.path << ": " << e.what() << std::endl;
+                }
+            }
+        }
+
+        auto &slot = pool.slots[index];
+        slot.contentHash = result.contentHash;
+        auto owner = pool.byContent.find(result.contentHash);
+        if (result.duplicate && owner != pool.byContent.end()) {
+            // the owner stays resident as long as this path is cached
+            slot.aliasOf = owner->second;
+            pool.slots[owner->second].refCount++;
+            pool.assets[index] = pool.assets[owner->second];
+            slot.state = State::Resident;
+        } else if (result.asset != nullptr) {
+            slot.asset = std::move(result.asset);
+            slot.bytes = result.bytes;
+            pool.assets[index] = slot.asset.get();
+            pool.residentBytes += slot.bytes;
+            if (result.contentHash != 0 && owner == pool.byContent.end()) {
+                pool.byContent.emplace(result.contentHash, index);
+            }
+            slot.state = State::Resident;
+        } else {
+            slot.state = State::Failed;
+        }
+        // a release during the load counts from now, the asset was never drawn
+        slot.releasedFrame = m_frame;
+
+        // callbacks may load more assets and grow the pool, slot is not used past here
+        ODAssetHandle<T> handle{index, pool.generations[index]};
+        State state = slot.state;
+        std::vector<typename Pool<T, Key, KeyHash>::Callback> waiting = std::move(slot.waiting);
+        for (auto &onDone : waiting) {
+            onDone(handle, state);
+        }
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    void ODAssetRegistry::evict(Pool<T, Key, KeyHash> &pool, uint32_t index) {
+        auto &slot = pool.slots[index];
+        if (slot.aliasOf != NO_SLOT) {
+            release(pool, ODAssetHandle<T>{slot.aliasOf, pool.generations[slot.aliasOf]});
+        } else {
+            pool.residentBytes -= slot.bytes;
+            if constexpr (std::is_same_v<T, ODModel>) {
+                // the frames recorded before the eviction may still draw it
+                if (slot.asset != nullptr) {
+                    m_retiredModels.push_back({m_frame, std::move(slot.asset)});
+                }
+            }
+            if constexpr (std::is_same_v<T, ODTextureHandler>) {
+                // its bindless element stays allocated too: an add() reusing it would rewrite what
+                // the frames in flight sample through their textureIndex
+                if (slot.asset != nullptr) {
+                    m_retiredTextures.push_back({m_frame, std::move(slot.asset)});
+                }
+                if (index < m_textureFeedback.size()) {
+                    m_textureFeedback[index] = {};
+                }
+            }
+            auto owner = pool.byContent.find(slot.contentHash);
+            if (owner != pool.byContent.end() && owner->second == index) {
+                pool.byContent.erase(owner);
+            }
+        }
+        pool.byKey.erase(slot.key);
+
+        // handles still pointing here no longer resolve
+        pool.generations[index]++;
+        pool.assets[index] = nullptr;
+        slot = {};
+        pool.freeSlots.push_back(index);
+    }
+
+    template<typename T, typename Key, typename KeyHash>
+    void ODAssetRegistry::whenDone(Pool<T, Key, KeyHash> &pool, ODAssetHandle<T> handle,
+        std::function<void(ODAssetHandle<T>, State)> onDone) {
+        if (!onDone) {
+            return;
+        }
+        auto &slot = pool.slots[handle.index];
+        if (slot.state == State::Loading) {
+            slot.waiting.push_back(std::move(onDone));
+        } else {
+            State state = slot.state;
+            onDone(handle, state);
+        }
+    }
+
+    void ODAssetRegistry::createPlaceholderModel() {
+        // unit cube, one quad per face so every face gets its own normal
+        const glm::vec3 color{.8f, .8f, .8f};
+        const glm::vec3 normals[] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+        ODModel::Builder builder{};
+        for (const glm::vec3 &normal : normals) {
+            // two axes spanning the face
+            glm::vec3 u = glm::abs(normal.x) > 0.f ? glm::vec3{0, 1, 0} : glm::vec3{1, 0, 0};
+            glm::vec3 v = glm::cross(normal, u);
+            uint32_t first = static_cast<uint32_t>(builder.vertices.size());
+            const glm::vec2 corners[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+            for (const glm::vec2 &corner : corners) {
+                ODModel::Vertex vertex{};
+                vertex.position = 0.5f * (normal + corner.x * u + corner.y * v);
+                vertex.color = color;
+                vertex.normal = normal;
+                vertex.uv = 0.5f * (corner + glm::vec2{1.f});
+                builder.vertices.push_back(vertex);
+            }
+            for (uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u}) {
+                builder.indices.push_back(first + index);
+            }
+        }
+        m_placeholder = std::make_unique<ODModel>(m_device, builder);
+    }
+    template<typename T>
+    ODAssetRef<T>::ODAssetRef(ODAssetRegistry &registry, ODAssetHandle<T> handle) {
+        reset(registry, handle);
+    }
+
+    template<typename T>
+    ODAssetRef<T>::~ODAssetRef() {
+        reset();
+    }
+
+    template<typename T>
+    ODAssetRef<T>::ODAssetRef(const ODAssetRef &other) {
+        if (other.m_registry != nullptr) {
+            reset(*other.m_registry, other.m_handle);
+        }
+    }
+
+    template<typename T>
+    ODAssetRef<T> &ODAssetRef<T>::operator=(const ODAssetRef &other) {
+        if (other.m_registry == nullptr) {
+            reset();
+        } else {
+            reset(*other.m_registry, other.m_handle);
+        }
+        return *this;
+    }
+
+    template<typename T>
+    ODAssetRef<T>::ODAssetRef(ODAssetRef &&other) noexcept
+        : m_registry(std::exchange(other.m_registry, nullptr)), m_handle(std::exchange(other.m_handle, {})) {}
+
+    template<typename T>
+    ODAssetRef<T> &ODAssetRef<T>::operator=(ODAssetRef &&other) noexcept {
+        if (this != &other) {
+            reset();
+            m_registry = std::exchange(other.m_registry, nullptr);
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    template<typename T>
+    void ODAssetRef<T>::reset(ODAssetRegistry &registry, ODAssetHandle<T> handle) {
+        // retained first, the same handle may be assigned again
+        if (handle.isValid()) {
+            registry.retain(handle);
+        }
+        reset();
+        if (handle.isValid()) {
+            m_registry = &registry;
+            m_handle = handle;
+        }
+    }
+
+    template<typename T>
+    void ODAssetRef<T>::reset() {
+        if (m_registry != nullptr) {
+            m_registry->release(m_handle);
+        }
+        m_registry = nullptr;
+        m_handle = {};
+    }
+
+    template class ODAssetRef<ODModel>;
+    template class ODAssetRef<ODTextureHandler>;
+    template class ODAssetRef<ODSampler>;
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "ODAssetHandle.h"
+#include "ODAssetStreamer.h"
+#include "ODModel.h"
+#include "ODTextureHandler.h"
+#include "../Vulkan/ODBindlessTextures.h"
+#include "../Vulkan/ODDevice.h"
+#include "../Vulkan/ODSampler.h"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ODEngine {
+
+    /*
+     * Owner of every model, texture and sampler, handed out as ODAssetHandles.
+     *
+     *  - Loads are keyed by canonical path (plus the compression settings for models): asking
+     *    for a file already loaded or loading returns the same handle, nothing is read twice.
+     *  - Once imported, an asset whose source bytes hash like a resident one (a copy of a file
+     *    under another path) skips its upload and resolves to the resident asset.
+     *  - References are counted explicitly with retain/release, every load* returning a handle
+     *    that holds one, or owned by an ODAssetRef (game objects hold theirs that way).
+     *    Unreferenced assets stay cached until the resident bytes go over the memory budget,
+     *    then the least recently released go first. An evicted asset may still be drawn by the
+     *    frames in flight: its handles stop resolving right away, but the asset itself is
+     *    destroyed MAX_FRAMES_IN_FLIGHT frames later.
+     *  - Handles resolve in O(1): the generation and asset pointer of each slot live in dense
+     *    arrays indexed by the handle, a stale handle resolves to nullptr.
+     *  - Resident textures get an element of the bindless texture array, shaders select them
+     *    by the index getTextureIndex returns.
+     *  - Textures become resident with their small mips only (see ODAssetStreamer). Renderers
+     *    report each frame how many pixels the textured objects cover with
+     *    requestTextureResolution, the registry then streams the finer levels in, and gives
+     *    back the finest levels of the textures not requested lately when over the memory
+     *    budget. A residency change recreates the GPU texture with the new levels (the
+     *    previous one is kept for the frames in flight), so the ODTextureHandler a handle
+     *    resolves to changes: resolve it every frame.
+     *
+     * Main thread only, including the reference counts.
+     */
+    class ODAssetRegistry {
+        public:
+            enum class State { Loading, Resident, Failed };
+            enum class LoadMode {
+                // imported on the streamer's workers, uploaded under its frame budget
+                Async,
+                // imported and uploaded before returning (a path already streaming stays Loading)
+                Blocking
+            };
+
+            static constexpr uint64_t DEFAULT_MEMORY_BUDGET = 512ull * 1024 * 1024;
+            // a texture not requested for that many frames keeps only its initial levels when
+            // memory runs out
+            static constexpr uint64_t TEXTURE_FEEDBACK_FRAMES = 60;
+
+            // runs on the main thread once the asset is resident or failed, right away when it
+            // already is
+            using ModelCallback = std::function<void(ODModelHandle, State)>;
+            using TextureCallback = std::function<void(ODTextureHandle, State)>;
+
+            ODAssetRegistry(ODDevice& device, uint64_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+            ~ODAssetRegistry();
+
+            ODAssetRegistry(const ODAssetRegistry&) = delete;
+            ODAssetRegistry& operator=(const ODAssetRegistry&) = delete;
+
+            ODModelHandle loadModel(const std::string& filepath, const ODVertexCompressionSettings& compression = {},
+                LoadMode mode = LoadMode::Async, ModelCallback onDone = {});
+            ODTextureHandle loadTexture(const std::string& filepath, LoadMode mode = LoadMode::Async,
+                TextureCallback onDone = {});
+            // Several textures at once, handles in the order of filepaths. Blocking decodes every
+            // new file concurrently on the streamer's texture workers, then records all the
+            // uploads into the same ODUploadQueue batch. onDone runs once per texture.
+            std::vector<ODTextureHandle> loadTextures(const std::vector<std::string>& filepaths,
+                LoadMode mode = LoadMode::Async, TextureCallback onDone = {});
+            // Uploads a model built in memory (one primitive of a glTF scene...) under name, or
+            // returns the one already registered under it
+            ODModelHandle addModel(const std::string& name, const ODModel::Builder& builder,
+                const ODVertexCompressionSettings& compression = {});
+            // Decodes an encoded image in memory (a texture embedded in a glTF scene...) to the
+            // texture format and uploads it under name, or returns the one registered under it.
+            // Bytes matching a resident texture resolve to it like a copied file.
+            ODTextureHandle addTexture(const std::string& name, const uint8_t* encoded, size_t size);
+            // one VkSampler per distinct settings
+            ODSamplerHandle loadSampler(const ODSamplerSettings& settings = {});
+
+            // one more reference, for each game object or material sharing the handle
+            void retain(ODModelHandle handle);
+            void retain(ODTextureHandle handle);
+            void retain(ODSamplerHandle handle);
+            void release(ODModelHandle handle);
+            void release(ODTextureHandle handle);
+            void release(ODSamplerHandle handle);
+
+            // the placeholder while loading, nullptr once failed or for a stale handle
+            ODModel* getModel(ODModelHandle handle) const {
+                ODModel* model = resolve(m_models, handle);
+                return model != nullptr || getState(handle) != State::Loading ? model : m_placeholder.get();
+            }
+            // nullptr until resident
+            ODTextureHandler* getTexture(ODTextureHandle handle) const { return resolve(m_textures, handle); }
+            ODSampler* getSampler(ODSamplerHandle handle) const { return resolve(m_samplers, handle); }
+            // element of the bindless texture array, ODBindlessTextures::DEFAULT_TEXTURE until
+            // resident (and for a stale or empty handle)
+            uint32_t getTextureIndex(ODTextureHandle handle) const {
+                ODTextureHandler* texture = resolve(m_textures, handle);
+                return texture != nullptr ? texture->getBindlessIndex() : ODBindlessTextures::DEFAULT_TEXTURE;
+            }
+
+            // An object sampling handle covers about pixels screen pixels on its largest side
+            // this frame. Several requests in one frame keep the largest.
+            void requestTextureResolution(ODTextureHandle handle, float pixels);
+
+            // Failed for a stale handle
+            State getState(ODModelHandle handle) const { return getState(m_models, handle); }
+            State getState(ODTextureHandle handle) const { return getState(m_textures, handle); }
+
+            // Creates the GPU resources of finished loads, evicts unreferenced assets over the
+            // budget and streams texture levels from the requests. Call once per frame before
+            // ODUploadQueue::flush().
+            void update();
+
+            void setMemoryBudget(uint64_t memoryBudget) { m_memoryBudget = memoryBudget; }
+            // Format textures loaded from now on are imported to, ODTextureHandler::chooseFormat
+            // (block compressed when the device samples BC) by default
+            void setTextureFormat(VkFormat format) { m_textureFormat = format; }
+            VkFormat getTextureFormat() const { return m_textureFormat; }
+            // GPU bytes of the resident models and textures, referenced or not
+            uint64_t getResidentBytes() const { return m_models.residentBytes + m_textures.residentBytes; }
+            ODAssetStreamer& getStreamer() { return m_streamer; }
+            ODBindlessTextures& getBindlessTextures() { return m_bindlessTextures; }
+            const ODBindlessTextures& getBindlessTextures() const { return m_bindlessTextures; }
+            // unit cube drawn in place of models still loading, nullptr skips those objects instead
+            void setPlaceholderModel(std::unique_ptr<ODModel> model) { m_placeholder = std::move(model); }
+
+            // key of a file, names of sub-assets given to addModel start with it
+            static std::string canonicalPath(const std::string& filepath);
+
+        private:
+            static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+            template<typename T, typename Key, typename KeyHash = std::hash<Key>>
+            struct Pool {
+                using Callback = std::function<void(ODAssetHandle<T>, State)>;
+
+                struct Slot {
+                    std::unique_ptr<T> asset;
+                    State state = State::Loading;
+                    uint32_t refCount = 0;
+                    Key key{};
+                    uint64_t contentHash = 0;
+                    uint64_t bytes = 0;
+                    // registry frame of the last release, eviction waits for the frames in flight
+                    uint64_t releasedFrame = 0;
+                    // slot owning the asset when the content matched another path
+                    uint32_t aliasOf = NO_SLOT;
+                    std::vector<Callback> waiting;
+                };
+
+                // dense per slot arrays, what resolving a handle touches
+                std::vector<uint32_t> generations;
+                std::vector<T*> assets;
+
+                std::vector<Slot> slots;
+                std::vector<uint32_t> freeSlots;
+                std::unordered_map<Key, uint32_t, KeyHash> byKey;
+                // content hash -> slot owning the resident asset
+                std::unordered_map<uint64_t, uint32_t> byContent;
+                uint64_t residentBytes = 0;
+            };
+
+            using ModelPool = Pool<ODModel, std::string>;
+            using TexturePool = Pool<ODTextureHandler, std::string>;
+            using SamplerPool = Pool<ODSampler, ODSamplerSettings, ODSamplerSettingsHash>;
+
+            template<typename T, typename Key, typename KeyHash>
+            static bool isLive(const Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle) {
+                return handle.index < pool.generations.size() && pool.generations[handle.index] == handle.generation;
+            }
+
+            template<typename T, typename Key, typename KeyHash>
+            static T* resolve(const Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle) {
+                return isLive(pool, handle) ? pool.assets[handle.index] : nullptr;
+            }
+
+            template<typename T, typename Key, typename KeyHash>
+            static State getState(const Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle) {
+                return isLive(pool, handle) ? pool.slots[handle.index].state : State::Failed;
+            }
+
+            // handle of key with one more reference, created set to Loading when new
+            template<typename T, typename Key, typename KeyHash>
+            ODAssetHandle<T> acquire(Pool<T, Key, KeyHash>& pool, const Key& key, bool& created);
+            template<typename T, typename Key, typename KeyHash>
+            void retain(Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle);
+            template<typename T, typename Key, typename KeyHash>
+            void release(Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle);
+            template<typename T, typename Key, typename KeyHash>
+            void complete(Pool<T, Key, KeyHash>& pool, uint32_t index, ODStreamResult<T>& result);
+            template<typename T, typename Key, typename KeyHash>
+            void evict(Pool<T, Key, KeyHash>& pool, uint32_t index);
+            template<typename T, typename Key, typename KeyHash>
+            void whenDone(Pool<T, Key, KeyHash>& pool, ODAssetHandle<T> handle,
+                std::function<void(ODAssetHandle<T>, State)> onDone);
+
+            void evictUnreferenced();
+            // destroys the retired assets no frame in flight uses anymore
+            void releaseRetiredAssets();
+            // stream finer levels in for the requests of the last frames, within the budgets
+            void streamTextureLevels();
+            // recreates the texture of slot index starting at firstLevel, false when it failed
+            bool setTextureFirstLevel(uint32_t index, uint32_t firstLevel);
+            void createPlaceholderModel();
+
+            ODDevice& m_device;
+            uint64_t m_memoryBudget;
+            uint64_t m_frame = 0;
+            VkFormat m_textureFormat;
+            ODBindlessTextures m_bindlessTextures;
+
+            ModelPool m_models;
+            TexturePool m_textures;
+            SamplerPool m_samplers;
+            std::unique_ptr<ODModel> m_placeholder;
+
+            // streaming feedback per texture slot
+            struct TextureFeedback {
+                uint64_t frame = 0;
+                float pixels = 0.f;
+            };
+            std::vector<TextureFeedback> m_textureFeedback;
+            // textures replaced by a residency change or evicted, destroyed (and their bindless
+            // element freed) once no frame samples them
+            struct RetiredTexture {
+                uint64_t frame;
+                std::unique_ptr<ODTextureHandler> texture;
+            };
+            std::vector<RetiredTexture> m_retiredTextures;
+            // evicted models, their geometry pool ranges are only given back once no frame
+            // draws them
+            struct RetiredModel {
+                uint64_t frame;
+                std::unique_ptr<ODModel> model;
+            };
+            std::vector<RetiredModel> m_retiredModels;
+
+            // last, so its workers stop before the pools their callbacks fill go away
+            ODAssetStreamer m_streamer;
+    };
+}
@@ -0,0 +1,172 @@
+#include "ODAssetStreamer.h"
+#include "ODMeshCache.h"
+#include "Utils/ODMappedFile.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+namespace ODEngine {
+
+    namespace {
+        template<typename T>
+        bool isReady(const std::future<T>& future) {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // get() consumes the result, hands it back for the next frame
+        template<typename T>
+        void defer(std::future<T>& future, T value) {
+            std::promise<T> deferred;
+            deferred.set_value(std::move(value));
+            future = deferred.get_future();
+        }
+    }
+
+    ODAssetStreamer::ODAssetStreamer(ODDevice &device, uint64_t bytesPerFrame, uint32_t workerCount,
+        uint32_t textureWorkerCount)
+        : m_device(device), m_workers(workerCount), m_textureWorkers(std::max(textureWorkerCount, 1u)),
+          m_bytesPerFrame(bytesPerFrame) {}
+
+    // the worker pools finish the imports already queued before they are destroyed
+    ODAssetStreamer::~ODAssetStreamer() = default;
+
+    uint64_t ODAssetStreamer::hashFile(const std::string &filepath) {
+        ODMappedFile file;
+        if (!file.open(filepath)) {
+            return 0;
+        }
+        return ODMeshCache::hashBytes(file.data(), file.size());
+    }
+
+    uint64_t ODAssetStreamer::hashModel(const std::string &filepath, const ODVertexCompressionSettings &compression) {
+        uint64_t hash = hashFile(filepath);
+        if (hash == 0 || !compression.enabled) {
+            return hash;
+        }
+        const float tolerances[] = {compression.maxPositionError, compression.maxNormalErrorDegrees,
+            compression.maxUvError, compression.maxColorError};
+        return ODMeshCache::hashBytes(tolerances, sizeof(tolerances), hash);
+    }
+
+    void ODAssetStreamer::loadModel(const std::string &filepath, const ODVertexCompressionSettings &compression,
+        ModelCallback onDone) {
+        auto model = m_workers.submit([filepath, compression]() {
+            ImportedModel imported{{}, hashModel(filepath, compression)};
+            if (!imported.builder.loadCache(filepath)) {
+                imported.builder.importFile(filepath);
+            }
+            return imported;
+        });
+        m_pendingModels.push_back({filepath, compression, std::move(model), std::move(onDone)});
+    }
+
+    uint32_t ODAssetStreamer::getDefaultTextureWorkerCount() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    void ODAssetStreamer::loadTexture(const std::string &filepath, VkFormat format, TextureCallback onDone) {
+        m_pendingTextures.push_back({filepath, decodeTexture(filepath, format), std::move(onDone)});
+    }
+
+    std::future<ODAssetStreamer::DecodedTexture> ODAssetStreamer::decodeTexture(const std::string &filepath,
+        VkFormat format) {
+        return m_textureWorkers.submit([filepath, format]() {
+            return DecodedTexture{ODTextureHandler::decode(filepath, format), hashFile(filepath)};
+        });
+    }
+
+    void ODAssetStreamer::update() {
+        // oldest requests first, an asset over the budget waits for the next frame
+        uint64_t bytes = 0;
+        for (auto it = m_pendingModels.begin(); it != m_pendingModels.end();) {
+            if (!isReady(it->model)) {
+                ++it;
+                continue;
+            }
+            if (!finishModel(*it, bytes)) {
+                break;
+            }
+            it = m_pendingModels.erase(it);
+        }
+        for (auto it = m_pendingTextures.begin(); it != m_pendingTextures.end();) {
+            if (!isReady(it->texture)) {
+                ++it;
+                continue;
+            }
+            if (!finishTexture(*it, bytes)) {
+                break;
+            }
+            it = m_pendingTextures.erase(it);
+        }
+    }
+
+    bool ODAssetStreamer::finishModel(PendingModel &pending, uint64_t &bytes) {
+        ODStreamResult<ODModel> result{};
+        result.path = pending.path;
+        try {
+            ImportedModel imported = pending.model.get();
+            result.contentHash = imported.contentHash;
+            if (m_isModelResident && imported.contentHash != 0 && m_isModelResident(imported.contentHash)) {
+                result.duplicate = true;
+            } else {
+                const ODModel::Builder &builder = imported.builder;
+                uint64_t size = sizeof(ODModel::Vertex) * uint64_t{builder.vertices.size()} +
+                    sizeof(uint32_t) * uint64_t{builder.indices.size()};
+                if (bytes > 0 && bytes + size > m_bytesPerFrame) {
+                    defer(pending.model, std::move(imported));
+                    return false;
+                }
+                result.asset = std::make_unique<ODModel>(m_device, builder, pending.compression);
+                result.bytes = result.asset->getMemorySize();
+                bytes += size;
+            }
+        } catch (const std::exception &e) {
+            result.error = e.what();
+            std::cerr << "failed to load model " << pending.path << ": " << e.what() << std::endl;
+        }
+        if (pending.onDone) {
+            pending.onDone(result);
+        }
+        return true;
+    }
+
+    bool ODAssetStreamer::finishTexture(PendingTexture &pending, uint64_t &bytes) {
+        ODStreamResult<ODTextureHandler> result{};
+        result.path = pending.path;
+        try {
+            DecodedTexture decoded = pending.texture.get();
+            result.contentHash = decoded.contentHash;
+            if (m_isTextureResident && decoded.contentHash != 0 && m_isTextureResident(decoded.contentHash)) {
+                result.duplicate = true;
+            } else {
+                const ODTextureHandler::Image &image = decoded.image;
+                uint32_t firstLevel = ODTextureHandler::getLevelForResolution(image,
+                    static_cast<float>(m_initialTextureResolution));
+                uint64_t size = 0;
+                for (uint32_t level = firstLevel; level < image.levels.size(); level++) {
+                    size += image.levels[level].size;
+                }
+                if (bytes > 0 && bytes + size > m_bytesPerFrame) {
+                    defer(pending.texture, std::move(decoded));
+                    return false;
+                }
+                auto texture = std::make_unique<ODTextureHandler>(m_device);
+                texture->addTexture(image, firstLevel);
+                result.bytes = texture->getMemorySize();
+                result.asset = std::move(texture);
+                bytes += size;
+            }
+        } catch (const std::exception &e) {
+            result.error = e.what();
+            std::cerr << "failed to load texture " << pending.path << ": " << e.what() << std::endl;
+        }
+        if (pending.onDone) {
+            pending.onDone(result);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "ODModel.h"
+#include "ODTextureHandler.h"
+#include "../Vulkan/ODDevice.h"
+#include "Utils/ODThreadPool.h"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+
+namespace ODEngine {
+
+    // Outcome of one ODAssetStreamer load, handed to its callback on the main thread
+    template<typename T>
+    struct ODStreamResult {
+        std::string path;
+        // nullptr when the load failed or was a duplicate
+        std::unique_ptr<T> asset;
+        // hash of the source file bytes, and of the compression settings for models
+        uint64_t contentHash = 0;
+        // GPU memory held by asset
+        uint64_t bytes = 0;
+        // the content hash was already resident, nothing was uploaded
+        bool duplicate = false;
+        // exception message when the load failed
+        std::string error;
+    };
+
+    /*
+     * Background model and texture loading. OBJ import (or .odmesh cache reads) and image
+     * decoding (or .ktx2 cache reads), with their source file hashing, run on the streamer's
+     * worker threads: a few for models, one per hardware thread for textures since stb_image
+     * decodes an image on a single core. update() then creates the GPU resources on the main thread, at most
+     * bytesPerFrame of vertex, index and pixel data per call (one asset always goes through, so one bigger than the budget still
+     * loads). The uploads land in the device's ODUploadQueue and go out with its next flush().
+     *
+     * Textures only upload their levels up to the initial texture resolution, so they are
+     * usable after a small copy; ODAssetRegistry streams the finer levels in on demand.
+     *
+     * ODAssetRegistry drives it, game code goes through the registry's handles.
+     */
+    class ODAssetStreamer {
+        public:
+            static constexpr uint64_t DEFAULT_BYTES_PER_FRAME = 8ull * 1024 * 1024;
+            // import workers, each import also spreads its vertex dedup over ODThreadPool::shared()
+            static constexpr uint32_t DEFAULT_WORKER_COUNT = 2;
+            // one per hardware thread
+            static uint32_t getDefaultTextureWorkerCount();
+            // texels on the largest side of the first level textures upload
+            static constexpr uint32_t DEFAULT_INITIAL_TEXTURE_RESOLUTION = 64;
+
+            using ModelCallback = std::function<void(ODStreamResult<ODModel>&)>;
+            using TextureCallback = std::function<void(ODStreamResult<ODTextureHandler>&)>;
+            // true when an asset with this content hash is resident already
+            using ResidentCheck = std::function<bool(uint64_t contentHash)>;
+
+            struct DecodedTexture {
+                ODTextureHandler::Image image;
+                uint64_t contentHash;
+            };
+
+            // workerCount model imports and textureWorkerCount texture decodes run at once
+            ODAssetStreamer(ODDevice& device, uint64_t bytesPerFrame = DEFAULT_BYTES_PER_FRAME,
+                uint32_t workerCount = DEFAULT_WORKER_COUNT,
+                uint32_t textureWorkerCount = getDefaultTextureWorkerCount());
+            ~ODAssetStreamer();
+
+            ODAssetStreamer(const ODAssetStreamer&) = delete;
+            ODAssetStreamer& operator=(const ODAssetStreamer&) = delete;
+
+            // onDone runs on the main thread from update(), once uploaded, failed or skipped
+            void loadModel(const std::string& filepath, const ODVertexCompressionSettings& compression,
+                ModelCallback onDone);
+            // imported to format, see ODTextureHandler::decode
+            void loadTexture(const std::string& filepath, VkFormat format, TextureCallback onDone);
+            // Decodes and hashes on the texture workers without creating anything, for callers
+            // uploading themselves (the registry's blocking batches)
+            std::future<DecodedTexture> decodeTexture(const std::string& filepath, VkFormat format);
+
+            // Creates the GPU resources of finished loads within the frame budget. Call once per
+            // frame before ODUploadQueue::flush().
+            void update();
+
+            // Loads whose content hash passes the check skip their upload (and the budget)
+            void setModelResidentCheck(ResidentCheck check) { m_isModelResident = std::move(check); }
+            void setTextureResidentCheck(ResidentCheck check) { m_isTextureResident = std::move(check); }
+            void setBytesPerFrame(uint64_t bytesPerFrame) { m_bytesPerFrame = bytesPerFrame; }
+            uint64_t getBytesPerFrame() const { return m_bytesPerFrame; }
+            void setInitialTextureResolution(uint32_t texels) { m_initialTextureResolution = texels; }
+            uint32_t getInitialTextureResolution() const { return m_initialTextureResolution; }
+            // loads not uploaded (or failed) yet
+            size_t getPendingCount() const { return m_pendingModels.size() + m_pendingTextures.size(); }
+
+            // 0 when the file cannot be read
+            static uint64_t hashFile(const std::string& filepath);
+            // the same OBJ imported with other compression settings is other GPU data
+            static uint64_t hashModel(const std::string& filepath, const ODVertexCompressionSettings& compression);
+
+        private:
+            struct ImportedModel {
+                ODModel::Builder builder;
+                uint64_t contentHash;
+            };
+
+            struct PendingModel {
+                std::string path;
+                ODVertexCompressionSettings compression;
+                std::future<ImportedModel> model;
+                ModelCallback onDone;
+            };
+
+            struct PendingTexture {
+                std::string path;
+                std::future<DecodedTexture> texture;
+                TextureCallback onDone;
+            };
+
+            // false when the budget is spent
+            bool finishModel(PendingModel& pending, uint64_t& bytes);
+            bool finishTexture(PendingTexture& pending, uint64_t& bytes);
+
+            ODDevice& m_device;
+            ODThreadPool m_workers;
+            // decodes call ODThreadPool::shared() for their mips and block compression, they
+            // must not run on the shared pool itself
+            ODThreadPool m_textureWorkers;
+            uint64_t m_bytesPerFrame;
+            uint32_t m_initialTextureResolution = DEFAULT_INITIAL_TEXTURE_RESOLUTION;
+            std::list<PendingModel> m_pendingModels;
+            std::list<PendingTexture> m_pendingTextures;
+            ResidentCheck m_isModelResident;
+            ResidentCheck m_isTextureResident;
+    };
+}
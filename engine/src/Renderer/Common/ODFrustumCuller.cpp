@@ -0,0 +1,203 @@
+#include "ODFrustumCuller.h"
+
+#include "Utils/ODThreadPool.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+namespace ODEngine {
+    namespace {
+        size_t roundUpToLanes(size_t count) {
+            return (count + ODFrustumCuller::LANE_COUNT - 1) / ODFrustumCuller::LANE_COUNT * ODFrustumCuller::LANE_COUNT;
+        }
+    }
+
+    void ODFrustumCuller::extractPlanes(const glm::mat4& viewProjection, glm::vec4 (&planes)[6]) {
+        auto row = [&](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+        planes[0] = row(3) + row(0); // left
+        planes[1] = row(3) - row(0); // right
+        planes[2] = row(3) + row(1); // bottom
+        planes[3] = row(3) - row(1); // top
+        planes[4] = row(2);          // near
+        planes[5] = row(3) - row(2); // far
+        for (glm::vec4& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    void ODFrustumCuller::clear() {
+        m_count = 0;
+        for (auto* stream : {&m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ}) {
+            stream->clear();
+        }
+    }
+
+    void ODFrustumCuller::reserve(size_t count) {
+        for (auto* stream : {&m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ}) {
+            stream->reserve(roundUpToLanes(count));
+        }
+    }
+
+    uint32_t ODFrustumCuller::add(const glm::vec3& center, float radius, const glm::vec3& extents) {
+        if (m_count == m_centerX.size()) {
+            // a whole group of lanes at once, zeroed
+            for (auto* stream : {&m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ}) {
+                stream->resize(m_count + LANE_COUNT, 0.f);
+            }
+        }
+        m_centerX[m_count] = center.x;
+        m_centerY[m_count] = center.y;
+        m_centerZ[m_count] = center.z;
+        m_radius[m_count] = radius;
+        m_extentX[m_count] = extents.x;
+        m_extentY[m_count] = extents.y;
+        m_extentZ[m_count] = extents.z;
+        return static_cast<uint32_t>(m_count++);
+    }
+
+    uint32_t ODFrustumCuller::add(const glm::mat4& modelMatrix, const glm::vec3& center, float radius,
+        const glm::vec3& extents) {
+        glm::vec3 axisX{modelMatrix[0]};
+        glm::vec3 axisY{modelMatrix[1]};
+        glm::vec3 axisZ{modelMatrix[2]};
+        float maxScale = std::sqrt(std::max({glm::dot(axisX, axisX), glm::dot(axisY, axisY), glm::dot(axisZ, axisZ)}));
+        // half size of the world box enclosing the transformed one
+        glm::vec3 worldExtents = glm::abs(axisX) * extents.x + glm::abs(axisY) * extents.y + glm::abs(axisZ) * extents.z;
+        return add(glm::vec3(modelMatrix * glm::vec4(center, 1.f)), radius * maxScale, worldExtents);
+    }
+
+    void ODFrustumCuller::cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible, ODThreadPool* pool) {
+        visible.clear();
+        glm::vec4 planes[6];
+        extractPlanes(viewProjection, planes);
+
+        size_t taskCount = (m_count + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK;
+        if (pool != nullptr) {
+            taskCount = std::min<size_t>(taskCount, pool->getConcurrency());
+        }
+        if (pool == nullptr || taskCount <= 1) {
+            cullRange(planes, 0, m_count, visible);
+            return;
+        }
+
+        // chunks of whole lane groups, each with its own output so no synchronization is needed
+        if (m_chunkVisible.size() < taskCount) {
+            m_chunkVisible.resize(taskCount);
+        }
+        size_t groupCount = roundUpToLanes(m_count) / LANE_COUNT;
+        pool->parallelFor(groupCount, taskCount, [&](size_t chunk, size_t begin, size_t end) {
+            m_chunkVisible[chunk].clear();
+            cullRange(planes, begin * LANE_COUNT, std::min(end * LANE_COUNT, m_count), m_chunkVisible[chunk]);
+        });
+
+        size_t visibleCount = 0;
+        for (size_t chunk = 0; chunk < taskCount; chunk++) {
+            visibleCount += m_chunkVisible[chunk].size();
+        }
+        visible.reserve(visibleCount);
+        for (size_t chunk = 0; chunk < taskCount; chunk++) {
+            visible.insert(visible.end(), m_chunkVisible[chunk].begin(), m_chunkVisible[chunk].end());
+        }
+    }
+
+    void ODFrustumCuller::cullRange(const glm::vec4 (&planes)[6], size_t begin, size_t end,
+        std::vector<uint32_t>& visible) const {
+        // per plane: distance of the center, minus how far the bounds reach along the normal
+#if defined(__AVX__)
+        const __m256 signMask = _mm256_set1_ps(-0.f);
+        for (size_t first = begin; first < end; first += LANE_COUNT) {
+            __m256 centerX = _mm256_loadu_ps(m_centerX.data() + first);
+            __m256 centerY = _mm256_loadu_ps(m_centerY.data() + first);
+            __m256 centerZ = _mm256_loadu_ps(m_centerZ.data() + first);
+            __m256 radius = _mm256_loadu_ps(m_radius.data() + first);
+            __m256 extentX = _mm256_loadu_ps(m_extentX.data() + first);
+            __m256 extentY = _mm256_loadu_ps(m_extentY.data() + first);
+            __m256 extentZ = _mm256_loadu_ps(m_extentZ.data() + first);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : planes) {
+                __m256 normalX = _mm256_set1_ps(plane.x);
+                __m256 normalY = _mm256_set1_ps(plane.y);
+                __m256 normalZ = _mm256_set1_ps(plane.z);
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(normalX, centerX), _mm256_mul_ps(normalY, centerY)),
+                    _mm256_add_ps(_mm256_mul_ps(normalZ, centerZ), _mm256_set1_ps(plane.w)));
+                __m256 boxReach = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, normalX), extentX),
+                        _mm256_mul_ps(_mm256_andnot_ps(signMask, normalY), extentY)),
+                    _mm256_mul_ps(_mm256_andnot_ps(signMask, normalZ), extentZ));
+                __m256 reach = _mm256_min_ps(radius, boxReach);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(inside));
+            while (mask != 0) {
+                size_t index = first + std::countr_zero(mask);
+                if (index >= end) {
+                    break;
+                }
+                visible.push_back(static_cast<uint32_t>(index));
+                mask &= mask - 1;
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        for (size_t first = begin; first < end; first += LANE_COUNT) {
+            __m128 centerX = _mm_loadu_ps(m_centerX.data() + first);
+            __m128 centerY = _mm_loadu_ps(m_centerY.data() + first);
+            __m128 centerZ = _mm_loadu_ps(m_centerZ.data() + first);
+            __m128 radius = _mm_loadu_ps(m_radius.data() + first);
+            __m128 extentX = _mm_loadu_ps(m_extentX.data() + first);
+            __m128 extentY = _mm_loadu_ps(m_extentY.data() + first);
+            __m128 extentZ = _mm_loadu_ps(m_extentZ.data() + first);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& plane : planes) {
+                __m128 normalX = _mm_set1_ps(plane.x);
+                __m128 normalY = _mm_set1_ps(plane.y);
+                __m128 normalZ = _mm_set1_ps(plane.z);
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)),
+                    _mm_add_ps(_mm_mul_ps(normalZ, centerZ), _mm_set1_ps(plane.w)));
+                __m128 boxReach = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, normalX), extentX),
+                        _mm_mul_ps(_mm_andnot_ps(signMask, normalY), extentY)),
+                    _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), extentZ));
+                __m128 reach = _mm_min_ps(radius, boxReach);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+            }
+
+            unsigned mask = static_cast<unsigned>(_mm_movemask_ps(inside));
+            while (mask != 0) {
+                size_t index = first + std::countr_zero(mask);
+                if (index >= end) {
+                    break;
+                }
+                visible.push_back(static_cast<uint32_t>(index));
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (size_t i = begin; i < end; i++) {
+            bool inside = true;
+            for (const glm::vec4& plane : planes) {
+                float distance = plane.x * m_centerX[i] + plane.y * m_centerY[i] + plane.z * m_centerZ[i] + plane.w;
+                float boxReach = std::abs(plane.x) * m_extentX[i] + std::abs(plane.y) * m_extentY[i]
+                    + std::abs(plane.z) * m_extentZ[i];
+                inside = inside && distance + std::min(m_radius[i], boxReach) >= 0.f;
+            }
+            if (inside) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+#endif
+    }
+}
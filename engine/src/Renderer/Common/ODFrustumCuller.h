@@ -0,0 +1,72 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE // -> valeur de profondeur de 0 à 1
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ODEngine {
+    class ODThreadPool;
+
+    /*
+     * CPU frustum culling of world space bounds. Each element is a bounding sphere and the
+     * axis aligned box sharing its center, stored as structure of arrays so a plane is tested
+     * against LANE_COUNT elements at once (AVX when the build enables it, SSE2 otherwise,
+     * scalar on other targets). An element is culled when one plane has it entirely on its
+     * outer side, taking the tighter of the sphere and the box along that plane's normal.
+     *
+     * Sets larger than OBJECTS_PER_TASK are split over the thread pool, the visible indices
+     * come back in increasing order either way.
+     */
+    class ODFrustumCuller {
+        public:
+#if defined(__AVX__)
+            static constexpr size_t LANE_COUNT = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            static constexpr size_t LANE_COUNT = 4;
+#else
+            static constexpr size_t LANE_COUNT = 1;
+#endif
+            // below this many elements per task the thread pool costs more than it saves
+            static constexpr size_t OBJECTS_PER_TASK = 4096;
+
+            // Gribb/Hartmann planes of a depth [0, 1] projection: xyz inward unit normal, w
+            // distance. Left, right, bottom, top, near, far.
+            static void extractPlanes(const glm::mat4& viewProjection, glm::vec4 (&planes)[6]);
+
+            void clear();
+            void reserve(size_t count);
+            // returns the element index, extents being the half size of the box
+            uint32_t add(const glm::vec3& center, float radius, const glm::vec3& extents);
+            // bounds of a model space sphere and box (same center) under modelMatrix
+            uint32_t add(const glm::mat4& modelMatrix, const glm::vec3& center, float radius,
+                const glm::vec3& extents);
+            size_t size() const { return m_count; }
+
+            // Replaces visible with the indices of the elements inside or crossing the frustum.
+            // pool nullptr runs everything on the caller.
+            void cull(const glm::mat4& viewProjection, std::vector<uint32_t>& visible,
+                ODThreadPool* pool);
+
+        private:
+            // elements [begin, end), begin a multiple of LANE_COUNT
+            void cullRange(const glm::vec4 (&planes)[6], size_t begin, size_t end,
+                std::vector<uint32_t>& visible) const;
+
+            // padded to a multiple of LANE_COUNT, the padding never reaches the output
+            std::vector<float> m_centerX;
+            std::vector<float> m_centerY;
+            std::vector<float> m_centerZ;
+            std::vector<float> m_radius;
+            std::vector<float> m_extentX;
+            std::vector<float> m_extentY;
+            std::vector<float> m_extentZ;
+            size_t m_count = 0;
+            std::vector<std::vector<uint32_t>> m_chunkVisible;
+    };
+}
@@ -58,6 +58,29 @@ namespace ODEngine {
             }
         };
     }
+
+    void TransformComponent::setFromMatrix(const glm::mat4& matrix){
+        translation = glm::vec3(matrix[3]);
+        scale = {glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))};
+        // a mirrored basis goes in the x scale
+        if(glm::dot(glm::cross(glm::vec3(matrix[0]), glm::vec3(matrix[1])), glm::vec3(matrix[2])) < 0.f){
+            scale.x = -scale.x;
+        }
+        const glm::vec3 x = glm::vec3(matrix[0]) / scale.x;
+        const glm::vec3 y = glm::vec3(matrix[1]) / scale.y;
+        const glm::vec3 z = glm::vec3(matrix[2]) / scale.z;
+
+        // mat4() is Ry * Rx * Rz: z.y = -sin(rx)
+        rotation.x = glm::asin(glm::clamp(-z.y, -1.f, 1.f));
+        if(glm::abs(z.y) < 0.9999f){
+            rotation.y = glm::atan(z.x, z.z);
+            rotation.z = glm::atan(x.y, y.y);
+        } else {
+            // gimbal lock, y and z rotate about the same axis
+            rotation.y = glm::atan(-x.z, x.x);
+            rotation.z = 0.f;
+        }
+    }
     
     ODGameObject ODGameObject::makePointLight(float intensity, float radius, glm::vec3 color){
         ODGameObject gameObject = ODGameObject::createGameObject();
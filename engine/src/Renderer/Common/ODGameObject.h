@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ODAssetHandle.h"
 #include "ODModel.h"
 #include "ODCamera.h"
 
@@ -11,7 +12,6 @@
 #include <unordered_map>
 
 namespace ODEngine {
-
     struct TransformComponent {
         glm::vec3 translation {};
         glm::vec3 scale {1.0f, 1.0f, 1.0f};
@@ -19,6 +19,8 @@ namespace ODEngine {
 
         glm::mat4 mat4();
         glm::mat3 normalMatrix();
+        // inverse of mat4() for matrices without shear (e.g. glTF node transforms)
+        void setFromMatrix(const glm::mat4& matrix);
 
     };
 
@@ -47,9 +49,15 @@ namespace ODEngine {
 
         const id_t getId() const { return m_id; }
 
-        std::shared_ptr<ODModel> model {}; 
+        // resolved through FrameInfo::assets, each holding a reference of the object's own so
+        // the registry keeps them cached for as long as the object uses them
+        ODModelRef model {};
+        // sampled through the bindless texture array, the default texture while empty or loading
+        ODTextureRef texture {};
         glm::vec3 color {}; 
         TransformComponent transform{};
+        // LOD of model drawn last frame, LOD selection switches away from it with hysteresis
+        uint32_t lod = 0;
 
         std::unique_ptr<PointLightComponent> pointLight = nullptr;
         std::unique_ptr<ODCamera> camera = nullptr;
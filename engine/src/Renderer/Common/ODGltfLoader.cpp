@@ -0,0 +1,502 @@
+#include "ODGltfLoader.h"
+#include "Utils/ODJson.h"
+#include "Utils/ODMappedFile.h"
+#include "Utils/ODThreadPool.h"
+
+// libs
+#include <glm/gtc/quaternion.hpp>
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace ODEngine {
+
+    namespace {
+        constexpr uint32_t GLB_MAGIC = 0x46546C67;   // "glTF"
+        constexpr uint32_t GLB_VERSION = 2;
+        constexpr uint32_t CHUNK_JSON = 0x4E4F534A;  // "JSON"
+        constexpr uint32_t CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+        constexpr uint32_t COMPONENT_BYTE = 5120;
+        constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+        constexpr uint32_t COMPONENT_SHORT = 5122;
+        constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+        constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+        constexpr uint32_t COMPONENT_FLOAT = 5126;
+
+        constexpr int64_t MODE_TRIANGLES = 4;
+
+        // accessor data inside the mapped BIN chunk
+        struct AccessorView {
+            const uint8_t* data = nullptr;
+            uint32_t count = 0;
+            uint32_t stride = 0; // bytes between elements
+            uint32_t componentType = COMPONENT_FLOAT;
+            uint32_t components = 1;
+            bool normalized = false;
+        };
+
+        uint32_t readU32(const uint8_t* data) {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t componentSize(uint32_t componentType) {
+            switch (componentType) {
+                case COMPONENT_BYTE:
+                case COMPONENT_UNSIGNED_BYTE: return 1;
+                case COMPONENT_SHORT:
+                case COMPONENT_UNSIGNED_SHORT: return 2;
+                case COMPONENT_UNSIGNED_INT:
+                case COMPONENT_FLOAT: return 4;
+                default: throw std::runtime_error("unknown glTF component type!");
+            }
+        }
+
+        uint32_t componentCount(const std::string& type) {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+            throw std::runtime_error("unsupported glTF accessor type " + type + "!");
+        }
+
+        // one component as float, normalized integers mapped to [0, 1] / [-1, 1]
+        float readComponent(const uint8_t* data, uint32_t componentType, bool normalized) {
+            switch (componentType) {
+                case COMPONENT_FLOAT: {
+                    float value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return value;
+                }
+                case COMPONENT_UNSIGNED_BYTE:
+                    return normalized ? data[0] / 255.f : data[0];
+                case COMPONENT_BYTE: {
+                    float value = static_cast<float>(static_cast<int8_t>(data[0]));
+                    return normalized ? std::max(value / 127.f, -1.f) : value;
+                }
+                case COMPONENT_UNSIGNED_SHORT: {
+                    uint16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return normalized ? value / 65535.f : value;
+                }
+                case COMPONENT_SHORT: {
+                    int16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return normalized ? std::max(value / 32767.f, -1.f) : value;
+                }
+                default:
+                    return static_cast<float>(readU32(data));
+            }
+        }
+
+        // integer property that is a count, size or offset into the file, fallback when absent
+        uint64_t readUnsigned(const ODJson& value, const char* name, int64_t fallback = 0) {
+            int64_t number = value.asInt(fallback);
+            if (number < 0) {
+                throw std::runtime_error(std::string("negative glTF ") + name + "!");
+            }
+            return static_cast<uint64_t>(number);
+        }
+
+        // the same for properties stored as 32 bits
+        uint32_t readUnsigned32(const ODJson& value, const char* name, int64_t fallback = 0) {
+            uint64_t number = readUnsigned(value, name, fallback);
+            if (number > UINT32_MAX) {
+                throw std::runtime_error(std::string("glTF ") + name + " too large!");
+            }
+            return static_cast<uint32_t>(number);
+        }
+
+        class GlbDocument {
+            public:
+                explicit GlbDocument(const std::string& filepath) {
+                    if (!m_file.open(filepath)) {
+                        throw std::runtime_error("failed to open " + filepath + "!");
+                    }
+                    const uint8_t* data = m_file.data();
+                    size_t size = m_file.size();
+                    if (size < 20 || readU32(data) != GLB_MAGIC) {
+                        throw std::runtime_error(filepath + " is not a binary glTF file!");
+                    }
+                    if (readU32(data + 4) != GLB_VERSION) {
+                        throw std::runtime_error(filepath + " is not glTF 2.0!");
+                    }
+                    size = std::min<size_t>(size, readU32(data + 8));
+
+                    // chunks: JSON first, then an optional BIN, unknown ones are skipped
+                    size_t offset = 12;
+                    bool hasJson = false;
+                    while (offset + 8 <= size) {
+                        uint32_t chunkLength = readU32(data + offset);
+                        uint32_t chunkType = readU32(data + offset + 4);
+                        offset += 8;
+                        if (chunkLength > size - offset) {
+                            throw std::runtime_error(filepath + " has a truncated chunk!");
+                        }
+                        if (chunkType == CHUNK_JSON && !hasJson) {
+                            m_json = ODJson::parse(
+                                std::string_view(reinterpret_cast<const char*>(data + offset), chunkLength));
+                            hasJson = true;
+                        } else if (chunkType == CHUNK_BIN && m_bin == nullptr) {
+                            m_bin = data + offset;
+                            m_binSize = chunkLength;
+                        }
+                        offset += (size_t{chunkLength} + 3) & ~size_t{3};
+                    }
+                    if (!hasJson) {
+                        throw std::runtime_error(filepath + " has no JSON chunk!");
+                    }
+                }
+
+                const ODJson& json() const { return m_json; }
+
+                AccessorView accessor(int64_t index) const {
+                    const ODJson& accessor = m_json["accessors"][static_cast<size_t>(index)];
+                    if (!accessor.isObject() || index < 0) {
+                        throw std::runtime_error("invalid glTF accessor index!");
+                    }
+                    if (accessor.has("sparse")) {
+                        throw std::runtime_error("sparse glTF accessors are not supported!");
+                    }
+                    const ODJson& bufferView = m_json["bufferViews"][static_cast<size_t>(accessor["bufferView"].asInt(-1))];
+                    if (!bufferView.isObject()) {
+                        throw std::runtime_error("glTF accessor without buffer view!");
+                    }
+                    uint64_t viewLength = 0;
+                    const uint8_t* viewData = bufferViewData(bufferView, viewLength);
+
+                    AccessorView view{};
+                    view.count = readUnsigned32(accessor["count"], "accessor count");
+                    view.componentType = static_cast<uint32_t>(accessor["componentType"].asInt());
+                    view.components = componentCount(accessor["type"].asString());
+                    view.normalized = accessor["normalized"].asBool();
+                    uint32_t elementSize = componentSize(view.componentType) * view.components;
+                    view.stride = readUnsigned32(bufferView["byteStride"], "buffer view stride", elementSize);
+
+                    // both below 2^32, the span cannot overflow
+                    uint64_t offset = readUnsigned(accessor["byteOffset"], "accessor offset");
+                    uint64_t span = view.count == 0 ? 0 : uint64_t{view.stride} * (view.count - 1) + elementSize;
+                    if (offset > viewLength || span > viewLength - offset) {
+                        throw std::runtime_error("glTF accessor out of its buffer!");
+                    }
+                    view.data = viewData + offset;
+                    return view;
+                }
+
+                // encoded bytes of an image stored in a buffer view, false for external files
+                // and data URIs
+                bool image(int64_t index, const uint8_t*& data, uint64_t& size) const {
+                    const ODJson& entry = m_json["images"][static_cast<size_t>(index)];
+                    if (!entry.isObject() || index < 0 || !entry.has("bufferView")) {
+                        return false;
+                    }
+                    const ODJson& bufferView = m_json["bufferViews"][static_cast<size_t>(entry["bufferView"].asInt(-1))];
+                    if (!bufferView.isObject()) {
+                        throw std::runtime_error("glTF image without buffer view!");
+                    }
+                    data = bufferViewData(bufferView, size);
+                    return true;
+                }
+
+            private:
+                const uint8_t* bufferViewData(const ODJson& bufferView, uint64_t& length) const {
+                    const ODJson& buffer = m_json["buffers"][static_cast<size_t>(bufferView["buffer"].asInt(-1))];
+                    if (bufferView["buffer"].asInt(-1) != 0 || buffer.has("uri") || m_bin == nullptr) {
+                        throw std::runtime_error("only the embedded GLB buffer is supported!");
+                    }
+                    uint64_t offset = readUnsigned(bufferView["byteOffset"], "buffer view offset");
+                    length = readUnsigned(bufferView["byteLength"], "buffer view length");
+                    if (offset > m_binSize || length > m_binSize - offset) {
+                        throw std::runtime_error("glTF buffer view out of its buffer!");
+                    }
+                    return m_bin + offset;
+                }
+
+                ODMappedFile m_file;
+                ODJson m_json;
+                const uint8_t* m_bin = nullptr;
+                size_t m_binSize = 0;
+        };
+
+        // N float components at byte offset of every vertex, a plain strided copy when the
+        // accessor already holds N floats
+        template<uint32_t N>
+        void copyAttribute(const AccessorView& view, std::vector<ODModel::Vertex>& vertices, size_t offset) {
+            uint32_t count = std::min(view.count, static_cast<uint32_t>(vertices.size()));
+            uint8_t* out = reinterpret_cast<uint8_t*>(vertices.data()) + offset;
+            if (view.componentType == COMPONENT_FLOAT && view.components >= N) {
+                for (uint32_t i = 0; i < count; i++) {
+                    std::memcpy(out + i * sizeof(ODModel::Vertex), view.data + size_t{i} * view.stride, N * sizeof(float));
+                }
+                return;
+            }
+            uint32_t size = componentSize(view.componentType);
+            uint32_t components = std::min(view.components, N);
+            for (uint32_t i = 0; i < count; i++) {
+                float values[N] = {};
+                for (uint32_t c = 0; c < components; c++) {
+                    values[c] = readComponent(view.data + size_t{i} * view.stride + c * size, view.componentType,
+                        view.normalized);
+                }
+                std::memcpy(out + i * sizeof(ODModel::Vertex), values, sizeof(values));
+            }
+        }
+
+        void copyIndices(const AccessorView& view, uint32_t vertexCount, std::vector<uint32_t>& indices) {
+            indices.resize(view.count);
+            if (view.componentType == COMPONENT_UNSIGNED_INT && view.stride == sizeof(uint32_t)) {
+                std::memcpy(indices.data(), view.data, indices.size() * sizeof(uint32_t));
+            } else if (view.componentType == COMPONENT_UNSIGNED_SHORT) {
+                for (uint32_t i = 0; i < view.count; i++) {
+                    uint16_t index;
+                    std::memcpy(&index, view.data + size_t{i} * view.stride, sizeof(index));
+                    indices[i] = index;
+                }
+            } else if (view.componentType == COMPONENT_UNSIGNED_BYTE) {
+                for (uint32_t i = 0; i < view.count; i++) {
+                    indices[i] = view.data[size_t{i} * view.stride];
+                }
+            } else if (view.componentType == COMPONENT_UNSIGNED_INT) {
+                for (uint32_t i = 0; i < view.count; i++) {
+                    indices[i] = readU32(view.data + size_t{i} * view.stride);
+                }
+            } else {
+                throw std::runtime_error("invalid glTF index component type!");
+            }
+            indices.resize(indices.size() - indices.size() % 3);
+            for (uint32_t index : indices) {
+                if (index >= vertexCount) {
+                    throw std::runtime_error("glTF index out of range!");
+                }
+            }
+        }
+
+        // area weighted face normals, for primitives authored without NORMAL
+        void computeNormals(ODModel::Builder& builder) {
+            auto triangleCount = builder.indices.empty() ? builder.vertices.size() / 3 : builder.indices.size() / 3;
+            for (size_t t = 0; t < triangleCount; t++) {
+                uint32_t i0 = builder.indices.empty() ? static_cast<uint32_t>(3 * t) : builder.indices[3 * t];
+                uint32_t i1 = builder.indices.empty() ? static_cast<uint32_t>(3 * t + 1) : builder.indices[3 * t + 1];
+                uint32_t i2 = builder.indices.empty() ? static_cast<uint32_t>(3 * t + 2) : builder.indices[3 * t + 2];
+                glm::vec3 p0 = builder.vertices[i0].position;
+                glm::vec3 normal = glm::cross(builder.vertices[i1].position - p0, builder.vertices[i2].position - p0);
+                builder.vertices[i0].normal += normal;
+                builder.vertices[i1].normal += normal;
+                builder.vertices[i2].normal += normal;
+            }
+            for (auto& vertex : builder.vertices) {
+                float length = glm::length(vertex.normal);
+                vertex.normal = length > 0.f ? vertex.normal / length : glm::vec3{0.f, 1.f, 0.f};
+            }
+        }
+
+        // false for primitives that are not drawable triangle lists
+        bool readPrimitive(const GlbDocument& document, const ODJson& primitive,
+            const std::vector<ODGltfScene::Material>& materials, ODGltfScene::Primitive& out) {
+            if (primitive["mode"].asInt(MODE_TRIANGLES) != MODE_TRIANGLES) {
+                return false;
+            }
+            const ODJson& attributes = primitive["attributes"];
+            if (!attributes.has("POSITION")) {
+                return false;
+            }
+
+            out.material = static_cast<int32_t>(primitive["material"].asInt(-1));
+            glm::vec3 color{1.f};
+            if (out.material >= 0 && static_cast<size_t>(out.material) < materials.size()) {
+                color = glm::vec3(materials[out.material].baseColorFactor);
+            }
+
+            ODModel::Builder& builder = out.builder;
+            AccessorView positions = document.accessor(attributes["POSITION"].asInt());
+            if (positions.count < 3) {
+                return false;
+            }
+            builder.vertices.assign(positions.count, ODModel::Vertex{{}, color, {}, {}});
+            copyAttribute<3>(positions, builder.vertices, offsetof(ODModel::Vertex, position));
+            if (attributes.has("NORMAL")) {
+                copyAttribute<3>(document.accessor(attributes["NORMAL"].asInt()), builder.vertices,
+                    offsetof(ODModel::Vertex, normal));
+            }
+            if (attributes.has("TEXCOORD_0")) {
+                copyAttribute<2>(document.accessor(attributes["TEXCOORD_0"].asInt()), builder.vertices,
+                    offsetof(ODModel::Vertex, uv));
+            }
+            if (attributes.has("COLOR_0")) {
+                // alpha dropped, Vertex::color is rgb
+                copyAttribute<3>(document.accessor(attributes["COLOR_0"].asInt()), builder.vertices,
+                    offsetof(ODModel::Vertex, color));
+            }
+            if (primitive.has("indices")) {
+                copyIndices(document.accessor(primitive["indices"].asInt()), positions.count, builder.indices);
+                if (builder.indices.empty()) {
+                    return false;
+                }
+            }
+            if (!attributes.has("NORMAL")) {
+                computeNormals(builder);
+            }
+            return true;
+        }
+
+        glm::mat4 localMatrix(const ODJson& node) {
+            const ODJson& matrix = node["matrix"];
+            if (matrix.size() == 16) {
+                glm::mat4 result{1.f};
+                for (int column = 0; column < 4; column++) {
+                    for (int row = 0; row < 4; row++) {
+                        result[column][row] = matrix[static_cast<size_t>(column * 4 + row)].asFloat();
+                    }
+                }
+                return result;
+            }
+
+            const ODJson& t = node["translation"];
+            const ODJson& r = node["rotation"];
+            const ODJson& s = node["scale"];
+            glm::vec3 translation{t[0].asFloat(), t[1].asFloat(), t[2].asFloat()};
+            glm::quat rotation{r[3].asFloat(1.f), r[0].asFloat(), r[1].asFloat(), r[2].asFloat()};
+            glm::vec3 scale{s[0].asFloat(1.f), s[1].asFloat(1.f), s[2].asFloat(1.f)};
+
+            glm::mat4 result = glm::mat4_cast(rotation);
+            result[0] *= scale.x;
+            result[1] *= scale.y;
+            result[2] *= scale.z;
+            result[3] = glm::vec4(translation, 1.f);
+            return result;
+        }
+    }
+
+    ODGltfScene ODGltfLoader::load(const std::string &filepath) {
+        GlbDocument document{filepath};
+        const ODJson& json = document.json();
+        ODGltfScene scene{};
+
+        const ODJson& materials = json["materials"];
+        scene.materials.resize(materials.size());
+        for (size_t i = 0; i < scene.materials.size(); i++) {
+            const ODJson& material = materials[i];
+            const ODJson& pbr = material["pbrMetallicRoughness"];
+            const ODJson& factor = pbr["baseColorFactor"];
+            scene.materials[i].name = material["name"].asString();
+            scene.materials[i].baseColorFactor = {factor[0].asFloat(1.f), factor[1].asFloat(1.f),
+                factor[2].asFloat(1.f), factor[3].asFloat(1.f)};
+            const ODJson& texture = json["textures"][static_cast<size_t>(pbr["baseColorTexture"]["index"].asInt(-1))];
+            scene.materials[i].baseColorImage = static_cast<int32_t>(texture["source"].asInt(-1));
+        }
+
+        // copied out of the mapping, the registry decodes them after the file is closed
+        const ODJson& images = json["images"];
+        scene.images.resize(images.size());
+        for (size_t i = 0; i < scene.images.size(); i++) {
+            scene.images[i].name = images[i]["name"].asString();
+            const uint8_t* data = nullptr;
+            uint64_t size = 0;
+            if (document.image(static_cast<int64_t>(i), data, size)) {
+                scene.images[i].data.assign(data, data + size);
+            } else {
+                std::cerr << "skipping image " << i << " of " << filepath << ": not embedded" << std::endl;
+            }
+        }
+        for (ODGltfScene::Material& material : scene.materials) {
+            if (material.baseColorImage >= static_cast<int32_t>(scene.images.size()) ||
+                (material.baseColorImage >= 0 && scene.images[material.baseColorImage].data.empty())) {
+                material.baseColorImage = -1;
+            }
+        }
+
+        // every primitive of every mesh is independent, fill them in parallel
+        const ODJson& meshes = json["meshes"];
+        scene.meshes.resize(meshes.size());
+        std::vector<std::pair<size_t, size_t>> primitives;
+        for (size_t m = 0; m < scene.meshes.size(); m++) {
+            scene.meshes[m].name = meshes[m]["name"].asString();
+            scene.meshes[m].primitives.resize(meshes[m]["primitives"].size());
+            for (size_t p = 0; p < scene.meshes[m].primitives.size(); p++) {
+                primitives.emplace_back(m, p);
+            }
+        }
+        std::vector<uint8_t> valid(primitives.size(), 0);
+        ODThreadPool& pool = ODThreadPool::shared();
+        pool.parallelFor(primitives.size(), std::min<size_t>(primitives.size(), pool.getConcurrency()),
+            [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    auto [m, p] = primitives[i];
+                    valid[i] = readPrimitive(document, meshes[m]["primitives"][p], scene.materials,
+                        scene.meshes[m].primitives[p]);
+                }
+            });
+        for (size_t i = primitives.size(); i-- > 0;) {
+            if (!valid[i]) {
+                auto [m, p] = primitives[i];
+                std::cerr << "skipping primitive " << p << " of mesh " << m << " in " << filepath
+                    << ": not a triangle list with positions" << std::endl;
+                scene.meshes[m].primitives.erase(scene.meshes[m].primitives.begin() + p);
+            }
+        }
+
+        // default scene (or every root node when the file has no scene), depth first so that
+        // parents come before their children
+        const ODJson& nodes = json["nodes"];
+        std::vector<std::pair<int64_t, int32_t>> stack; // node, parent in scene.nodes
+        const ODJson& sceneNodes = json["scenes"][static_cast<size_t>(json["scene"].asInt(0))]["nodes"];
+        if (sceneNodes.isArray()) {
+            for (size_t i = sceneNodes.size(); i-- > 0;) {
+                stack.emplace_back(sceneNodes[i].asInt(-1), -1);
+            }
+        } else {
+            std::vector<uint8_t> isChild(nodes.size(), 0);
+            for (size_t i = 0; i < nodes.size(); i++) {
+                const ODJson& children = nodes[i]["children"];
+                for (size_t c = 0; c < children.size(); c++) {
+                    size_t child = static_cast<size_t>(children[c].asInt(-1));
+                    if (child < isChild.size()) {
+                        isChild[child] = 1;
+                    }
+                }
+            }
+            for (size_t i = nodes.size(); i-- > 0;) {
+                if (!isChild[i]) {
+                    stack.emplace_back(static_cast<int64_t>(i), -1);
+                }
+            }
+        }
+
+        std::vector<uint8_t> visited(nodes.size(), 0);
+        while (!stack.empty()) {
+            auto [index, parent] = stack.back();
+            stack.pop_back();
+            if (index < 0 || static_cast<size_t>(index) >= nodes.size() || visited[index]) {
+                throw std::runtime_error(filepath + " has an invalid node hierarchy!");
+            }
+            visited[index] = 1;
+
+            const ODJson& node = nodes[static_cast<size_t>(index)];
+            ODGltfScene::Node out{};
+            out.name = node["name"].asString();
+            out.mesh = static_cast<int32_t>(node["mesh"].asInt(-1));
+            if (out.mesh >= static_cast<int32_t>(scene.meshes.size())) {
+                out.mesh = -1;
+            }
+            out.parent = parent;
+            glm::mat4 local = localMatrix(node);
+            out.world = parent >= 0 ? scene.nodes[parent].world * local : local;
+            scene.nodes.push_back(std::move(out));
+
+            int32_t self = static_cast<int32_t>(scene.nodes.size() - 1);
+            const ODJson& children = node["children"];
+            for (size_t c = children.size(); c-- > 0;) {
+                stack.emplace_back(children[c].asInt(-1), self);
+            }
+        }
+        return scene;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ODModel.h"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ODEngine {
+
+    // Contents of a binary glTF 2.0 file, ready to become models and game objects
+    struct ODGltfScene {
+        struct Material {
+            std::string name;
+            glm::vec4 baseColorFactor{1.f};
+            // index in images, -1 when untextured or when the image is not embedded
+            int32_t baseColorImage = -1;
+        };
+
+        // PNG, JPEG... as stored in the file, empty when not embedded
+        struct Image {
+            std::string name;
+            std::vector<uint8_t> data;
+        };
+
+        // one draw: primitives of a mesh differ by material (or by attribute set)
+        struct Primitive {
+            ODModel::Builder builder;
+            int32_t material = -1;
+        };
+
+        struct Mesh {
+            std::string name;
+            std::vector<Primitive> primitives;
+        };
+
+        // node of the default scene, parents before their children
+        struct Node {
+            std::string name;
+            int32_t mesh = -1;
+            int32_t parent = -1; // index in nodes
+            glm::mat4 world{1.f};
+        };
+
+        std::vector<Material> materials;
+        std::vector<Image> images;
+        std::vector<Mesh> meshes;
+        std::vector<Node> nodes;
+    };
+
+    /*
+     * .glb importer. The file is mapped, only the JSON chunk is parsed; accessor data is
+     * read in place from the BIN chunk. Indices are copied as they are (a single memcpy for
+     * uint32 ones), vertex attributes are strided copies into ODModel::Vertex: no corner
+     * expansion or deduplication like the OBJ path, and the primitives are filled in
+     * parallel on ODThreadPool::shared().
+     *
+     * Reads POSITION, NORMAL, TEXCOORD_0 and COLOR_0 of triangle list primitives. Vertex
+     * colors default to the material base color factor, missing normals are rebuilt from
+     * the triangles. Base color textures are returned as the encoded images of the materials.
+     * Embedded buffers and images only (no external or data URIs), no sparse accessors, skins
+     * or morph targets. Coordinates stay as authored (+Y up).
+     */
+    class ODGltfLoader {
+        public:
+            // throws std::runtime_error on anything it cannot read
+            static ODGltfScene load(const std::string& filepath);
+    };
+}
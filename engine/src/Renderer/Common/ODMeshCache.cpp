@@ -0,0 +1,217 @@
+#include "ODMeshCache.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace ODEngine {
+
+    namespace {
+        uint64_t alignOffset(uint64_t offset) {
+            return (offset + 15) & ~uint64_t{15};
+        }
+
+        bool getSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& writeTime) {
+            std::error_code error;
+            auto fileSize = std::filesystem::file_size(sourcePath, error);
+            if (error) {
+                return false;
+            }
+            auto time = std::filesystem::last_write_time(sourcePath, error);
+            if (error) {
+                return false;
+            }
+            size = static_cast<uint64_t>(fileSize);
+            writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        bool hashSourceFile(const std::string& sourcePath, uint64_t& hash) {
+            ODMappedFile source;
+            if (!source.open(sourcePath)) {
+                return false;
+            }
+            hash = ODMeshCache::hashBytes(source.data(), source.size());
+            return true;
+        }
+
+        // rewrites the field in place, the cache must not be mapped (Windows maps it without
+        // write sharing)
+        bool rewriteSourceWriteTime(const std::string& cachePath, int64_t writeTime) {
+            std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+            if (!file) {
+                return false;
+            }
+            file.seekp(offsetof(ODMeshFileHeader, sourceWriteTime));
+            file.write(reinterpret_cast<const char*>(&writeTime), sizeof(writeTime));
+            return static_cast<bool>(file);
+        }
+    }
+
+    std::string ODMeshCache::getCachePath(const std::string& sourcePath) {
+        return sourcePath + ".odmesh";
+    }
+
+    uint64_t ODMeshCache::hashBytes(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    uint64_t ODMeshCache::vertexLayoutHash() {
+        // the cache stores the interleaved CPU vertex, how it is split into GPU streams does
+        // not matter here
+        using Vertex = ODModel::Vertex;
+        uint32_t fields[] = {sizeof(Vertex),
+            offsetof(Vertex, position), sizeof(Vertex::position),
+            offsetof(Vertex, color), sizeof(Vertex::color),
+            offsetof(Vertex, normal), sizeof(Vertex::normal),
+            offsetof(Vertex, uv), sizeof(Vertex::uv)};
+        return hashBytes(fields, sizeof(fields));
+    }
+
+    bool ODMeshCache::load(const std::string& sourcePath, ODMappedFile& file, View& view) {
+        std::string cachePath = getCachePath(sourcePath);
+        if (!file.open(cachePath)) {
+            return false;
+        }
+        if (file.size() < sizeof(ODMeshFileHeader)) {
+            file.close();
+            return false;
+        }
+
+        ODMeshFileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        uint64_t vertexBytes = uint64_t{header.vertexStride} * header.vertexCount;
+        uint64_t indexBytes = sizeof(uint32_t) * uint64_t{header.indexCount};
+        uint64_t meshletBytes = sizeof(ODModel::Meshlet) * uint64_t{header.meshletCount};
+        bool valid = header.magic == ODMeshFileHeader::MAGIC &&
+            header.version == ODMeshFileHeader::VERSION &&
+            header.layoutHash == vertexLayoutHash() &&
+            header.vertexStride == sizeof(ODModel::Vertex) &&
+            header.vertexDataOffset % 16 == 0 && header.indexDataOffset % 16 == 0 &&
+            header.vertexDataOffset + vertexBytes <= file.size() &&
+            header.indexDataOffset + indexBytes <= file.size() &&
+            header.meshletDataOffset % 16 == 0 && header.meshletDataOffset + meshletBytes <= file.size() &&
+            header.lodCount >= 1 && header.lodCount <= ODModel::MAX_LODS;
+        for (uint32_t i = 0; valid && i < header.lodCount; i++) {
+            valid = uint64_t{header.lods[i].firstIndex} + header.lods[i].indexCount <= header.indexCount &&
+                uint64_t{header.lods[i].firstMeshlet} + header.lods[i].meshletCount <= header.meshletCount;
+        }
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (valid && getSourceInfo(sourcePath, sourceSize, sourceWriteTime)) {
+            // same size and write time: trust the stored hash, otherwise hash the content
+            if (sourceSize != header.sourceSize) {
+                valid = false;
+            } else if (sourceWriteTime != header.sourceWriteTime) {
+                uint64_t sourceHash = 0;
+                valid = hashSourceFile(sourcePath, sourceHash) && sourceHash == header.sourceHash;
+                if (valid) {
+                    // same content under a new write time (touched, checked out again): store
+                    // it so the next loads trust the header again instead of hashing the source
+                    size_t size = file.size();
+                    file.close();
+                    rewriteSourceWriteTime(cachePath, sourceWriteTime);
+                    valid = file.open(cachePath) && file.size() == size;
+                }
+            }
+        }
+        // without the source the cache is used as it is
+
+        if (!valid) {
+            file.close();
+            return false;
+        }
+
+        view.vertices = reinterpret_cast<const ODModel::Vertex*>(file.data() + header.vertexDataOffset);
+        view.vertexCount = header.vertexCount;
+        view.indices = reinterpret_cast<const uint32_t*>(file.data() + header.indexDataOffset);
+        view.indexCount = header.indexCount;
+        view.lods = reinterpret_cast<const ODModel::Lod*>(file.data() + offsetof(ODMeshFileHeader, lods));
+        view.lodCount = header.lodCount;
+        view.meshlets = reinterpret_cast<const ODModel::Meshlet*>(file.data() + header.meshletDataOffset);
+        view.meshletCount = header.meshletCount;
+        view.boundsMin = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]};
+        view.boundsMax = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]};
+        return true;
+    }
+
+    bool ODMeshCache::write(const std::string& sourcePath, const ODModel::Builder& builder) {
+        ODMeshFileHeader header{};
+        header.magic = ODMeshFileHeader::MAGIC;
+        header.version = ODMeshFileHeader::VERSION;
+        header.layoutHash = vertexLayoutHash();
+        if (!getSourceInfo(sourcePath, header.sourceSize, header.sourceWriteTime) ||
+            !hashSourceFile(sourcePath, header.sourceHash)) {
+            return false;
+        }
+        header.vertexStride = sizeof(ODModel::Vertex);
+        header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+        header.indexCount = static_cast<uint32_t>(builder.indices.size());
+        header.meshletCount = static_cast<uint32_t>(builder.meshlets.size());
+        if (builder.lods.empty()) {
+            header.lodCount = 1;
+            header.lods[0] = {0, header.indexCount, 0.f};
+        } else {
+            header.lodCount = static_cast<uint32_t>(std::min<size_t>(builder.lods.size(), ODModel::MAX_LODS));
+            std::copy_n(builder.lods.begin(), header.lodCount, header.lods);
+        }
+
+        glm::vec3 boundsMin, boundsMax;
+        builder.computeBounds(boundsMin, boundsMax);
+        for (int i = 0; i < 3; i++) {
+            header.boundsMin[i] = boundsMin[i];
+            header.boundsMax[i] = boundsMax[i];
+        }
+
+        uint64_t vertexBytes = uint64_t{header.vertexStride} * header.vertexCount;
+        header.vertexDataOffset = alignOffset(sizeof(ODMeshFileHeader));
+        header.indexDataOffset = alignOffset(header.vertexDataOffset + vertexBytes);
+        uint64_t indexBytes = sizeof(uint32_t) * uint64_t{header.indexCount};
+        header.meshletDataOffset = alignOffset(header.indexDataOffset + indexBytes);
+
+        // write to a temporary file and rename it so a crash never leaves a truncated cache
+        std::string cachePath = getCachePath(sourcePath);
+        std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            const char padding[16] = {};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(padding, static_cast<std::streamsize>(header.vertexDataOffset - sizeof(header)));
+            out.write(reinterpret_cast<const char*>(builder.vertices.data()), static_cast<std::streamsize>(vertexBytes));
+            out.write(padding, static_cast<std::streamsize>(
+                header.indexDataOffset - header.vertexDataOffset - vertexBytes));
+            out.write(reinterpret_cast<const char*>(builder.indices.data()), static_cast<std::streamsize>(indexBytes));
+            out.write(padding, static_cast<std::streamsize>(
+                header.meshletDataOffset - header.indexDataOffset - indexBytes));
+            out.write(reinterpret_cast<const char*>(builder.meshlets.data()),
+                static_cast<std::streamsize>(sizeof(ODModel::Meshlet) * builder.meshlets.size()));
+            if (!out) {
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+}
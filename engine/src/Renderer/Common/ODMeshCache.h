@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ODModel.h"
+#include "Utils/ODMappedFile.h"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace ODEngine {
+
+    // On-disk header of a .odmesh file. The vertex, index and meshlet streams follow at
+    // vertexDataOffset / indexDataOffset / meshletDataOffset (16 byte aligned) in
+    // ODModel::Vertex, uint32 and ODModel::Meshlet layout, ready to be copied to the GPU
+    // as they are.
+    struct ODMeshFileHeader {
+        static constexpr uint32_t MAGIC = 0x48534D4F; // "OMSH"
+        // 2: streams reordered by ODMeshOptimizer, 3: LOD table, 4: meshlets
+        static constexpr uint32_t VERSION = 4;
+
+        uint32_t magic;
+        uint32_t version;
+        uint64_t layoutHash;       // ODMeshCache::vertexLayoutHash() when written
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t sourceHash;       // FNV-1a of the source file
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        float boundsMin[4];
+        float boundsMax[4];
+        uint64_t vertexDataOffset;
+        uint64_t indexDataOffset;
+        uint64_t meshletDataOffset;
+        uint32_t meshletCount;
+        uint32_t reserved;
+        ODModel::Lod lods[ODModel::MAX_LODS]; // ranges in the index stream, LOD0 first
+    };
+
+    /*
+     * Binary cache of imported meshes, stored next to the source as <source>.odmesh.
+     * A cache is stale when the Vertex layout changed or when the source content hash
+     * differs (the hash is only recomputed when the source size or write time moved).
+     */
+    class ODMeshCache {
+        public:
+            struct View {
+                const ODModel::Vertex* vertices = nullptr;
+                uint32_t vertexCount = 0;
+                const uint32_t* indices = nullptr;
+                uint32_t indexCount = 0;
+                const ODModel::Lod* lods = nullptr;
+                uint32_t lodCount = 0;
+                const ODModel::Meshlet* meshlets = nullptr;
+                uint32_t meshletCount = 0;
+                glm::vec3 boundsMin{0.f};
+                glm::vec3 boundsMax{0.f};
+            };
+
+            static std::string getCachePath(const std::string& sourcePath);
+
+            // Maps the cache of sourcePath into file and points view at its streams.
+            // Returns false when there is no valid cache.
+            static bool load(const std::string& sourcePath, ODMappedFile& file, View& view);
+            static bool write(const std::string& sourcePath, const ODModel::Builder& builder);
+
+            static uint64_t vertexLayoutHash();
+            static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+
+        private:
+            static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+            static constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+    };
+}
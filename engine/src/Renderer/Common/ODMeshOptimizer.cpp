@@ -0,0 +1,389 @@
+#include "ODMeshOptimizer.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace ODEngine {
+
+    namespace {
+        // Forsyth, "Linear-Speed Vertex Cache Optimisation"
+        constexpr float CACHE_DECAY_POWER = 1.5f;
+        constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+        constexpr float VALENCE_BOOST_SCALE = 2.0f;
+        constexpr float VALENCE_BOOST_POWER = 0.5f;
+        constexpr uint32_t MAX_SCORED_VALENCE = 32;
+        constexpr uint32_t CACHE_SIZE = ODMeshOptimizer::OPTIMIZER_CACHE_SIZE;
+
+        struct ScoreTables {
+            float cache[CACHE_SIZE];
+            float valence[MAX_SCORED_VALENCE + 1];
+        };
+
+        const ScoreTables& scoreTables(){
+            static const ScoreTables tables = [](){
+                ScoreTables result{};
+                for(uint32_t i = 0; i < CACHE_SIZE; i++){
+                    // the last triangle's vertices get a fixed score so it is not reused straight away
+                    result.cache[i] = i < 3
+                        ? LAST_TRIANGLE_SCORE
+                        : std::pow(1.f - float(i - 3) / float(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+                }
+                result.valence[0] = 0.f;
+                for(uint32_t i = 1; i <= MAX_SCORED_VALENCE; i++){
+                    result.valence[i] = VALENCE_BOOST_SCALE * std::pow(float(i), -VALENCE_BOOST_POWER);
+                }
+                return result;
+            }();
+            return tables;
+        }
+
+        float vertexScore(int32_t cachePosition, uint32_t remainingValence){
+            if(remainingValence == 0){
+                return -1.f;
+            }
+            const ScoreTables& tables = scoreTables();
+            float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.f;
+            return score + tables.valence[std::min(remainingValence, MAX_SCORED_VALENCE)];
+        }
+
+        // FIFO post-transform cache: a vertex hits while fewer than size misses happened since its own
+        class FifoCache {
+            public:
+                FifoCache(size_t vertexCount, uint32_t size)
+                    : m_timestamps(vertexCount, 0), m_size(size), m_time(size + 1) {}
+
+                // returns 1 on a miss
+                uint32_t access(uint32_t vertex){
+                    if(m_time - m_timestamps[vertex] > m_size){
+                        m_timestamps[vertex] = m_time++;
+                        return 1;
+                    }
+                    return 0;
+                }
+
+                void flush(){ m_time += m_size + 1; }
+
+            private:
+                std::vector<uint32_t> m_timestamps;
+                uint32_t m_size;
+                uint32_t m_time;
+        };
+    }
+
+    void ODMeshOptimizer::optimize(ODModel::Builder &builder, const std::string &name){
+        auto& vertices = builder.vertices;
+        auto& indices = builder.indices;
+        if(indices.size() < 3 || vertices.empty()){
+            return;
+        }
+
+        // every LOD range is ordered on its own, the report covers LOD0
+        std::vector<ODModel::Lod> lods = builder.lods;
+        if(lods.empty()){
+            lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.f});
+        }
+        uint32_t* lod0 = indices.data() + lods[0].firstIndex;
+        CacheStats before = analyzeVertexCache(lod0, lods[0].indexCount, vertices.size());
+
+        for(const ODModel::Lod& lod : lods){
+            uint32_t* lodIndices = indices.data() + lod.firstIndex;
+            optimizeVertexCache(lodIndices, lod.indexCount, vertices.size());
+            optimizeOverdraw(lodIndices, lod.indexCount, &vertices[0].position.x, sizeof(ODModel::Vertex),
+                vertices.size());
+        }
+        // coarser LODs only use vertices of LOD0, so first use over the whole stream is LOD0's order
+        vertices.resize(optimizeVertexFetch(vertices.data(), vertices.size(), sizeof(ODModel::Vertex),
+            indices.data(), indices.size()));
+
+        CacheStats after = analyzeVertexCache(lod0, lods[0].indexCount, vertices.size());
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << "mesh optimizer: " << name << " (" << lods[0].indexCount / 3 << " triangles, "
+                  << lods.size() << " LODs)"
+                  << " ACMR " << before.acmr << " -> " << after.acmr
+                  << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    }
+
+    void ODMeshOptimizer::optimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount){
+        const size_t triangleCount = indexCount / 3;
+        if(triangleCount == 0){
+            return;
+        }
+
+        // triangles around each vertex, the first remaining[v] entries are the ones not emitted yet
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for(size_t i = 0; i < triangleCount * 3; i++){
+            remaining[indices[i]]++;
+        }
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for(size_t v = 0; v < vertexCount; v++){
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+        }
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(size_t i = 0; i < triangleCount * 3; i++){
+                adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++){
+            vertexScores[v] = vertexScore(-1, remaining[v]);
+        }
+
+        auto triangleScore = [&](uint32_t triangle){
+            return vertexScores[indices[triangle * 3 + 0]]
+                + vertexScores[indices[triangle * 3 + 1]]
+                + vertexScores[indices[triangle * 3 + 2]];
+        };
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        int64_t best = 0;
+        for(uint32_t t = 0; t < triangleCount; t++){
+            triangleScores[t] = triangleScore(t);
+            if(triangleScores[t] > triangleScores[best]){
+                best = t;
+            }
+        }
+
+        std::vector<uint32_t> output(triangleCount * 3);
+        uint32_t cache[CACHE_SIZE + 3];
+        uint32_t cacheCount = 0;
+        size_t deadEndCursor = 0;
+
+        for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++){
+            if(best < 0){
+                // no triangle touches the cache anymore, restart from the next one in input order
+                while(emitted[deadEndCursor]){
+                    deadEndCursor++;
+                }
+                best = static_cast<int64_t>(deadEndCursor);
+            }
+
+            const uint32_t triangle = static_cast<uint32_t>(best);
+            emitted[triangle] = true;
+            const uint32_t* corners = &indices[triangle * 3];
+            std::memcpy(&output[emittedCount * 3], corners, 3 * sizeof(uint32_t));
+
+            for(int c = 0; c < 3; c++){
+                const uint32_t v = corners[c];
+                uint32_t* live = &adjacency[adjacencyOffsets[v]];
+                uint32_t* last = live + remaining[v] - 1;
+                std::iter_swap(std::find(live, last + 1, triangle), last);
+                remaining[v]--;
+            }
+
+            // LRU: the triangle's vertices move to the front, the rest shift down
+            uint32_t newCache[CACHE_SIZE + 3];
+            uint32_t newCount = 0;
+            for(int c = 0; c < 3; c++){
+                if(std::find(newCache, newCache + newCount, corners[c]) == newCache + newCount){
+                    newCache[newCount++] = corners[c];
+                }
+            }
+            uint32_t* triangleEnd = newCache + newCount;
+            for(uint32_t i = 0; i < cacheCount; i++){
+                if(std::find(newCache, triangleEnd, cache[i]) == triangleEnd){
+                    newCache[newCount++] = cache[i];
+                }
+            }
+
+            for(uint32_t i = 0; i < newCount; i++){
+                const uint32_t v = newCache[i];
+                cachePosition[v] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertexScores[v] = vertexScore(cachePosition[v], remaining[v]);
+            }
+
+            // rescore around every touched vertex (evicted ones too), pick among the cached ones
+            best = -1;
+            float bestScore = -std::numeric_limits<float>::max();
+            for(uint32_t i = 0; i < newCount; i++){
+                const uint32_t v = newCache[i];
+                for(uint32_t a = 0; a < remaining[v]; a++){
+                    const uint32_t t = adjacency[adjacencyOffsets[v] + a];
+                    triangleScores[t] = triangleScore(t);
+                    if(i < CACHE_SIZE && triangleScores[t] > bestScore){
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCount, CACHE_SIZE);
+            std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+        }
+
+        std::memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+    }
+
+    // Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+    void ODMeshOptimizer::optimizeOverdraw(uint32_t *indices, size_t indexCount, const float *positions,
+        size_t positionStride, size_t vertexCount, float threshold){
+        const size_t triangleCount = indexCount / 3;
+        if(triangleCount < 2){
+            return;
+        }
+
+        auto position = [&](uint32_t v){
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        // hard boundaries: the cache order restarts wherever a triangle misses on all three vertices
+        std::vector<uint32_t> triangleMisses(triangleCount);
+        std::vector<uint32_t> hardBoundaries;
+        {
+            FifoCache cache(vertexCount, ANALYSIS_CACHE_SIZE);
+            for(uint32_t t = 0; t < triangleCount; t++){
+                uint32_t misses = cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1])
+                    + cache.access(indices[t * 3 + 2]);
+                triangleMisses[t] = misses;
+                if(t == 0 || misses == 3){
+                    hardBoundaries.push_back(t);
+                }
+            }
+            hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+        }
+
+        // soft boundaries: split a cluster as soon as the part since the last split is within
+        // threshold of the whole cluster's ACMR, the extra cache misses stay bounded
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache(vertexCount, ANALYSIS_CACHE_SIZE);
+            for(size_t h = 0; h + 1 < hardBoundaries.size(); h++){
+                const uint32_t start = hardBoundaries[h];
+                const uint32_t end = hardBoundaries[h + 1];
+
+                uint32_t clusterMisses = 0;
+                for(uint32_t t = start; t < end; t++){
+                    clusterMisses += triangleMisses[t];
+                }
+                const float limit = float(clusterMisses) / float(end - start) * threshold;
+
+                cache.flush();
+                clusters.push_back(start);
+                uint32_t softStart = start;
+                uint32_t softMisses = 0;
+                for(uint32_t t = start; t + 1 < end; t++){
+                    softMisses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1])
+                        + cache.access(indices[t * 3 + 2]);
+                    if(float(softMisses) / float(t + 1 - softStart) <= limit){
+                        clusters.push_back(t + 1);
+                        softStart = t + 1;
+                        softMisses = 0;
+                        cache.flush();
+                    }
+                }
+            }
+            clusters.push_back(static_cast<uint32_t>(triangleCount));
+        }
+
+        const size_t clusterCount = clusters.size() - 1;
+        if(clusterCount < 2){
+            return;
+        }
+
+        // clusters facing away from the mesh center are likely in front, draw them first
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3{0.f});
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{0.f});
+        std::vector<float> clusterAreas(clusterCount, 0.f);
+        glm::vec3 meshCentroid{0.f};
+        float meshArea = 0.f;
+        for(size_t c = 0; c < clusterCount; c++){
+            for(uint32_t t = clusters[c]; t < clusters[c + 1]; t++){
+                glm::vec3 p0 = position(indices[t * 3 + 0]);
+                glm::vec3 p1 = position(indices[t * 3 + 1]);
+                glm::vec3 p2 = position(indices[t * 3 + 2]);
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.f);
+                clusterNormals[c] += normal;
+                clusterAreas[c] += area;
+            }
+            meshCentroid += clusterCentroids[c];
+            meshArea += clusterAreas[c];
+        }
+        if(!(meshArea > 0.f)){
+            return;
+        }
+        meshCentroid /= meshArea;
+
+        std::vector<float> sortKeys(clusterCount, 0.f);
+        for(size_t c = 0; c < clusterCount; c++){
+            float normalLength = glm::length(clusterNormals[c]);
+            if(clusterAreas[c] > 0.f && normalLength > 0.f){
+                glm::vec3 centroid = clusterCentroids[c] / clusterAreas[c];
+                sortKeys[c] = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+            }
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        for(uint32_t c = 0; c < clusterCount; c++){
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+        for(uint32_t c : order){
+            output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+        }
+        std::memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+    }
+
+    size_t ODMeshOptimizer::optimizeVertexFetch(void *vertices, size_t vertexCount, size_t vertexStride,
+        uint32_t *indices, size_t indexCount){
+        std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+        uint32_t nextVertex = 0;
+        for(size_t i = 0; i < indexCount; i++){
+            uint32_t& slot = remap[indices[i]];
+            if(slot == UINT32_MAX){
+                slot = nextVertex++;
+            }
+            indices[i] = slot;
+        }
+
+        uint8_t* bytes = static_cast<uint8_t*>(vertices);
+        std::vector<uint8_t> source(bytes, bytes + vertexCount * vertexStride);
+        for(size_t v = 0; v < vertexCount; v++){
+            if(remap[v] != UINT32_MAX){
+                std::memcpy(bytes + remap[v] * vertexStride, source.data() + v * vertexStride, vertexStride);
+            }
+        }
+        return nextVertex;
+    }
+
+    ODMeshOptimizer::CacheStats ODMeshOptimizer::analyzeVertexCache(const uint32_t *indices, size_t indexCount,
+        size_t vertexCount, uint32_t cacheSize){
+        CacheStats stats{};
+        const size_t triangleCount = indexCount / 3;
+        if(triangleCount == 0){
+            return stats;
+        }
+
+        FifoCache cache(vertexCount, cacheSize);
+        std::vector<bool> referenced(vertexCount, false);
+        size_t misses = 0;
+        size_t uniqueVertices = 0;
+        for(size_t i = 0; i < triangleCount * 3; i++){
+            misses += cache.access(indices[i]);
+            if(!referenced[indices[i]]){
+                referenced[indices[i]] = true;
+                uniqueVertices++;
+            }
+        }
+
+        stats.acmr = float(misses) / float(triangleCount);
+        stats.atvr = float(misses) / float(uniqueVertices);
+        return stats;
+    }
+}
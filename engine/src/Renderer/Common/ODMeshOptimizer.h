@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ODModel.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ODEngine {
+
+    /*
+     * Post-load reordering of indexed triangle lists for the GPU caches, run on import
+     * before the mesh is written to its .odmesh cache:
+     *  1. optimizeVertexCache: Forsyth's greedy triangle order for the post-transform cache
+     *  2. optimizeOverdraw: splits that order in clusters and draws outward facing clusters first
+     *  3. optimizeVertexFetch: renumbers vertices in first-use order so fetches stream linearly
+     */
+    class ODMeshOptimizer {
+        public:
+            struct CacheStats {
+                float acmr = 0.f; // transformed vertices per triangle, 0.5 at best, 3 at worst
+                float atvr = 0.f; // transformed vertices per referenced vertex, 1 at best
+            };
+
+            // FIFO size used to simulate the post-transform cache when reporting
+            static constexpr uint32_t ANALYSIS_CACHE_SIZE = 16;
+            // LRU size modelled by the Forsyth scoring
+            static constexpr uint32_t OPTIMIZER_CACHE_SIZE = 32;
+
+            // Runs the three steps on the builder in place, each LOD range being reordered on
+            // its own, and prints LOD0's ACMR/ATVR before and after
+            static void optimize(ODModel::Builder& builder, const std::string& name);
+
+            static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+            // threshold: how much worse than its parent cluster's ACMR a sub-cluster may get,
+            // bigger values give more, smaller clusters to sort
+            static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions,
+                size_t positionStride, size_t vertexCount, float threshold = 1.05f);
+            // Reorders the vertices (vertexStride bytes each) and rewrites the indices,
+            // unreferenced vertices are dropped. Returns the new vertex count.
+            static size_t optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride,
+                uint32_t* indices, size_t indexCount);
+
+            static CacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                uint32_t cacheSize = ANALYSIS_CACHE_SIZE);
+    };
+}
@@ -0,0 +1,305 @@
+#include "ODMeshSimplifier.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace ODEngine {
+
+    namespace {
+        // Garland & Heckbert plane quadric, sum of w * (n.p + d)^2 over the planes it holds
+        struct Quadric {
+            double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+            double b0 = 0, b1 = 0, b2 = 0;
+            double c = 0;
+            double weight = 0;
+
+            void addPlane(const glm::dvec3& n, double d, double w){
+                a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+                a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+                b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+                c += w * d * d;
+                weight += w;
+            }
+
+            Quadric& operator+=(const Quadric& o){
+                a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+                b0 += o.b0; b1 += o.b1; b2 += o.b2;
+                c += o.c;
+                weight += o.weight;
+                return *this;
+            }
+
+            // weighted mean squared distance of p to the planes
+            double error(const glm::vec3& p) const {
+                if(weight <= 0.0){
+                    return 0.0;
+                }
+                double x = p.x, y = p.y, z = p.z;
+                double sum = a00 * x * x + a11 * y * y + a22 * z * z
+                    + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                    + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+                return std::max(sum, 0.0) / weight;
+            }
+        };
+
+        struct Collapse {
+            uint32_t from;
+            uint32_t to;
+            float error; // squared
+        };
+
+        uint64_t edgeKey(uint32_t a, uint32_t b){
+            return a < b ? (uint64_t{a} << 32) | b : (uint64_t{b} << 32) | a;
+        }
+
+        struct PositionKey {
+            uint32_t bits[3];
+            bool operator==(const PositionKey& o) const { return std::memcmp(bits, o.bits, sizeof(bits)) == 0; }
+        };
+
+        struct PositionKeyHash {
+            size_t operator()(const PositionKey& key) const {
+                uint64_t h = 0x9e3779b97f4a7c15ull;
+                for(uint32_t bits : key.bits){
+                    h = (h ^ bits) * 0xff51afd7ed558ccdull;
+                    h ^= h >> 32;
+                }
+                return static_cast<size_t>(h);
+            }
+        };
+    }
+
+    void ODMeshSimplifier::generateLods(ODModel::Builder &builder){
+        const size_t baseIndexCount = builder.indices.size();
+        builder.lods.clear();
+        builder.lods.push_back({0, static_cast<uint32_t>(baseIndexCount), 0.f});
+        if(baseIndexCount / 3 < MIN_LOD_TRIANGLES * 2 || builder.vertices.empty()){
+            return;
+        }
+
+        glm::vec3 boundsMin, boundsMax;
+        builder.computeBounds(boundsMin, boundsMax);
+        const float maxError = MAX_LOD_ERROR * 0.5f * glm::length(boundsMax - boundsMin);
+
+        // every LOD is simplified from LOD0 so its error is measured against the real surface
+        const std::vector<uint32_t> base(builder.indices.begin(), builder.indices.end());
+        size_t previousCount = baseIndexCount;
+        float targetRatio = 1.f;
+        while(builder.lods.size() < ODModel::MAX_LODS){
+            targetRatio *= LOD_REDUCTION;
+            size_t targetIndexCount = static_cast<size_t>(baseIndexCount / 3 * targetRatio) * 3;
+            if(targetIndexCount / 3 < MIN_LOD_TRIANGLES){
+                break;
+            }
+
+            float error = 0.f;
+            std::vector<uint32_t> lod = simplify(base.data(), base.size(), &builder.vertices[0].position.x,
+                sizeof(ODModel::Vertex), builder.vertices.size(), targetIndexCount, maxError, &error);
+            if(lod.empty() || static_cast<float>(lod.size()) > static_cast<float>(previousCount) * (1.f - MIN_LOD_GAIN)){
+                break;
+            }
+
+            builder.lods.push_back({static_cast<uint32_t>(builder.indices.size()), static_cast<uint32_t>(lod.size()),
+                std::max(error, builder.lods.back().error)});
+            builder.indices.insert(builder.indices.end(), lod.begin(), lod.end());
+            previousCount = lod.size();
+        }
+    }
+
+    std::vector<uint32_t> ODMeshSimplifier::simplify(const uint32_t *indices, size_t indexCount, const float *positions,
+        size_t positionStride, size_t vertexCount, size_t targetIndexCount, float targetError, float *resultError){
+        auto position = [&](uint32_t v){
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        std::vector<uint32_t> result(indices, indices + indexCount / 3 * 3);
+        float maxError = 0.f;
+
+        // locked vertices: open border edges (in index space, so attribute seams count as borders)
+        // and positions shared by several vertices
+        std::vector<bool> locked(vertexCount, false);
+        {
+            std::vector<uint64_t> edges;
+            edges.reserve(result.size());
+            for(size_t t = 0; t < result.size(); t += 3){
+                for(int e = 0; e < 3; e++){
+                    edges.push_back(edgeKey(result[t + e], result[t + (e + 1) % 3]));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for(size_t i = 0; i < edges.size();){
+                size_t run = i + 1;
+                while(run < edges.size() && edges[run] == edges[i]){
+                    run++;
+                }
+                if(run - i == 1){
+                    locked[edges[i] >> 32] = true;
+                    locked[edges[i] & 0xffffffffu] = true;
+                }
+                i = run;
+            }
+
+            std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstAtPosition;
+            firstAtPosition.reserve(vertexCount);
+            for(uint32_t v = 0; v < vertexCount; v++){
+                glm::vec3 p = position(v);
+                PositionKey key{};
+                std::memcpy(key.bits, &p.x, sizeof(key.bits));
+                auto [it, inserted] = firstAtPosition.try_emplace(key, v);
+                if(!inserted){
+                    locked[v] = true;
+                    locked[it->second] = true;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for(size_t t = 0; t < result.size(); t += 3){
+            glm::dvec3 p0 = position(result[t + 0]);
+            glm::dvec3 p1 = position(result[t + 1]);
+            glm::dvec3 p2 = position(result[t + 2]);
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if(length <= 0.0){
+                continue;
+            }
+            normal /= length;
+            double d = -glm::dot(normal, p0);
+            for(int c = 0; c < 3; c++){
+                quadrics[result[t + c]].addPlane(normal, d, length * 0.5);
+            }
+        }
+
+        const float targetErrorSquared = targetError * targetError;
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> passRemap(vertexCount);
+        std::vector<bool> passLocked(vertexCount);
+
+        while(result.size() > targetIndexCount){
+            const size_t triangleCount = result.size() / 3;
+
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for(uint32_t v : result){
+                adjacencyOffsets[v + 1]++;
+            }
+            for(size_t v = 0; v < vertexCount; v++){
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for(size_t i = 0; i < result.size(); i++){
+                    adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            // cheapest direction of every edge, shared edges show up twice which is harmless
+            collapses.clear();
+            for(size_t t = 0; t < result.size(); t += 3){
+                for(int e = 0; e < 3; e++){
+                    uint32_t a = result[t + e];
+                    uint32_t b = result[t + (e + 1) % 3];
+                    if(a > b){
+                        continue; // the neighbour triangle sees this edge as (b, a)
+                    }
+                    Quadric merged = quadrics[a];
+                    merged += quadrics[b];
+                    float toB = locked[a] ? INFINITY : static_cast<float>(merged.error(position(b)));
+                    float toA = locked[b] ? INFINITY : static_cast<float>(merged.error(position(a)));
+                    if(toB <= toA && toB != INFINITY){
+                        collapses.push_back({a, b, toB});
+                    } else if(toA != INFINITY){
+                        collapses.push_back({b, a, toA});
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(),
+                [](const Collapse& x, const Collapse& y){ return x.error < y.error; });
+
+            for(uint32_t v = 0; v < vertexCount; v++){
+                passRemap[v] = v;
+            }
+            std::fill(passLocked.begin(), passLocked.end(), false);
+
+            size_t remainingTriangles = triangleCount;
+            const size_t targetTriangles = targetIndexCount / 3;
+            size_t collapseCount = 0;
+            for(const Collapse& collapse : collapses){
+                if(collapse.error > targetErrorSquared || remainingTriangles <= targetTriangles){
+                    break;
+                }
+                const uint32_t a = collapse.from;
+                const uint32_t b = collapse.to;
+                if(passLocked[a] || passLocked[b]){
+                    continue;
+                }
+
+                // reject collapses flipping a triangle that survives them
+                bool flips = false;
+                size_t removedTriangles = 0;
+                const glm::vec3 target = position(b);
+                for(uint32_t i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1] && !flips; i++){
+                    const uint32_t* corners = &result[adjacency[i] * 3];
+                    if(corners[0] == b || corners[1] == b || corners[2] == b){
+                        removedTriangles++;
+                        continue;
+                    }
+                    glm::vec3 p[3];
+                    glm::vec3 moved[3];
+                    for(int c = 0; c < 3; c++){
+                        p[c] = position(corners[c]);
+                        moved[c] = corners[c] == a ? target : p[c];
+                    }
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                    flips = glm::dot(before, after) <= 0.f;
+                }
+                if(flips){
+                    continue;
+                }
+
+                passRemap[a] = b;
+                quadrics[b] += quadrics[a];
+                maxError = std::max(maxError, collapse.error);
+                remainingTriangles -= std::min(removedTriangles, remainingTriangles);
+                collapseCount++;
+
+                // the one-ring of a changes shape, keep it fixed for the rest of the pass so
+                // the flip test above always sees current triangles
+                passLocked[b] = true;
+                for(uint32_t i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++){
+                    const uint32_t* corners = &result[adjacency[i] * 3];
+                    passLocked[corners[0]] = passLocked[corners[1]] = passLocked[corners[2]] = true;
+                }
+            }
+
+            if(collapseCount == 0){
+                break;
+            }
+
+            size_t write = 0;
+            for(size_t t = 0; t < result.size(); t += 3){
+                uint32_t i0 = passRemap[result[t + 0]];
+                uint32_t i1 = passRemap[result[t + 1]];
+                uint32_t i2 = passRemap[result[t + 2]];
+                if(i0 != i1 && i1 != i2 && i0 != i2){
+                    result[write++] = i0;
+                    result[write++] = i1;
+                    result[write++] = i2;
+                }
+            }
+            result.resize(write);
+        }
+
+        if(resultError){
+            *resultError = std::sqrt(maxError);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ODModel.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ODEngine {
+
+    /*
+     * Quadric error edge-collapse simplifier. Vertices are only ever collapsed onto a
+     * neighbour, never moved, so every LOD indexes the vertex array of LOD0 and all
+     * LODs share one vertex range in the geometry pool.
+     *
+     * Vertices on open borders and on attribute seams (a position shared by several
+     * vertices with different normal/uv/color, which the importer splits apart) are
+     * locked: they can receive collapses but never move, so seams stay watertight.
+     */
+    class ODMeshSimplifier {
+        public:
+            // LOD n aims for half the triangles of LOD n-1
+            static constexpr float LOD_REDUCTION = 0.5f;
+            // a LOD that removes less than this fraction of the previous one ends the chain
+            static constexpr float MIN_LOD_GAIN = 0.15f;
+            static constexpr size_t MIN_LOD_TRIANGLES = 64;
+            // relative to the bounding sphere radius
+            static constexpr float MAX_LOD_ERROR = 0.1f;
+
+            // Appends LOD1..n after the LOD0 indices and fills builder.lods (LOD0 included)
+            static void generateLods(ODModel::Builder& builder);
+
+            // Returns at most targetIndexCount indices (more when targetError or the locked
+            // vertices stop it first). resultError receives the largest collapse error, in
+            // object space units.
+            static std::vector<uint32_t> simplify(const uint32_t* indices, size_t indexCount, const float* positions,
+                size_t positionStride, size_t vertexCount, size_t targetIndexCount, float targetError,
+                float* resultError = nullptr);
+    };
+}
@@ -0,0 +1,122 @@
+#include "ODMeshletBuilder.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ODEngine {
+
+    void ODMeshletBuilder::buildMeshlets(ODModel::Builder &builder){
+        builder.meshlets.clear();
+        if(builder.lods.empty()){
+            builder.lods.push_back({0, static_cast<uint32_t>(builder.indices.size()), 0.f});
+        }
+        if(builder.vertices.empty()){
+            return;
+        }
+
+        // stamp[v] == current meshlet id when v is already one of its vertices
+        std::vector<uint32_t> stamp(builder.vertices.size(), UINT32_MAX);
+        auto closeMeshlet = [&](uint32_t begin, uint32_t end){
+            builder.meshlets.push_back(computeBounds(builder.vertices.data(), builder.indices.data(), begin, end - begin));
+        };
+
+        for(ODModel::Lod& lod : builder.lods){
+            lod.firstMeshlet = static_cast<uint32_t>(builder.meshlets.size());
+
+            const uint32_t end = lod.firstIndex + lod.indexCount / 3 * 3;
+            uint32_t begin = lod.firstIndex;
+            uint32_t meshletVertices = 0;
+            for(uint32_t t = lod.firstIndex; t < end; t += 3){
+                const uint32_t* corners = &builder.indices[t];
+                auto newVertices = [&](uint32_t id){
+                    uint32_t count = 0;
+                    for(int c = 0; c < 3; c++){
+                        bool repeated = (c > 0 && corners[c] == corners[0]) || (c > 1 && corners[c] == corners[1]);
+                        count += stamp[corners[c]] != id && !repeated;
+                    }
+                    return count;
+                };
+
+                uint32_t id = static_cast<uint32_t>(builder.meshlets.size());
+                uint32_t added = newVertices(id);
+                if(meshletVertices + added > MAX_MESHLET_VERTICES || (t - begin) / 3 >= MAX_MESHLET_TRIANGLES){
+                    closeMeshlet(begin, t);
+                    id++;
+                    begin = t;
+                    meshletVertices = 0;
+                    added = newVertices(id);
+                }
+                for(int c = 0; c < 3; c++){
+                    stamp[corners[c]] = id;
+                }
+                meshletVertices += added;
+            }
+            if(end > begin){
+                closeMeshlet(begin, end);
+            }
+
+            lod.meshletCount = static_cast<uint32_t>(builder.meshlets.size()) - lod.firstMeshlet;
+        }
+    }
+
+    ODModel::Meshlet ODMeshletBuilder::computeBounds(const ODModel::Vertex *vertices, const uint32_t *indices,
+        uint32_t firstIndex, uint32_t indexCount){
+        ODModel::Meshlet meshlet{};
+        meshlet.firstIndex = firstIndex;
+        meshlet.indexCount = indexCount;
+        const uint32_t* triangle = indices + firstIndex;
+
+        glm::vec3 boundsMin = vertices[triangle[0]].position;
+        glm::vec3 boundsMax = boundsMin;
+        for(uint32_t i = 0; i < indexCount; i++){
+            boundsMin = glm::min(boundsMin, vertices[triangle[i]].position);
+            boundsMax = glm::max(boundsMax, vertices[triangle[i]].position);
+        }
+        glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+        float radius = 0.f;
+        for(uint32_t i = 0; i < indexCount; i++){
+            radius = std::max(radius, glm::length(vertices[triangle[i]].position - center));
+        }
+        meshlet.sphere = glm::vec4(center, radius);
+
+        // Face normals, oriented like the vertex normals so the cone does not depend on the
+        // winding convention (meshes without normals keep their counter-clockwise normal)
+        std::vector<glm::vec3> normals;
+        normals.reserve(indexCount / 3);
+        glm::vec3 axis{0.f};
+        for(uint32_t t = 0; t + 2 < indexCount; t += 3){
+            const ODModel::Vertex& v0 = vertices[triangle[t + 0]];
+            const ODModel::Vertex& v1 = vertices[triangle[t + 1]];
+            const ODModel::Vertex& v2 = vertices[triangle[t + 2]];
+            glm::vec3 normal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+            float area = glm::length(normal);
+            if(area <= 0.f){
+                continue;
+            }
+            normal /= area;
+            if(glm::dot(normal, v0.normal + v1.normal + v2.normal) < 0.f){
+                normal = -normal;
+            }
+            normals.push_back(normal);
+            axis += normal * area;
+        }
+
+        float axisLength = glm::length(axis);
+        if(normals.empty() || axisLength <= 1e-6f){
+            meshlet.cone = glm::vec4(0.f, 0.f, 0.f, 1.f);
+            return meshlet;
+        }
+        axis /= axisLength;
+        float minCos = 1.f;
+        for(const glm::vec3& normal : normals){
+            minCos = std::min(minCos, glm::dot(axis, normal));
+        }
+        // sin of the half angle: the cone is backfacing when its axis points away from the
+        // camera by more than that angle (plus the angle the sphere covers)
+        float sinAngle = minCos <= MIN_CONE_COS ? 1.f : std::sqrt(std::max(0.f, 1.f - minCos * minCos));
+        meshlet.cone = glm::vec4(axis, sinAngle);
+        return meshlet;
+    }
+}
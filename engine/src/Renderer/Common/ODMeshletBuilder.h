@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ODModel.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace ODEngine {
+
+    /*
+     * Splits every LOD of an optimized mesh in meshlets: runs of consecutive triangles
+     * touching at most MAX_MESHLET_VERTICES distinct vertices. The triangle order is not
+     * changed, a meshlet is only a (firstIndex, indexCount) range of the index stream, so
+     * culled meshlets are drawn with plain indexed draws and no mesh shader support.
+     * Run after ODMeshOptimizer: its cache-friendly order keeps consecutive triangles
+     * close together, which gives tight bounds.
+     */
+    class ODMeshletBuilder {
+        public:
+            static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+            static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+            // a cone wider than this (cos of the half angle) is never backfacing as a whole
+            static constexpr float MIN_CONE_COS = 0.1f;
+
+            // Fills builder.meshlets and the meshlet range of each LOD (LOD0 only when
+            // builder.lods is empty)
+            static void buildMeshlets(ODModel::Builder& builder);
+
+            // Bounding sphere and normal cone of indexCount indices, firstIndex being stored as is
+            static ODModel::Meshlet computeBounds(const ODModel::Vertex* vertices, const uint32_t* indices,
+                uint32_t firstIndex, uint32_t indexCount);
+    };
+}
@@ -1,4 +1,10 @@
 #include "ODModel.h"
+#include "ODMeshCache.h"
+#include "ODMeshletBuilder.h"
+#include "ODMeshOptimizer.h"
+#include "ODMeshSimplifier.h"
+#include "ODVertexCompression.h"
+#include "Utils/ODThreadPool.h"
 #include "Utils/ODUtils.h"
 #include "../Vulkan/ODSwapChain.h"
 
@@ -9,9 +15,16 @@
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <thread>
 #include<unordered_map>
 
 namespace std {
@@ -27,174 +40,548 @@ namespace std {
 
 namespace ODEngine {
 
-    ODModel::ODModel(ODDevice & device, const ODModel::Builder &builder):m_device(device){
-       createVertexBuffer(builder.vertices); 
-       createIndexBuffer(builder.indices);
+    ODModel::ODModel(ODDevice & device, const ODModel::Builder &builder, const ODVertexCompressionSettings &compression)
+        :m_device(device){
+        glm::vec3 boundsMin, boundsMax;
+        builder.computeBounds(boundsMin, boundsMax);
+        init(builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()), builder.indices.data(),
+            static_cast<uint32_t>(builder.indices.size()), builder.lods.data(), static_cast<uint32_t>(builder.lods.size()),
+            builder.meshlets.data(), static_cast<uint32_t>(builder.meshlets.size()), boundsMin, boundsMax, compression);
     }
 
-    ODModel::~ODModel(){
+    ODModel::ODModel(ODDevice &device, const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices,
+        uint32_t indexCount, const Lod *lods, uint32_t lodCount, const Meshlet *meshlets, uint32_t meshletCount,
+        const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const ODVertexCompressionSettings &compression)
+        :m_device(device){
+        init(vertices, vertexCount, indices, indexCount, lods, lodCount, meshlets, meshletCount, boundsMin, boundsMax,
+            compression);
     }
 
-    void ODModel::createVertexBuffer(const std::vector<Vertex> &vertices){
-        m_vertexCount = static_cast<uint32_t>(vertices.size());
+    void ODModel::init(const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+        const Lod *lods, uint32_t lodCount, const Meshlet *meshlets, uint32_t meshletCount, const glm::vec3 &boundsMin,
+        const glm::vec3 &boundsMax, const ODVertexCompressionSettings &compression){
+        m_vertexCount = vertexCount;
         assert(m_vertexCount >= 3 && "Vertex count must be at least 3 for a valid model.");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * m_vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
-
-        ODBuffer stagingBuffer{
-            m_device,
-            vertexSize,
-            m_vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-        
-       stagingBuffer.map();
-       stagingBuffer.writeToBuffer((void*)vertices.data());
-
-       m_vertexBuffer = std::make_unique<ODBuffer>(
-            m_device,
-            vertexSize,
-            m_vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
-        m_device.copyBuffer(stagingBuffer.getBuffer(), m_vertexBuffer->getBuffer(), bufferSize);
+        m_indexCount = indexCount;
+        m_hasIndexBuffer = m_indexCount > 0;
+        if(lodCount > 0){
+            m_lods.assign(lods, lods + lodCount);
+        } else {
+            m_lods.push_back({0, m_indexCount, 0.f});
+        }
+        m_boundsMin = boundsMin;
+        m_boundsMax = boundsMax;
+        // tighter than half the box diagonal for rounded shapes
+        glm::vec3 center = getBoundsCenter();
+        float radiusSquared = 0.f;
+        for(uint32_t i = 0; i < vertexCount; i++){
+            glm::vec3 offset = vertices[i].position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        m_boundsRadius = std::sqrt(radiusSquared);
 
-    }
+        if(meshletCount > 0){
+            // read by meshlet_cull.comp only, the pool's vertex buffers are storage buffers too
+            m_meshlets = m_device.geometryPool().allocate(sizeof(Meshlet), meshletCount, meshlets, 0,
+                static_cast<const uint32_t*>(nullptr));
+        }
 
-    void ODModel::createIndexBuffer(const std::vector<uint32_t> &indices){
-        m_indexCount = static_cast<uint32_t>(indices.size());
-        m_hasIndexBuffer = m_indexCount > 0;
+        // positions and the other attributes go to separate streams
+        ODVertexStreams streams{};
+        std::vector<glm::vec3> positions;
+        std::vector<VertexAttributes> attributes;
+        std::vector<std::array<uint16_t, 4>> compactPositions;
+        std::vector<CompactAttributes> compactAttributes;
+        ODCompressedVertices compressed{};
+        if(compression.enabled && compressVertices(vertices, vertexCount, boundsMin, boundsMax, compression, compressed)){
+            m_compact = true;
+            m_dequantize = compressed.dequantize;
+            compactPositions.resize(vertexCount);
+            compactAttributes.resize(vertexCount);
+            for(uint32_t i = 0; i < vertexCount; i++){
+                const CompactVertex& vertex = compressed.vertices[i];
+                std::copy(std::begin(vertex.position), std::end(vertex.position), compactPositions[i].begin());
+                compactAttributes[i] = {vertex.normal, vertex.uv, vertex.color};
+            }
+            streams = {sizeof(compactPositions[0]), compactPositions.data(), sizeof(CompactAttributes),
+                compactAttributes.data()};
+        } else {
+            positions.resize(vertexCount);
+            attributes.resize(vertexCount);
+            for(uint32_t i = 0; i < vertexCount; i++){
+                positions[i] = vertices[i].position;
+                attributes[i] = {vertices[i].color, vertices[i].normal, vertices[i].uv};
+            }
+            streams = {sizeof(glm::vec3), positions.data(), sizeof(VertexAttributes), attributes.data()};
+        }
 
-        if(!m_hasIndexBuffer){
+        // uint16 indices whenever every vertex is addressable, half the index memory and bandwidth
+        if(m_hasIndexBuffer && m_vertexCount <= MAX_UINT16_INDEXED_VERTICES){
+            std::vector<uint16_t> shortIndices(indices, indices + m_indexCount);
+            m_geometry = m_device.geometryPool().allocate(streams, m_vertexCount, m_indexCount, shortIndices.data());
             return;
         }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * m_indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        ODBuffer stagingBuffer{
-            m_device,
-            indexSize,
-            m_indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-        
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*)indices.data());
+        m_geometry = m_device.geometryPool().allocate(streams, m_vertexCount, m_indexCount, indices);
+    }
 
-        m_indexBuffer = std::make_unique<ODBuffer>(
-            m_device,
-            indexSize,
-            m_indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
+    ODModel::~ODModel(){
+        m_device.geometryPool().free(m_geometry);
+        m_device.geometryPool().free(m_meshlets);
+    }
 
-        m_device.copyBuffer(stagingBuffer.getBuffer(), m_indexBuffer->getBuffer(), bufferSize);
+    uint64_t ODModel::getMemorySize() const{
+        uint64_t vertexStride = m_compact ? sizeof(CompactVertex) : sizeof(Vertex);
+        return vertexStride * m_geometry.vertexCount +
+            uint64_t{ODGeometryPool::indexSize(m_geometry.indexType)} * m_geometry.indexCount +
+            sizeof(Meshlet) * uint64_t{m_meshlets.vertexCount};
     }
 
-    void ODModel::draw(VkCommandBuffer commandBuffer){
+    void ODModel::draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount){
         if(m_hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, m_indexCount, 1, 0, 0, 0);
+            const Lod& range = m_lods[std::min(lod, getLodCount() - 1)];
+            vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, m_geometry.firstIndex + range.firstIndex,
+                static_cast<int32_t>(m_geometry.firstVertex), 0);
         } else {
-            vkCmdDraw(commandBuffer, m_vertexCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, m_vertexCount, instanceCount, m_geometry.firstVertex, 0);
         }
     }
 
-    std::unique_ptr<ODModel> ODModel::createModelFromFile(ODDevice &device, const std::string &filepath){
+    VkDrawIndexedIndirectCommand ODModel::getDrawCommand(uint32_t lod, uint32_t firstInstance,
+        uint32_t instanceCount) const{
+        const Lod& range = m_lods[std::min(lod, getLodCount() - 1)];
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = range.indexCount;
+        command.instanceCount = instanceCount;
+        command.firstIndex = m_geometry.firstIndex + range.firstIndex;
+        command.vertexOffset = static_cast<int32_t>(m_geometry.firstVertex);
+        command.firstInstance = firstInstance;
+        return command;
+    }
+
+    std::unique_ptr<ODModel> ODModel::createModelFromFile(ODDevice &device, const std::string &filepath,
+        const ODVertexCompressionSettings &compression){
+        // a valid .odmesh cache is uploaded straight from its mapping, no parsing
+        ODMappedFile cacheFile;
+        ODMeshCache::View cache{};
+        if(ODMeshCache::load(filepath, cacheFile, cache)){
+            return std::make_unique<ODModel>(device, cache.vertices, cache.vertexCount, cache.indices,
+                cache.indexCount, cache.lods, cache.lodCount, cache.meshlets, cache.meshletCount, cache.boundsMin,
+                cache.boundsMax, compression);
+        }
+
         Builder builder {};
-        builder.loadModels(filepath);
-        return std::make_unique<ODModel>(device, builder);
+        builder.importFile(filepath);
+        return std::make_unique<ODModel>(device, builder, compression);
+    }
+
+    void ODModel::Builder::importFile(const std::string &filepath){
+        loadModels(filepath);
+        ODMeshSimplifier::generateLods(*this);
+        ODMeshOptimizer::optimize(*this, filepath);
+        ODMeshletBuilder::buildMeshlets(*this);
+        if(!ODMeshCache::write(filepath, *this)){
+            std::cerr << "failed to write mesh cache for " << filepath << std::endl;
+        }
+    }
+
+    bool ODModel::Builder::loadCache(const std::string &filepath){
+        ODMappedFile cacheFile;
+        ODMeshCache::View cache{};
+        if(!ODMeshCache::load(filepath, cacheFile, cache)){
+            return false;
+        }
+        vertices.assign(cache.vertices, cache.vertices + cache.vertexCount);
+        indices.assign(cache.indices, cache.indices + cache.indexCount);
+        lods.assign(cache.lods, cache.lods + cache.lodCount);
+        meshlets.assign(cache.meshlets, cache.meshlets + cache.meshletCount);
+        return true;
     }
 
     void ODModel::bind(VkCommandBuffer commandBuffer)
     {
-        VkBuffer buffers[] = {m_vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets); // record 1 vertex buffer at binding 0
+        m_device.geometryPool().bind(commandBuffer, m_geometry.arena);
+    }
 
-        if(m_hasIndexBuffer) {
-            vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    void ODModel::bindPositions(VkCommandBuffer commandBuffer)
+    {
+        m_device.geometryPool().bindPositions(commandBuffer, m_geometry.arena);
+    }
+
+    uint32_t ODModel::selectLod(float pixelsPerUnit, uint32_t currentLod, float pixelError, float hysteresis) const{
+        auto fits = [&](uint32_t lod, float threshold){ return m_lods[lod].error * pixelsPerUnit <= threshold; };
+
+        uint32_t lod = std::min(currentLod, getLodCount() - 1);
+        while(lod > 0 && !fits(lod, pixelError)){
+            lod--;
         }
+        while(lod + 1 < getLodCount() && fits(lod + 1, pixelError * (1.f - hysteresis))){
+            lod++;
+        }
+        return lod;
     }
 
     std::vector<VkVertexInputBindingDescription> ODModel::Vertex::getBindingDescriptions(){
-        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
-        bindingDescriptions[0].binding = 0;
-        bindingDescriptions[0].stride = sizeof(Vertex);
-        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
+        bindingDescriptions[0] = {0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX};
+        bindingDescriptions[1] = {1, sizeof(VertexAttributes), VK_VERTEX_INPUT_RATE_VERTEX};
         return bindingDescriptions;
     }
     
     std::vector<VkVertexInputAttributeDescription> ODModel::Vertex::getAttributeDescriptions(){
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)});
-        attributeDescriptions.push_back({1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)});
-        attributeDescriptions.push_back({2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)});
-        attributeDescriptions.push_back({3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)});
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0});
+        attributeDescriptions.push_back({1, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, color)});
+        attributeDescriptions.push_back({2, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, normal)});
+        attributeDescriptions.push_back({3, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexAttributes, uv)});
 
         return attributeDescriptions;
     }
 
-    void ODModel::Builder::loadModels(const std::string &filepath){
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+    std::vector<VkVertexInputBindingDescription> ODModel::Vertex::getPositionBindingDescriptions(){
+        return {{0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
+
+    std::vector<VkVertexInputAttributeDescription> ODModel::Vertex::getPositionAttributeDescriptions(){
+        return {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}};
+    }
+
+    std::vector<VkVertexInputBindingDescription> ODModel::CompactVertex::getBindingDescriptions(){
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
+        bindingDescriptions[0] = {0, sizeof(CompactVertex::position), VK_VERTEX_INPUT_RATE_VERTEX};
+        bindingDescriptions[1] = {1, sizeof(CompactAttributes), VK_VERTEX_INPUT_RATE_VERTEX};
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> ODModel::CompactVertex::getAttributeDescriptions(){
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        // same locations as Vertex, decoded in simple_shader_compact.vert
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, 0});
+        attributeDescriptions.push_back({1, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(CompactAttributes, color)});
+        attributeDescriptions.push_back({2, 1, VK_FORMAT_R16G16_SNORM, offsetof(CompactAttributes, normal)});
+        attributeDescriptions.push_back({3, 1, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactAttributes, uv)});
+
+        return attributeDescriptions;
+    }
+
+    std::vector<VkVertexInputBindingDescription> ODModel::CompactVertex::getPositionBindingDescriptions(){
+        return {{0, sizeof(CompactVertex::position), VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
 
-        if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())){
-            throw std::runtime_error(warn + err);
+    std::vector<VkVertexInputAttributeDescription> ODModel::CompactVertex::getPositionAttributeDescriptions(){
+        return {{0, 0, VK_FORMAT_R16G16B16A16_UNORM, 0}};
+    }
+
+    void ODModel::Builder::computeBounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const{
+        if(vertices.empty()){
+            boundsMin = boundsMax = glm::vec3{0.f};
+            return;
+        }
+        boundsMin = boundsMax = vertices[0].position;
+        for(const auto& vertex : vertices){
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
         }
+    }
+
+    namespace {
+        // below this many corners per thread the merge costs more than the parallel dedup saves
+        constexpr size_t MIN_CORNERS_PER_CHUNK = 16384;
+
+        void parseObj(const std::string& filepath, tinyobj::attrib_t& attrib, std::vector<tinyobj::shape_t>& shapes){
+            std::vector<tinyobj::material_t> materials;
+            std::string warn, err;
 
-        vertices.clear();
-        indices.clear();
+            if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())){
+                throw std::runtime_error(warn + err);
+            }
+        }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        ODModel::Vertex makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index){
+            ODModel::Vertex vertex{};
+
+            if(index.vertex_index >= 0){
+                vertex.position = {
+                    attrib.vertices[3 * index.vertex_index + 0],
+                    attrib.vertices[3 * index.vertex_index + 1],
+                    attrib.vertices[3 * index.vertex_index + 2]
+                };
+
+                vertex.color = {
+                    attrib.colors[3 * index.vertex_index + 0],
+                    attrib.colors[3 * index.vertex_index + 1],
+                    attrib.colors[3 * index.vertex_index + 2]
+                };
+            }
 
-        for(const auto& shape : shapes){
-            for(const auto& index : shape.mesh.indices){
-                Vertex vertex{};
+            if(index.normal_index >= 0){
+                vertex.normal = {
+                    attrib.normals[3 * index.normal_index + 0],
+                    attrib.normals[3 * index.normal_index + 1],
+                    attrib.normals[3 * index.normal_index + 2]
+                };
+            }
 
-                if(index.vertex_index >= 0){
-                    vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
-                    };
+            if(index.texcoord_index >= 0){
+                vertex.uv = {
+                    attrib.texcoords[2 * index.texcoord_index + 0],
+                    1.0 - attrib.texcoords[2 * index.texcoord_index + 1] // ou 1.0f - ... ?
+                };
+            }
+            return vertex;
+        }
 
-                    vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2]
-                    };
+        // Hash consistent with Vertex::operator== : -0.f and 0.f compare equal so they must hash the same
+        uint32_t hashVertex(const ODModel::Vertex& vertex){
+            const float components[] = {
+                vertex.position.x, vertex.position.y, vertex.position.z,
+                vertex.color.x, vertex.color.y, vertex.color.z,
+                vertex.normal.x, vertex.normal.y, vertex.normal.z,
+                vertex.uv.x, vertex.uv.y
+            };
+            uint64_t hash = 0x9e3779b97f4a7c15ull;
+            for(float component : components){
+                uint32_t bits = 0;
+                if(component != 0.f){
+                    std::memcpy(&bits, &component, sizeof(bits));
+                }
+                hash = (hash ^ bits) * 0xff51afd7ed558ccdull;
+                hash ^= hash >> 32;
+            }
+            return static_cast<uint32_t>(hash);
+        }
+
+        // Open addressing (linear probing) table of indices into a vertex array. Slots only hold
+        // the hash and the index so a probe sequence stays within a few cache lines.
+        class VertexTable {
+            public:
+                explicit VertexTable(size_t expectedCount){
+                    size_t capacity = 16;
+                    while(capacity < expectedCount * 2){
+                        capacity <<= 1;
+                    }
+                    m_slots.assign(capacity, Slot{});
+                    m_mask = capacity - 1;
                 }
 
-                if(index.normal_index >= 0){
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
+                // Returns the index of the vertex equal to vertex, or registers candidate (the index
+                // vertex will get once the caller appends it to vertices) and returns it.
+                uint32_t findOrInsert(uint32_t hash, const ODModel::Vertex& vertex, uint32_t candidate,
+                    const std::vector<ODModel::Vertex>& vertices){
+                    if((m_count + 1) * 2 > m_slots.size()){
+                        grow();
+                    }
+                    for(size_t slot = hash & m_mask;; slot = (slot + 1) & m_mask){
+                        Slot& entry = m_slots[slot];
+                        if(entry.index == EMPTY){
+                            entry = {hash, candidate};
+                            m_count++;
+                            return candidate;
+                        }
+                        if(entry.hash == hash && vertices[entry.index] == vertex){
+                            return entry.index;
+                        }
+                    }
                 }
 
-                if(index.texcoord_index >= 0){
-                    vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        1.0 - attrib.texcoords[2 * index.texcoord_index + 1] // ou 1.0f - ... ?
-                    };
+            private:
+                static constexpr uint32_t EMPTY = UINT32_MAX;
+
+                struct Slot {
+                    uint32_t hash = 0;
+                    uint32_t index = EMPTY;
+                };
+
+                void grow(){
+                    std::vector<Slot> old = std::move(m_slots);
+                    m_slots.assign(old.size() * 2, Slot{});
+                    m_mask = m_slots.size() - 1;
+                    for(const Slot& entry : old){
+                        if(entry.index == EMPTY){
+                            continue;
+                        }
+                        size_t slot = entry.hash & m_mask;
+                        while(m_slots[slot].index != EMPTY){
+                            slot = (slot + 1) & m_mask;
+                        }
+                        m_slots[slot] = entry;
+                    }
+                }
+
+                std::vector<Slot> m_slots;
+                size_t m_mask = 0;
+                size_t m_count = 0;
+        };
+
+        void dedupSerial(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+            std::vector<ODModel::Vertex>& vertices, std::vector<uint32_t>& indices){
+            vertices.clear();
+            indices.clear();
+
+            std::unordered_map<ODModel::Vertex, uint32_t> uniqueVertices{};
+
+            for(const auto& shape : shapes){
+                for(const auto& index : shape.mesh.indices){
+                    ODModel::Vertex vertex = makeVertex(attrib, index);
+
+                    if(uniqueVertices.count(vertex) == 0){
+                        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                        vertices.push_back(vertex);
+                    }
+                    indices.push_back(uniqueVertices[vertex]);
+                }
+            }
+        }
+
+        /*
+         * Same output as dedupSerial. The index stream of all shapes is cut into one contiguous
+         * chunk per thread, each chunk is deduplicated on its own, then the chunk-local vertices
+         * are merged in chunk order. A vertex first seen in chunk k is missing from chunks < k,
+         * and chunk k lists its new vertices by first occurrence, so the merge numbers vertices
+         * exactly like the serial pass. The indices are finally remapped in parallel.
+         */
+        void dedupParallel(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+            ODThreadPool& pool, std::vector<ODModel::Vertex>& vertices, std::vector<uint32_t>& indices){
+            std::vector<size_t> shapeOffsets(shapes.size() + 1, 0);
+            for(size_t i = 0; i < shapes.size(); i++){
+                shapeOffsets[i + 1] = shapeOffsets[i] + shapes[i].mesh.indices.size();
+            }
+            const size_t cornerCount = shapeOffsets.back();
+
+            vertices.clear();
+            indices.resize(cornerCount);
+
+            struct Chunk {
+                std::vector<ODModel::Vertex> vertices;
+                std::vector<uint32_t> hashes;
+                std::vector<uint32_t> remap;
+            };
+            const size_t chunkCount = std::clamp<size_t>(cornerCount / MIN_CORNERS_PER_CHUNK, 1, pool.getConcurrency());
+            std::vector<Chunk> chunks(chunkCount);
+
+            pool.parallelFor(cornerCount, chunkCount, [&](size_t chunkIndex, size_t begin, size_t end){
+                Chunk& chunk = chunks[chunkIndex];
+                VertexTable table((end - begin) / 4);
+
+                // last shape starting at or before begin, skips empty shapes
+                size_t shape = std::upper_bound(shapeOffsets.begin(), shapeOffsets.end(), begin) - shapeOffsets.begin() - 1;
+                for(size_t corner = begin; corner < end; corner++){
+                    while(corner >= shapeOffsets[shape + 1]){
+                        shape++;
+                    }
+                    ODModel::Vertex vertex = makeVertex(attrib, shapes[shape].mesh.indices[corner - shapeOffsets[shape]]);
+                    uint32_t hash = hashVertex(vertex);
+                    uint32_t candidate = static_cast<uint32_t>(chunk.vertices.size());
+                    uint32_t local = table.findOrInsert(hash, vertex, candidate, chunk.vertices);
+                    if(local == candidate){
+                        chunk.vertices.push_back(vertex);
+                        chunk.hashes.push_back(hash);
+                    }
+                    indices[corner] = local;
                 }
+            });
 
-                if(uniqueVertices.count(vertex) == 0){
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
+            size_t localVertexCount = 0;
+            for(const Chunk& chunk : chunks){
+                localVertexCount += chunk.vertices.size();
+            }
+            VertexTable table(localVertexCount);
+            for(Chunk& chunk : chunks){
+                chunk.remap.resize(chunk.vertices.size());
+                for(size_t i = 0; i < chunk.vertices.size(); i++){
+                    uint32_t candidate = static_cast<uint32_t>(vertices.size());
+                    uint32_t global = table.findOrInsert(chunk.hashes[i], chunk.vertices[i], candidate, vertices);
+                    if(global == candidate){
+                        vertices.push_back(chunk.vertices[i]);
+                    }
+                    chunk.remap[i] = global;
                 }
-                indices.push_back(uniqueVertices[vertex]);
+                chunk.vertices = {};
+                chunk.hashes = {};
             }
+
+            // same count and chunk count, so every chunk gets back the range it deduplicated
+            if(chunkCount > 1){
+                pool.parallelFor(cornerCount, chunkCount, [&](size_t chunkIndex, size_t begin, size_t end){
+                    const std::vector<uint32_t>& remap = chunks[chunkIndex].remap;
+                    for(size_t corner = begin; corner < end; corner++){
+                        indices[corner] = remap[indices[corner]];
+                    }
+                });
+            }
+        }
+    }
+
+    void ODModel::Builder::loadModels(const std::string &filepath){
+        loadModels(filepath, ODThreadPool::shared());
+    }
+
+    void ODModel::Builder::loadModels(const std::string &filepath, ODThreadPool &pool){
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        parseObj(filepath, attrib, shapes);
+        dedupParallel(attrib, shapes, pool, vertices, indices);
+    }
+
+    void ODModel::Builder::loadModelsSerial(const std::string &filepath){
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        parseObj(filepath, attrib, shapes);
+        dedupSerial(attrib, shapes, vertices, indices);
+    }
+
+    void ODModel::Builder::benchmarkImport(const std::string &filepath){
+        using Clock = std::chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point start){
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        };
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        auto start = Clock::now();
+        parseObj(filepath, attrib, shapes);
+        double parseMs = elapsedMs(start);
+
+        Builder reference{};
+        start = Clock::now();
+        dedupSerial(attrib, shapes, reference.vertices, reference.indices);
+        double serialMs = elapsedMs(start);
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "import benchmark: " << filepath << " (" << reference.indices.size() / 3 << " triangles, "
+                  << reference.vertices.size() << " unique vertices)" << std::endl;
+        std::cout << "  obj parse:    " << parseMs << " ms" << std::endl;
+        std::cout << "  serial dedup: " << serialMs << " ms (std::unordered_map)" << std::endl;
+
+        const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<uint32_t> threadCounts;
+        for(uint32_t threads = 1; threads < maxThreads; threads *= 2){
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(maxThreads);
+
+        double singleThreadMs = 0.0;
+        for(uint32_t threads : threadCounts){
+            ODThreadPool pool(threads - 1);
+            Builder result{};
+            double bestMs = 0.0;
+            for(int run = 0; run < 3; run++){
+                start = Clock::now();
+                dedupParallel(attrib, shapes, pool, result.vertices, result.indices);
+                double ms = elapsedMs(start);
+                bestMs = run == 0 ? ms : std::min(bestMs, ms);
+            }
+            if(threads == 1){
+                singleThreadMs = bestMs;
+            }
+
+            bool identical = result.indices == reference.indices && result.vertices.size() == reference.vertices.size() &&
+                std::memcmp(result.vertices.data(), reference.vertices.data(), result.vertices.size() * sizeof(Vertex)) == 0;
+            std::cout << "  " << std::setw(3) << threads << " threads: " << std::setw(8) << bestMs << " ms  x"
+                      << std::setprecision(2) << serialMs / bestMs << " vs serial, x" << singleThreadMs / bestMs
+                      << " vs 1 thread" << std::setprecision(1) << (identical ? "" : "  OUTPUT MISMATCH") << std::endl;
         }
     }
 }
\ No newline at end of file
@@ -14,56 +14,192 @@
 #include <vector>
 
 namespace ODEngine {
+    class ODThreadPool;
+
+    // Opt-in: a mesh is stored as ODModel::CompactVertex only when every attribute
+    // round-trips within these tolerances, otherwise it keeps the full Vertex.
+    struct ODVertexCompressionSettings {
+        bool enabled = false;
+        float maxPositionError = 0.0005f; // object space units
+        float maxNormalErrorDegrees = 0.5f;
+        float maxUvError = 1.f / 2048.f;
+        float maxColorError = 1.f / 255.f;
+    };
+
     class ODModel {
         public:
 
+            // CPU side layout. On the GPU positions live in a tightly packed stream of their
+            // own (binding 0) and the other attributes in a second one (binding 1, see
+            // VertexAttributes), so depth-only passes fetch 12 bytes per vertex.
             struct Vertex {
                 glm::vec3 position{};
                 glm::vec3 color{};
                 glm::vec3 normal{};
                 glm::vec2 uv{};
 
+                // both streams, for the main pass
                 static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
                 static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+                // position stream only (location 0), for depth prepass, shadow and occlusion
+                // pipelines, bound with ODModel::bindPositions / ODGeometryPool::bindPositions
+                static std::vector<VkVertexInputBindingDescription> getPositionBindingDescriptions();
+                static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
 
                 bool operator== (const Vertex& other) const {
                     return position == other.position && color == other.color && normal == other.normal && uv == other.uv;
                 }
             };
             
+            // binding 1 stream of Vertex
+            struct VertexAttributes {
+                glm::vec3 color{};
+                glm::vec3 normal{};
+                glm::vec2 uv{};
+            };
+
+            // 20 byte layout for big meshes, see ODVertexCompression.h. Split on the GPU like
+            // Vertex: 8 byte positions at binding 0, CompactAttributes at binding 1.
+            struct CompactVertex {
+                uint16_t position[4]; // unorm inside the mesh bounds, w unused
+                uint32_t normal;      // octahedral, snorm16x2
+                uint32_t uv;          // half2
+                uint32_t color;       // rgba8 unorm
+
+                static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+                static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+                static std::vector<VkVertexInputBindingDescription> getPositionBindingDescriptions();
+                static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
+            };
+
+            struct CompactAttributes {
+                uint32_t normal;
+                uint32_t uv;
+                uint32_t color;
+            };
+
+            static constexpr uint32_t MAX_LODS = 6;
+            // models with at most this many vertices get uint16 indices on the GPU
+            static constexpr uint32_t MAX_UINT16_INDEXED_VERTICES = 65536;
+
+            // index range of one level of detail, every LOD indexes the same vertices
+            struct Lod {
+                uint32_t firstIndex = 0;
+                uint32_t indexCount = 0;
+                float error = 0.f; // object space deviation from LOD0
+                // meshlets splitting [firstIndex, firstIndex + indexCount), see ODMeshletBuilder.h
+                uint32_t firstMeshlet = 0;
+                uint32_t meshletCount = 0;
+            };
+
+            // Cluster of up to 124 triangles, culled on its own by MeshletCullingSystem.
+            // Same std430 layout as in meshlet_cull.comp.
+            struct Meshlet {
+                glm::vec4 sphere{0.f};  // object space center, radius in w
+                glm::vec4 cone{0.f};    // mean normal, sin of the cone half angle in w (1: never backfacing)
+                uint32_t firstIndex = 0; // relative to the model's first index, like Lod::firstIndex
+                uint32_t indexCount = 0;
+                uint32_t padding[2] = {};
+            };
+
             struct Builder {
                 std::vector<Vertex> vertices{};
                 std::vector<uint32_t> indices{};
+                // LOD0 first, empty means a single LOD over all indices
+                std::vector<Lod> lods{};
+                std::vector<Meshlet> meshlets{};
 
+                // parses the OBJ then deduplicates vertices across the shared thread pool
                 void loadModels(const std::string& filepath);
+                void loadModels(const std::string& filepath, ODThreadPool& pool);
+                // single threaded std::unordered_map reference, same output as loadModels
+                void loadModelsSerial(const std::string& filepath);
+                // prints parse time and dedup scaling from 1 to all hardware threads, checking
+                // every run against the serial output
+                static void benchmarkImport(const std::string& filepath);
+                // Full import: loadModels, LODs, ODMeshOptimizer, meshlets, then writes the .odmesh cache
+                void importFile(const std::string& filepath);
+                // Copies a valid .odmesh cache of filepath, false when there is none
+                bool loadCache(const std::string& filepath);
+                void computeBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
             };
 
-            ODModel(ODDevice& device, const ODModel::Builder& builder);
+            ODModel(ODDevice& device, const ODModel::Builder& builder, const ODVertexCompressionSettings& compression = {});
+            // vertices and indices only need to live until the constructor returns, they
+            // are copied to the upload staging ring (e.g. straight from a mapped mesh cache)
+            ODModel(ODDevice& device, const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices,
+                uint32_t indexCount, const Lod* lods, uint32_t lodCount, const Meshlet* meshlets,
+                uint32_t meshletCount, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                const ODVertexCompressionSettings& compression = {});
             ~ODModel();
             
             ODModel(const ODModel&) = delete;
             ODModel& operator=(const ODModel&) = delete;
 
-            static std::unique_ptr<ODModel> createModelFromFile(ODDevice& device, const std::string& filepath);
+            static std::unique_ptr<ODModel> createModelFromFile(ODDevice& device, const std::string& filepath,
+                const ODVertexCompressionSettings& compression = {});
 
             void setTexture(std::shared_ptr<ODTextureHandler> textureHandler) { m_textureHandler = textureHandler; }
 
+            // binds the geometry pool arena holding this model, render systems drawing many
+            // models bind each arena once through ODGeometryPool::bind instead
             void bind(VkCommandBuffer commandBuffer);
-            void draw(VkCommandBuffer commandBuffer);
+            // position stream only, for pipelines built with getPositionBindingDescriptions
+            void bindPositions(VkCommandBuffer commandBuffer);
+            void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1);
+            // same draw as an indirect command, for models with an index buffer
+            VkDrawIndexedIndirectCommand getDrawCommand(uint32_t lod, uint32_t firstInstance,
+                uint32_t instanceCount = 1) const;
+            bool hasIndexBuffer() const { return m_hasIndexBuffer; }
+
+            uint32_t getLodCount() const { return static_cast<uint32_t>(m_lods.size()); }
+            const Lod& getLod(uint32_t lod) const { return m_lods[lod]; }
+            // Coarsest LOD whose error covers at most pixelError pixels, pixelsPerUnit being the
+            // projected size of one object space unit. Moving to a coarser LOD than currentLod
+            // needs the error to fall hysteresis (fraction) below the threshold, which keeps
+            // objects near a switch distance from popping back and forth.
+            uint32_t selectLod(float pixelsPerUnit, uint32_t currentLod, float pixelError, float hysteresis) const;
+
+            const ODGeometryRange& getGeometry() const { return m_geometry; }
+            // meshlet records stored as sizeof(Meshlet) "vertices" of a geometry pool arena,
+            // invalid when the model has none
+            const ODGeometryRange& getMeshlets() const { return m_meshlets; }
+            bool hasMeshlets() const { return m_meshlets.isValid(); }
+            const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+            const glm::vec3& getBoundsMax() const { return m_boundsMax; }
+            // bounding sphere around the center of the box, radius to the farthest vertex
+            glm::vec3 getBoundsCenter() const { return 0.5f * (m_boundsMin + m_boundsMax); }
+            float getBoundsRadius() const { return m_boundsRadius; }
+            VkIndexType getIndexType() const { return m_geometry.indexType; }
+            // true when the geometry is stored as CompactVertex
+            bool isCompact() const { return m_compact; }
+            // maps compact unorm positions to object space (identity for full vertices),
+            // goes on the right of the model matrix
+            const glm::mat4& getDequantizeMatrix() const { return m_dequantize; }
+            // vertex, index and meshlet bytes held in the geometry pool
+            uint64_t getMemorySize() const;
 
         private:
-            void createVertexBuffer(const std::vector<Vertex>& vertices);
-            void createIndexBuffer(const std::vector<uint32_t>& indices);
+            void init(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+                const Lod* lods, uint32_t lodCount, const Meshlet* meshlets, uint32_t meshletCount,
+                const glm::vec3& boundsMin, const glm::vec3& boundsMax, const ODVertexCompressionSettings& compression);
 
-        private:
             ODDevice& m_device;
 
-            std::unique_ptr<ODBuffer> m_vertexBuffer;
+            ODGeometryRange m_geometry{};
+            ODGeometryRange m_meshlets{};
             uint32_t m_vertexCount;
 
             bool m_hasIndexBuffer = false;
-            std::unique_ptr<ODBuffer> m_indexBuffer;
             uint32_t m_indexCount;
+            std::vector<Lod> m_lods;
+
+            glm::vec3 m_boundsMin{0.f};
+            glm::vec3 m_boundsMax{0.f};
+            float m_boundsRadius = 0.f;
+
+            bool m_compact = false;
+            glm::mat4 m_dequantize{1.f};
 
             std::shared_ptr<ODTextureHandler> m_textureHandler;
         
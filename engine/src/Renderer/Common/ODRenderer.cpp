@@ -75,6 +75,8 @@ ODRenderer::ODRenderer(ODWindow &window, ODDevice &device,
   recreateSwapChain();
   createCommandBuffers(); // Déjà alloué dans recreateSwapChain()
   createComputeCommandBuffers();
+  m_frameAllocator = std::make_unique<ODFrameAllocator>(
+      m_device, ODSwapChain::MAX_FRAMES_IN_FLIGHT);
 }
 
 ODRenderer::~ODRenderer() { freeCommandBuffers(); }
@@ -215,6 +217,9 @@ VkCommandBuffer ODRenderer::beginFrame() {
   auto result =
       m_swapChain->acquireNextImage(&m_currentImageIndex, m_currentFrameIndex);
 
+  // acquireNextImage waited on this frame's fence, its uniform data is free
+  m_frameAllocator->beginFrame(m_currentFrameIndex);
+
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     recreateSwapChain();
     m_isFrameStarted = false;
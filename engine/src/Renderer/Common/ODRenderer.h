@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Vulkan/ODDevice.h"
+#include "../Vulkan/ODFrameAllocator.h"
 #include "ODModel.h"
 #include "../Vulkan/ODSwapChain.h"
 #include "ODWindow.h"
@@ -34,6 +35,9 @@ namespace ODEngine {
 
             ODSwapChain &getSwapChain() { return *m_swapChain; }
 
+            // per-frame uniform data, reset by beginFrame once the frame's fence has signaled
+            ODFrameAllocator &getFrameAllocator() { return *m_frameAllocator; }
+
             float getAspectRatio() const { return m_swapChain->extentAspectRatio(); }
 
             int getCurrentFrameIndex() const { 
@@ -68,6 +72,7 @@ namespace ODEngine {
             std::unique_ptr<ODSwapChain> m_swapChain;
             std::vector<VkCommandBuffer> m_commandBuffers;
             std::vector<VkCommandBuffer> m_computeCommandBuffers;
+            std::unique_ptr<ODFrameAllocator> m_frameAllocator;
 
             uint32_t m_currentImageIndex;
             int m_currentFrameIndex{0};
@@ -0,0 +1,532 @@
+#include "ODTextureCache.h"
+#include "ODMeshCache.h"
+#include "Utils/ODMappedFile.h"
+#include "Utils/ODThreadPool.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace ODEngine {
+
+    namespace {
+        const uint8_t KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+        struct Ktx2Header {
+            uint8_t identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+        static_assert(sizeof(Ktx2Header) == 80, "KTX2 header is 80 bytes");
+
+        struct Ktx2Level {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+
+        // key/value entry of the caches written by write()
+        constexpr char SOURCE_KEY[] = "ODEngine.source";
+        struct SourceInfo {
+            uint64_t size;
+            int64_t writeTime;
+            uint64_t hash;
+        };
+
+        // KHR data format channels of the BC1A model, 15 is alpha in the others
+        constexpr uint32_t CHANNEL_BC1A_COLOR = 0;
+        constexpr uint32_t CHANNEL_BC1A_ALPHAPRESENT = 1;
+        constexpr uint32_t CHANNEL_ALPHA = 15;
+
+        // KHR data format color models
+        constexpr uint32_t MODEL_RGBSDA = 1;
+        constexpr uint32_t MODEL_BC1A = 128;
+        constexpr uint32_t MODEL_BC3 = 130;
+        constexpr uint32_t MODEL_BC4 = 131;
+        constexpr uint32_t MODEL_BC5 = 132;
+        constexpr uint32_t MODEL_BC7 = 134;
+        constexpr uint32_t MODEL_ASTC = 162;
+
+        struct FormatInfo {
+            uint32_t blockWidth;
+            uint32_t blockHeight;
+            uint32_t blockBytes;
+            bool srgb;
+            uint32_t colorModel;
+            // channel of each sample of a compressed block, the samples splitting it evenly
+            uint32_t sampleChannels[2];
+            uint32_t sampleCount;
+        };
+
+        // formats the texture path samples, false for the others
+        bool getFormatInfo(VkFormat format, FormatInfo& info) {
+            switch (format) {
+                case VK_FORMAT_R8G8B8A8_SRGB: info = {1, 1, 4, true, MODEL_RGBSDA, {}, 0}; return true;
+                case VK_FORMAT_R8G8B8A8_UNORM: info = {1, 1, 4, false, MODEL_RGBSDA, {}, 0}; return true;
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK: info = {4, 4, 8, false, MODEL_BC1A, {CHANNEL_BC1A_COLOR}, 1}; return true;
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK: info = {4, 4, 8, true, MODEL_BC1A, {CHANNEL_BC1A_COLOR}, 1}; return true;
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: info = {4, 4, 8, false, MODEL_BC1A, {CHANNEL_BC1A_ALPHAPRESENT}, 1}; return true;
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: info = {4, 4, 8, true, MODEL_BC1A, {CHANNEL_BC1A_ALPHAPRESENT}, 1}; return true;
+                case VK_FORMAT_BC3_UNORM_BLOCK: info = {4, 4, 16, false, MODEL_BC3, {CHANNEL_ALPHA, 0}, 2}; return true;
+                case VK_FORMAT_BC3_SRGB_BLOCK: info = {4, 4, 16, true, MODEL_BC3, {CHANNEL_ALPHA, 0}, 2}; return true;
+                case VK_FORMAT_BC4_UNORM_BLOCK: info = {4, 4, 8, false, MODEL_BC4, {0}, 1}; return true;
+                case VK_FORMAT_BC5_UNORM_BLOCK: info = {4, 4, 16, false, MODEL_BC5, {0, 1}, 2}; return true;
+                case VK_FORMAT_BC7_UNORM_BLOCK: info = {4, 4, 16, false, MODEL_BC7, {0}, 1}; return true;
+                case VK_FORMAT_BC7_SRGB_BLOCK: info = {4, 4, 16, true, MODEL_BC7, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: info = {4, 4, 16, false, MODEL_ASTC, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_4x4_SRGB_BLOCK: info = {4, 4, 16, true, MODEL_ASTC, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_6x6_UNORM_BLOCK: info = {6, 6, 16, false, MODEL_ASTC, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_6x6_SRGB_BLOCK: info = {6, 6, 16, true, MODEL_ASTC, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_8x8_UNORM_BLOCK: info = {8, 8, 16, false, MODEL_ASTC, {0}, 1}; return true;
+                case VK_FORMAT_ASTC_8x8_SRGB_BLOCK: info = {8, 8, 16, true, MODEL_ASTC, {0}, 1}; return true;
+                default: return false;
+            }
+        }
+
+        uint64_t getLevelSize(const FormatInfo& info, uint32_t width, uint32_t height) {
+            uint64_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+            uint64_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+            return blocksX * blocksY * info.blockBytes;
+        }
+
+        // level data alignment required by KTX2: lcm(texel block size, 4)
+        uint64_t getLevelAlignment(const FormatInfo& info) {
+            return std::lcm(uint64_t{info.blockBytes}, uint64_t{4});
+        }
+
+        uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        bool getSourceInfo(const std::string& sourcePath, SourceInfo& source) {
+            std::error_code error;
+            auto fileSize = std::filesystem::file_size(sourcePath, error);
+            if (error) {
+                return false;
+            }
+            auto time = std::filesystem::last_write_time(sourcePath, error);
+            if (error) {
+                return false;
+            }
+            source.size = static_cast<uint64_t>(fileSize);
+            source.writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        bool hashSourceFile(const std::string& sourcePath, uint64_t& hash) {
+            ODMappedFile file;
+            if (!file.open(sourcePath)) {
+                return false;
+            }
+            hash = ODMeshCache::hashBytes(file.data(), file.size());
+            return true;
+        }
+
+        // KHR basic data format descriptor: one 8 bit sample per channel for RGBA8, one sample
+        // per block part (color, alpha...) for the compressed formats
+        std::vector<uint32_t> buildDataFormatDescriptor(const FormatInfo& info) {
+            constexpr uint32_t PRIMARIES_BT709 = 1;
+            constexpr uint32_t TRANSFER_LINEAR = 1;
+            constexpr uint32_t TRANSFER_SRGB = 2;
+            // qualifier bits of the channel byte, alpha is never sRGB encoded
+            constexpr uint32_t SAMPLE_LINEAR = 0x10;
+
+            bool compressed = info.colorModel != MODEL_RGBSDA;
+            uint32_t sampleCount = compressed ? info.sampleCount : 4;
+            uint32_t blockSize = 24 + 16 * sampleCount;
+            std::vector<uint32_t> words = {
+                4 + blockSize,
+                0, // vendor Khronos, basic descriptor
+                2 | (blockSize << 16),
+                info.colorModel | (PRIMARIES_BT709 << 8) | ((info.srgb ? TRANSFER_SRGB : TRANSFER_LINEAR) << 16),
+                (info.blockWidth - 1) | ((info.blockHeight - 1) << 8),
+                info.blockBytes,
+                0};
+            if (compressed) {
+                uint32_t sampleBits = info.blockBytes * 8 / sampleCount;
+                for (uint32_t i = 0; i < sampleCount; i++) {
+                    // BC1A's only sample holds the color too, it stays sRGB
+                    uint32_t channelType = info.sampleChannels[i];
+                    if (info.srgb && channelType == CHANNEL_ALPHA) {
+                        channelType |= SAMPLE_LINEAR;
+                    }
+                    words.push_back((i * sampleBits) | ((sampleBits - 1) << 16) | (channelType << 24));
+                    words.push_back(0);          // sample position
+                    words.push_back(0);          // lower
+                    words.push_back(UINT32_MAX); // upper
+                }
+                return words;
+            }
+
+            const uint32_t channels[] = {0, 1, 2, CHANNEL_ALPHA};
+            for (uint32_t i = 0; i < 4; i++) {
+                uint32_t channelType = channels[i];
+                if (info.srgb && channels[i] == CHANNEL_ALPHA) {
+                    channelType |= SAMPLE_LINEAR;
+                }
+                words.push_back((i * 8) | (7u << 16) | (channelType << 24));
+                words.push_back(0);   // sample position
+                words.push_back(0);   // lower
+                words.push_back(255); // upper
+            }
+            return words;
+        }
+
+        // the whole key/value section holding one entry
+        std::vector<uint8_t> buildKeyValueData(const SourceInfo& source) {
+            uint32_t length = static_cast<uint32_t>(sizeof(SOURCE_KEY) + sizeof(SourceInfo));
+            std::vector<uint8_t> data(alignOffset(sizeof(uint32_t) + length, 4), 0);
+            std::memcpy(data.data(), &length, sizeof(length));
+            std::memcpy(data.data() + sizeof(length), SOURCE_KEY, sizeof(SOURCE_KEY));
+            std::memcpy(data.data() + sizeof(length) + sizeof(SOURCE_KEY), &source, sizeof(source));
+            return data;
+        }
+
+        // entryOffset: offset of the value in data
+        bool findSourceInfo(const uint8_t* data, uint64_t size, SourceInfo& source, uint64_t& entryOffset) {
+            uint64_t offset = 0;
+            while (offset + sizeof(uint32_t) <= size) {
+                uint32_t length;
+                std::memcpy(&length, data + offset, sizeof(length));
+                offset += sizeof(length);
+                if (length > size - offset) {
+                    return false;
+                }
+                if (length == sizeof(SOURCE_KEY) + sizeof(SourceInfo) &&
+                    std::memcmp(data + offset, SOURCE_KEY, sizeof(SOURCE_KEY)) == 0) {
+                    entryOffset = offset + sizeof(SOURCE_KEY);
+                    std::memcpy(&source, data + entryOffset, sizeof(source));
+                    return true;
+                }
+                offset = alignOffset(offset + length, 4);
+            }
+            return false;
+        }
+
+        // image points into file on success, sourceInfo and its file offset are set when the
+        // file has the entry
+        bool parseKtx2(const std::shared_ptr<ODMappedFile>& file, ODTextureHandler::Image& image,
+            SourceInfo* sourceInfo, bool& hasSourceInfo, uint64_t* sourceInfoOffset = nullptr) {
+            hasSourceInfo = false;
+            if (file->size() < sizeof(Ktx2Header)) {
+                return false;
+            }
+            Ktx2Header header;
+            std::memcpy(&header, file->data(), sizeof(header));
+            FormatInfo info{};
+            bool valid = std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0 &&
+                getFormatInfo(static_cast<VkFormat>(header.vkFormat), info) &&
+                header.pixelWidth > 0 && header.pixelHeight > 0 && header.pixelDepth == 0 &&
+                header.layerCount <= 1 && header.faceCount == 1 && header.supercompressionScheme == 0 &&
+                // 0 asks the loader to generate the mips, which this path does not do
+                header.levelCount >= 1 && header.levelCount <= 32 &&
+                sizeof(Ktx2Header) + sizeof(Ktx2Level) * uint64_t{header.levelCount} <= file->size();
+            if (!valid) {
+                return false;
+            }
+
+            image.format = static_cast<VkFormat>(header.vkFormat);
+            image.width = header.pixelWidth;
+            image.height = header.pixelHeight;
+            image.levels.resize(header.levelCount);
+
+            // level 0 first in the index, smallest level first in the file
+            uint64_t first = UINT64_MAX;
+            uint64_t last = 0;
+            std::vector<Ktx2Level> levels(header.levelCount);
+            std::memcpy(levels.data(), file->data() + sizeof(Ktx2Header), sizeof(Ktx2Level) * levels.size());
+            for (uint32_t level = 0; level < header.levelCount; level++) {
+                uint32_t width = std::max(header.pixelWidth >> level, 1u);
+                uint32_t height = std::max(header.pixelHeight >> level, 1u);
+                const Ktx2Level& entry = levels[level];
+                if (entry.byteLength != getLevelSize(info, width, height) ||
+                    entry.byteOffset % getLevelAlignment(info) != 0 ||
+                    entry.byteOffset > file->size() || entry.byteLength > file->size() - entry.byteOffset) {
+                    return false;
+                }
+                first = std::min(first, entry.byteOffset);
+                last = std::max(last, entry.byteOffset + entry.byteLength);
+            }
+            for (uint32_t level = 0; level < header.levelCount; level++) {
+                image.levels[level] = {levels[level].byteOffset - first, levels[level].byteLength};
+            }
+            image.size = last - first;
+            // the mapping lives as long as the image data
+            image.data = std::shared_ptr<const uint8_t>(file, file->data() + first);
+
+            if (sourceInfo != nullptr && header.kvdByteLength > 0 &&
+                uint64_t{header.kvdByteOffset} + header.kvdByteLength <= file->size()) {
+                uint64_t entryOffset = 0;
+                hasSourceInfo = findSourceInfo(file->data() + header.kvdByteOffset, header.kvdByteLength, *sourceInfo,
+                    entryOffset);
+                if (hasSourceInfo && sourceInfoOffset != nullptr) {
+                    *sourceInfoOffset = header.kvdByteOffset + entryOffset;
+                }
+            }
+            return true;
+        }
+
+        bool writeKtx2File(const std::string& filepath, const ODTextureHandler::Image& image, const SourceInfo* source) {
+            FormatInfo info{};
+            if (image.data == nullptr || image.levels.empty() || !getFormatInfo(image.format, info)) {
+                return false;
+            }
+            uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+            std::vector<uint32_t> dfd = buildDataFormatDescriptor(info);
+            std::vector<uint8_t> kvd;
+            if (source != nullptr) {
+                kvd = buildKeyValueData(*source);
+            }
+
+            Ktx2Header header{};
+            std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+            header.vkFormat = static_cast<uint32_t>(image.format);
+            header.typeSize = 1;
+            header.pixelWidth = image.width;
+            header.pixelHeight = image.height;
+            header.faceCount = 1;
+            header.levelCount = levelCount;
+            header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + sizeof(Ktx2Level) * levelCount);
+            header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+            header.kvdByteOffset = kvd.empty() ? 0 : header.dfdByteOffset + header.dfdByteLength;
+            header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+            // smallest level first, each one aligned
+            uint64_t alignment = getLevelAlignment(info);
+            uint64_t offset = header.dfdByteOffset + header.dfdByteLength + header.kvdByteLength;
+            std::vector<Ktx2Level> levels(levelCount);
+            for (uint32_t level = levelCount; level-- > 0;) {
+                offset = alignOffset(offset, alignment);
+                levels[level] = {offset, image.levels[level].size, image.levels[level].size};
+                offset += image.levels[level].size;
+            }
+
+            // write to a temporary file and rename it so a crash never leaves a truncated cache
+            std::string tempPath = filepath + ".tmp";
+            {
+                std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+                if (!out) {
+                    return false;
+                }
+                const char padding[16] = {};
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(reinterpret_cast<const char*>(levels.data()),
+                    static_cast<std::streamsize>(sizeof(Ktx2Level) * levels.size()));
+                out.write(reinterpret_cast<const char*>(dfd.data()), header.dfdByteLength);
+                out.write(reinterpret_cast<const char*>(kvd.data()), header.kvdByteLength);
+                uint64_t written = header.dfdByteOffset + header.dfdByteLength + header.kvdByteLength;
+                for (uint32_t level = levelCount; level-- > 0;) {
+                    out.write(padding, static_cast<std::streamsize>(levels[level].byteOffset - written));
+                    out.write(reinterpret_cast<const char*>(image.data.get() + image.levels[level].offset),
+                        static_cast<std::streamsize>(levels[level].byteLength));
+                    written = levels[level].byteOffset + levels[level].byteLength;
+                }
+                if (!out) {
+                    return false;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::rename(tempPath, filepath, error);
+            if (error) {
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+            return true;
+        }
+
+        // rewrites the entry in place, the cache must not be mapped (Windows maps it without
+        // write sharing)
+        bool rewriteSourceInfo(const std::string& filepath, uint64_t offset, const SourceInfo& source) {
+            std::fstream file(filepath, std::ios::binary | std::ios::in | std::ios::out);
+            if (!file) {
+                return false;
+            }
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<const char*>(&source), sizeof(source));
+            return static_cast<bool>(file);
+        }
+
+        float srgbToLinear(float c) {
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        uint8_t linearToSrgb(float c) {
+            c = std::clamp(c, 0.f, 1.f);
+            float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+            return static_cast<uint8_t>(std::lround(encoded * 255.f));
+        }
+    }
+
+    std::string ODTextureCache::getCachePath(const std::string &sourcePath) {
+        return sourcePath + ".ktx2";
+    }
+
+    bool ODTextureCache::load(const std::string &sourcePath, VkFormat format, ODTextureHandler::Image &image) {
+        std::string cachePath = getCachePath(sourcePath);
+        auto file = std::make_shared<ODMappedFile>();
+        if (!file->open(cachePath)) {
+            return false;
+        }
+        SourceInfo stored{};
+        bool hasSource = false;
+        uint64_t storedOffset = 0;
+        if (!parseKtx2(file, image, &stored, hasSource, &storedOffset) || !hasSource || image.format != format) {
+            image = {};
+            return false;
+        }
+
+        // same size and write time: trust the stored hash, otherwise hash the content.
+        // Without the source the cache is used as it is.
+        SourceInfo current{};
+        if (getSourceInfo(sourcePath, current)) {
+            bool valid = current.size == stored.size;
+            if (valid && current.writeTime != stored.writeTime) {
+                valid = hashSourceFile(sourcePath, current.hash) && current.hash == stored.hash;
+                if (valid) {
+                    // same content under a new write time (touched, checked out again): store
+                    // it so the next loads trust the entry again instead of hashing the source
+                    image = {};
+                    file->close();
+                    rewriteSourceInfo(cachePath, storedOffset, current);
+                    valid = file->open(cachePath) && parseKtx2(file, image, &stored, hasSource) && hasSource &&
+                        image.format == format && stored.size == current.size && stored.hash == current.hash;
+                }
+            }
+            if (!valid) {
+                image = {};
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ODTextureCache::write(const std::string &sourcePath, const ODTextureHandler::Image &image) {
+        SourceInfo source{};
+        if (!getSourceInfo(sourcePath, source) || !hashSourceFile(sourcePath, source.hash)) {
+            return false;
+        }
+        return writeKtx2File(getCachePath(sourcePath), image, &source);
+    }
+
+    bool ODTextureCache::loadKtx2(const std::string &filepath, ODTextureHandler::Image &image) {
+        auto file = std::make_shared<ODMappedFile>();
+        bool hasSource = false;
+        if (!file->open(filepath) || !parseKtx2(file, image, nullptr, hasSource)) {
+            image = {};
+            return false;
+        }
+        return true;
+    }
+
+    bool ODTextureCache::writeKtx2(const std::string &filepath, const ODTextureHandler::Image &image) {
+        return writeKtx2File(filepath, image, nullptr);
+    }
+
+    ODTextureHandler::Image ODTextureCache::buildMipChain(const uint8_t *pixels, uint32_t width, uint32_t height,
+        VkFormat format) {
+        if (format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM) {
+            throw std::runtime_error("mip chains are built for RGBA8 formats only!");
+        }
+        bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB;
+        ODTextureHandler::Image image{};
+        image.format = format;
+        image.width = width;
+        image.height = height;
+        uint32_t levelCount = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+        image.levels.resize(levelCount);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            uint64_t size = uint64_t{std::max(width >> level, 1u)} * std::max(height >> level, 1u) * 4;
+            image.levels[level] = {image.size, size};
+            image.size += size;
+        }
+        auto storage = std::make_shared<std::vector<uint8_t>>(image.size);
+        std::memcpy(storage->data(), pixels, image.levels[0].size);
+
+        float toLinear[256];
+        for (int i = 0; i < 256; i++) {
+            toLinear[i] = srgb ? srgbToLinear(static_cast<float>(i) / 255.f) : static_cast<float>(i) / 255.f;
+        }
+        auto encode = [srgb](float c) {
+            return srgb ? linearToSrgb(c) : static_cast<uint8_t>(std::lround(std::clamp(c, 0.f, 1.f) * 255.f));
+        };
+
+        // rows of each level spread over the shared pool
+        ODThreadPool& pool = ODThreadPool::shared();
+        auto forRows = [&pool](uint32_t rows, const std::function<void(size_t, size_t)>& fn) {
+            pool.parallelFor(rows, std::min<size_t>(rows, pool.getConcurrency()),
+                [&fn](size_t, size_t begin, size_t end) { fn(begin, end); });
+        };
+
+        // previous level in linear light, filtering from floats avoids requantizing every level
+        std::vector<float> source(uint64_t{width} * height * 4);
+        forRows(height, [&](size_t begin, size_t end) {
+            for (size_t i = begin * width * 4; i < end * width * 4; i += 4) {
+                source[i + 0] = toLinear[pixels[i + 0]];
+                source[i + 1] = toLinear[pixels[i + 1]];
+                source[i + 2] = toLinear[pixels[i + 2]];
+                source[i + 3] = pixels[i + 3] / 255.f;
+            }
+        });
+
+        std::vector<float> filtered;
+        uint32_t sourceWidth = width;
+        uint32_t sourceHeight = height;
+        for (uint32_t level = 1; level < levelCount; level++) {
+            uint32_t levelWidth = std::max(sourceWidth / 2, 1u);
+            uint32_t levelHeight = std::max(sourceHeight / 2, 1u);
+            filtered.resize(uint64_t{levelWidth} * levelHeight * 4);
+            uint8_t* out = storage->data() + image.levels[level].offset;
+            forRows(levelHeight, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    // a 1 texel wide side averages the same texel twice
+                    size_t y0 = std::min<size_t>(2 * y, sourceHeight - 1);
+                    size_t y1 = std::min<size_t>(2 * y + 1, sourceHeight - 1);
+                    for (size_t x = 0; x < levelWidth; x++) {
+                        size_t x0 = std::min<size_t>(2 * x, sourceWidth - 1);
+                        size_t x1 = std::min<size_t>(2 * x + 1, sourceWidth - 1);
+                        const float* a = &source[(y0 * sourceWidth + x0) * 4];
+                        const float* b = &source[(y0 * sourceWidth + x1) * 4];
+                        const float* c = &source[(y1 * sourceWidth + x0) * 4];
+                        const float* d = &source[(y1 * sourceWidth + x1) * 4];
+                        size_t index = (y * levelWidth + x) * 4;
+                        for (int channel = 0; channel < 4; channel++) {
+                            filtered[index + channel] = 0.25f * (a[channel] + b[channel] + c[channel] + d[channel]);
+                        }
+                        out[index + 0] = encode(filtered[index + 0]);
+                        out[index + 1] = encode(filtered[index + 1]);
+                        out[index + 2] = encode(filtered[index + 2]);
+                        out[index + 3] = static_cast<uint8_t>(std::lround(std::clamp(filtered[index + 3], 0.f, 1.f) * 255.f));
+                    }
+                }
+            });
+            std::swap(source, filtered);
+            sourceWidth = levelWidth;
+            sourceHeight = levelHeight;
+        }
+
+        image.data = std::shared_ptr<const uint8_t>(storage, storage->data());
+        return image;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ODTextureHandler.h"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace ODEngine {
+
+    /*
+     * Imported textures, stored next to the source as <source>.ktx2 with every mip level
+     * precomputed. Loading maps the file and hands its level data to the upload as it is,
+     * no decoding and no blits at runtime.
+     *
+     * Sources are stored in the format the registry asks for, block compressed by
+     * ODTextureEncoder when it is one of the BC formats.
+     *
+     * The files are plain KTX2 (no supercompression, one layer, one face) with a key/value
+     * entry recording the source size, write time and content hash. A cache is stale when
+     * that hash differs (only recomputed when the size or write time moved), like
+     * ODMeshCache.
+     */
+    class ODTextureCache {
+        public:
+            static std::string getCachePath(const std::string& sourcePath);
+
+            // Maps the cache of sourcePath, image then points into the mapping (image.data
+            // keeps it open). Returns false when there is no valid cache of that format.
+            static bool load(const std::string& sourcePath, VkFormat format, ODTextureHandler::Image& image);
+            static bool write(const std::string& sourcePath, const ODTextureHandler::Image& image);
+
+            // Any KTX2 file of a format the engine samples, without a source check. Returns false
+            // when the file cannot be read.
+            static bool loadKtx2(const std::string& filepath, ODTextureHandler::Image& image);
+            static bool writeKtx2(const std::string& filepath, const ODTextureHandler::Image& image);
+
+            // Full mip chain of width * height RGBA8 pixels of format (R8G8B8A8 sRGB or UNORM).
+            // Each level is a 2x2 box filter of the previous one, done in linear light for sRGB
+            // (alpha as it is) so mips do not darken like a filter on the encoded values does.
+            static ODTextureHandler::Image buildMipChain(const uint8_t* pixels, uint32_t width, uint32_t height,
+                VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+    };
+}
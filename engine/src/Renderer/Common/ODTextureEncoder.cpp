@@ -0,0 +1,540 @@
+#include "ODTextureEncoder.h"
+#include "Utils/ODThreadPool.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace ODEngine {
+
+    namespace {
+        constexpr uint32_t BLOCK_TEXELS = 16;
+
+        enum class BlockEncoding { BC1, BC1Alpha, BC3, BC4, BC5, BC7 };
+
+        struct EncodingInfo {
+            BlockEncoding encoding;
+            uint32_t blockBytes;
+            bool srgb;
+        };
+
+        bool getEncodingInfo(VkFormat format, EncodingInfo& info) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK: info = {BlockEncoding::BC1, 8, false}; return true;
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK: info = {BlockEncoding::BC1, 8, true}; return true;
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: info = {BlockEncoding::BC1Alpha, 8, false}; return true;
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: info = {BlockEncoding::BC1Alpha, 8, true}; return true;
+                case VK_FORMAT_BC3_UNORM_BLOCK: info = {BlockEncoding::BC3, 16, false}; return true;
+                case VK_FORMAT_BC3_SRGB_BLOCK: info = {BlockEncoding::BC3, 16, true}; return true;
+                case VK_FORMAT_BC4_UNORM_BLOCK: info = {BlockEncoding::BC4, 8, false}; return true;
+                case VK_FORMAT_BC5_UNORM_BLOCK: info = {BlockEncoding::BC5, 16, false}; return true;
+                case VK_FORMAT_BC7_UNORM_BLOCK: info = {BlockEncoding::BC7, 16, false}; return true;
+                case VK_FORMAT_BC7_SRGB_BLOCK: info = {BlockEncoding::BC7, 16, true}; return true;
+                default: return false;
+            }
+        }
+
+        // 16 RGBA texels, row by row
+        using Block = uint8_t[BLOCK_TEXELS * 4];
+
+        float distanceSquared(const float* a, const float* b, int channels) {
+            float sum = 0.f;
+            for (int c = 0; c < channels; c++) {
+                sum += (a[c] - b[c]) * (a[c] - b[c]);
+            }
+            return sum;
+        }
+
+        // Axis of largest variance of the given texels (power iteration on the covariance),
+        // zero when they are all equal. mean is set too.
+        void principalAxis(const float (*texels)[4], uint32_t count, int channels, float* mean, float* axis) {
+            for (int c = 0; c < channels; c++) {
+                mean[c] = 0.f;
+                for (uint32_t i = 0; i < count; i++) {
+                    mean[c] += texels[i][c];
+                }
+                mean[c] /= static_cast<float>(count);
+            }
+            float covariance[4][4] = {};
+            for (uint32_t i = 0; i < count; i++) {
+                for (int a = 0; a < channels; a++) {
+                    for (int b = 0; b < channels; b++) {
+                        covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+                    }
+                }
+            }
+            // start from the covariance row of the channel varying most, converges in a few steps
+            int start = 0;
+            for (int c = 1; c < channels; c++) {
+                if (covariance[c][c] > covariance[start][start]) {
+                    start = c;
+                }
+            }
+            for (int c = 0; c < channels; c++) {
+                axis[c] = covariance[start][c];
+            }
+            for (int iteration = 0; iteration < 8; iteration++) {
+                float next[4] = {};
+                float length = 0.f;
+                for (int a = 0; a < channels; a++) {
+                    for (int b = 0; b < channels; b++) {
+                        next[a] += covariance[a][b] * axis[b];
+                    }
+                    length = std::max(length, std::abs(next[a]));
+                }
+                if (length == 0.f) {
+                    break;
+                }
+                for (int c = 0; c < channels; c++) {
+                    axis[c] = next[c] / length;
+                }
+            }
+        }
+
+        // the extreme projections of the texels on their principal axis become the endpoints
+        void axisEndpoints(const float (*texels)[4], uint32_t count, int channels, float* low, float* high) {
+            float mean[4];
+            float axis[4];
+            principalAxis(texels, count, channels, mean, axis);
+            float minProjection = 0.f;
+            float maxProjection = 0.f;
+            for (uint32_t i = 0; i < count; i++) {
+                float projection = 0.f;
+                for (int c = 0; c < channels; c++) {
+                    projection += (texels[i][c] - mean[c]) * axis[c];
+                }
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+            float axisLength = 0.f;
+            for (int c = 0; c < channels; c++) {
+                axisLength += axis[c] * axis[c];
+            }
+            if (axisLength == 0.f) {
+                std::copy(mean, mean + channels, low);
+                std::copy(mean, mean + channels, high);
+                return;
+            }
+            for (int c = 0; c < channels; c++) {
+                low[c] = std::clamp(mean[c] + axis[c] * minProjection / axisLength, 0.f, 255.f);
+                high[c] = std::clamp(mean[c] + axis[c] * maxProjection / axisLength, 0.f, 255.f);
+            }
+        }
+
+        // Endpoints minimizing the squared error for fixed indices, weights[i] being the share
+        // of the second endpoint in texel i. False when the system is singular (one index used).
+        bool leastSquaresEndpoints(const float (*texels)[4], const float* weights, uint32_t count, int channels,
+            float* low, float* high) {
+            float aa = 0.f, ab = 0.f, bb = 0.f;
+            float ax[4] = {}, bx[4] = {};
+            for (uint32_t i = 0; i < count; i++) {
+                float b = weights[i];
+                float a = 1.f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int c = 0; c < channels; c++) {
+                    ax[c] += a * texels[i][c];
+                    bx[c] += b * texels[i][c];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6f) {
+                return false;
+            }
+            for (int c = 0; c < channels; c++) {
+                low[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.f, 255.f);
+                high[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.f, 255.f);
+            }
+            return true;
+        }
+
+        // --- BC1 ---
+
+        uint16_t packColor565(const float* color) {
+            uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.f / 255.f));
+            uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.f / 255.f));
+            uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.f / 255.f));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpackColor565(uint16_t packed, float* color) {
+            uint32_t r = (packed >> 11) & 31;
+            uint32_t g = (packed >> 5) & 63;
+            uint32_t b = packed & 31;
+            color[0] = static_cast<float>((r << 3) | (r >> 2));
+            color[1] = static_cast<float>((g << 2) | (g >> 4));
+            color[2] = static_cast<float>((b << 3) | (b >> 2));
+        }
+
+        struct ColorBlock {
+            uint16_t color0;
+            uint16_t color1;
+            uint32_t indices;
+        };
+
+        // Indices of the texels for the quantized endpoints, returns the squared error.
+        // Four color mode when color0 > color1, three colors and transparent otherwise.
+        float assignColorIndices(const float (*texels)[4], const bool* transparent, ColorBlock& block) {
+            float palette[4][4] = {};
+            unpackColor565(block.color0, palette[0]);
+            unpackColor565(block.color1, palette[1]);
+            bool fourColors = block.color0 > block.color1;
+            for (int c = 0; c < 3; c++) {
+                if (fourColors) {
+                    palette[2][c] = std::floor((2.f * palette[0][c] + palette[1][c]) / 3.f);
+                    palette[3][c] = std::floor((palette[0][c] + 2.f * palette[1][c]) / 3.f);
+                } else {
+                    palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.f);
+                }
+            }
+            uint32_t paletteSize = fourColors ? 4 : 3;
+
+            float error = 0.f;
+            block.indices = 0;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                uint32_t best = 3;
+                if (transparent == nullptr || !transparent[i]) {
+                    float bestError = distanceSquared(texels[i], palette[0], 3);
+                    best = 0;
+                    for (uint32_t entry = 1; entry < paletteSize; entry++) {
+                        float entryError = distanceSquared(texels[i], palette[entry], 3);
+                        if (entryError < bestError) {
+                            bestError = entryError;
+                            best = entry;
+                        }
+                    }
+                    error += bestError;
+                }
+                block.indices |= best << (2 * i);
+            }
+            return error;
+        }
+
+        // endpoints in the order of the mode, the transparent texels of punchThrough blocks keep
+        // the three color mode
+        ColorBlock quantizeColorBlock(const float (*texels)[4], const bool* transparent, bool threeColors,
+            const float* low, const float* high, float& error) {
+            ColorBlock block{packColor565(high), packColor565(low), 0};
+            if ((block.color0 < block.color1) != threeColors && block.color0 != block.color1) {
+                std::swap(block.color0, block.color1);
+            }
+            if (block.color0 == block.color1 && !threeColors) {
+                // a single color: four color mode needs color0 > color1, index 0 is color0
+                if (block.color1 > 0) {
+                    block.color1--;
+                } else {
+                    block.color0++;
+                }
+            }
+            error = assignColorIndices(texels, transparent, block);
+            return block;
+        }
+
+        void encodeColorBlock(const Block& texels, bool punchThrough, uint8_t* out) {
+            float colors[BLOCK_TEXELS][4] = {};
+            bool transparent[BLOCK_TEXELS] = {};
+            float opaque[BLOCK_TEXELS][4] = {};
+            uint32_t opaqueCount = 0;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                for (int c = 0; c < 3; c++) {
+                    colors[i][c] = texels[i * 4 + c];
+                }
+                transparent[i] = punchThrough && texels[i * 4 + 3] < 128;
+                if (!transparent[i]) {
+                    std::copy(colors[i], colors[i] + 3, opaque[opaqueCount++]);
+                }
+            }
+
+            ColorBlock block{};
+            if (opaqueCount == 0) {
+                // three color mode, every index transparent
+                block = {0, 0, 0xFFFFFFFFu};
+            } else {
+                bool threeColors = opaqueCount < BLOCK_TEXELS;
+                const bool* transparency = threeColors ? transparent : nullptr;
+                float low[4], high[4];
+                axisEndpoints(opaque, opaqueCount, 3, low, high);
+                float error;
+                block = quantizeColorBlock(colors, transparency, threeColors, low, high, error);
+
+                // share of color1 for each index of the mode
+                const float fourColorWeights[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+                const float threeColorWeights[4] = {0.f, 1.f, 0.5f, 0.f};
+                const float* modeWeights = threeColors ? threeColorWeights : fourColorWeights;
+                float weights[BLOCK_TEXELS];
+                uint32_t weightCount = 0;
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    if (!transparent[i]) {
+                        weights[weightCount++] = modeWeights[(block.indices >> (2 * i)) & 3];
+                    }
+                }
+                float color0[4], color1[4];
+                if (leastSquaresEndpoints(opaque, weights, opaqueCount, 3, color0, color1)) {
+                    float refinedError;
+                    ColorBlock refined =
+                        quantizeColorBlock(colors, transparency, threeColors, color1, color0, refinedError);
+                    if (refinedError < error) {
+                        block = refined;
+                    }
+                }
+            }
+            std::memcpy(out, &block.color0, 2);
+            std::memcpy(out + 2, &block.color1, 2);
+            std::memcpy(out + 4, &block.indices, 4);
+        }
+
+        // --- BC4 ---
+
+        // one channel of the block, 8 interpolated values between its min and max
+        void encodeChannelBlock(const Block& texels, int channel, uint8_t* out) {
+            uint8_t low = 255;
+            uint8_t high = 0;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                low = std::min(low, texels[i * 4 + channel]);
+                high = std::max(high, texels[i * 4 + channel]);
+            }
+            out[0] = high;
+            out[1] = low;
+            uint64_t indices = 0;
+            if (high > low) {
+                // values[i] of index i, 0 and 1 being the endpoints
+                int values[8] = {high, low};
+                for (int i = 1; i < 7; i++) {
+                    values[i + 1] = ((7 - i) * high + i * low) / 7;
+                }
+                for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                    int value = texels[i * 4 + channel];
+                    uint64_t best = 0;
+                    int bestError = std::abs(value - values[0]);
+                    for (uint64_t index = 1; index < 8; index++) {
+                        int error = std::abs(value - values[index]);
+                        if (error < bestError) {
+                            bestError = error;
+                            best = index;
+                        }
+                    }
+                    indices |= best << (3 * i);
+                }
+            }
+            for (int i = 0; i < 6; i++) {
+                out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+            }
+        }
+
+        // --- BC7 ---
+
+        const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        struct Bc7Endpoint {
+            uint8_t color[4]; // 7 bits
+            uint8_t pBit;
+
+            uint8_t value(int c) const { return static_cast<uint8_t>((color[c] << 1) | pBit); }
+        };
+
+        Bc7Endpoint quantizeBc7Endpoint(const float* color, uint8_t pBit) {
+            Bc7Endpoint endpoint{{}, pBit};
+            for (int c = 0; c < 4; c++) {
+                endpoint.color[c] = static_cast<uint8_t>(std::clamp(std::lround((color[c] - pBit) / 2.f), 0l, 127l));
+            }
+            return endpoint;
+        }
+
+        float assignBc7Indices(const float (*texels)[4], const Bc7Endpoint& e0, const Bc7Endpoint& e1,
+            uint8_t* indices) {
+            float palette[16][4];
+            for (int entry = 0; entry < 16; entry++) {
+                for (int c = 0; c < 4; c++) {
+                    palette[entry][c] = static_cast<float>(
+                        ((64 - BC7_WEIGHTS[entry]) * e0.value(c) + BC7_WEIGHTS[entry] * e1.value(c) + 32) >> 6);
+                }
+            }
+            float error = 0.f;
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                float bestError = distanceSquared(texels[i], palette[0], 4);
+                indices[i] = 0;
+                for (uint8_t entry = 1; entry < 16; entry++) {
+                    float entryError = distanceSquared(texels[i], palette[entry], 4);
+                    if (entryError < bestError) {
+                        bestError = entryError;
+                        indices[i] = entry;
+                    }
+                }
+                error += bestError;
+            }
+            return error;
+        }
+
+        // best of the four p-bit pairs for these endpoints
+        float quantizeBc7Block(const float (*texels)[4], const float* low, const float* high,
+            Bc7Endpoint& e0, Bc7Endpoint& e1, uint8_t* indices) {
+            float bestError = -1.f;
+            uint8_t candidate[BLOCK_TEXELS];
+            for (uint8_t p0 = 0; p0 < 2; p0++) {
+                for (uint8_t p1 = 0; p1 < 2; p1++) {
+                    Bc7Endpoint c0 = quantizeBc7Endpoint(low, p0);
+                    Bc7Endpoint c1 = quantizeBc7Endpoint(high, p1);
+                    float error = assignBc7Indices(texels, c0, c1, candidate);
+                    if (bestError < 0.f || error < bestError) {
+                        bestError = error;
+                        e0 = c0;
+                        e1 = c1;
+                        std::copy(candidate, candidate + BLOCK_TEXELS, indices);
+                    }
+                }
+            }
+            return bestError;
+        }
+
+        // writes bits LSB first, as BC7 blocks are laid out
+        struct BitWriter {
+            uint8_t* out;
+            uint32_t position = 0;
+
+            void write(uint32_t value, uint32_t bits) {
+                for (uint32_t i = 0; i < bits; i++, position++) {
+                    if ((value >> i) & 1) {
+                        out[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+                    }
+                }
+            }
+        };
+
+        void encodeBc7Block(const Block& texels, uint8_t* out) {
+            float colors[BLOCK_TEXELS][4];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                for (int c = 0; c < 4; c++) {
+                    colors[i][c] = texels[i * 4 + c];
+                }
+            }
+            float low[4], high[4];
+            axisEndpoints(colors, BLOCK_TEXELS, 4, low, high);
+            Bc7Endpoint e0, e1;
+            uint8_t indices[BLOCK_TEXELS];
+            float error = quantizeBc7Block(colors, low, high, e0, e1, indices);
+
+            float weights[BLOCK_TEXELS];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                weights[i] = BC7_WEIGHTS[indices[i]] / 64.f;
+            }
+            if (leastSquaresEndpoints(colors, weights, BLOCK_TEXELS, 4, low, high)) {
+                Bc7Endpoint r0, r1;
+                uint8_t refined[BLOCK_TEXELS];
+                if (quantizeBc7Block(colors, low, high, r0, r1, refined) < error) {
+                    e0 = r0;
+                    e1 = r1;
+                    std::copy(refined, refined + BLOCK_TEXELS, indices);
+                }
+            }
+
+            // the first index is stored without its top bit, swap the endpoints when it is set
+            if (indices[0] & 8) {
+                std::swap(e0, e1);
+                for (uint8_t& index : indices) {
+                    index = static_cast<uint8_t>(15 - index);
+                }
+            }
+
+            std::memset(out, 0, 16);
+            BitWriter writer{out};
+            writer.write(1u << 6, 7); // mode 6
+            for (int c = 0; c < 4; c++) {
+                writer.write(e0.color[c], 7);
+                writer.write(e1.color[c], 7);
+            }
+            writer.write(e0.pBit, 1);
+            writer.write(e1.pBit, 1);
+            writer.write(indices[0], 3);
+            for (uint32_t i = 1; i < BLOCK_TEXELS; i++) {
+                writer.write(indices[i], 4);
+            }
+        }
+
+        void encodeBlock(BlockEncoding encoding, const Block& texels, uint8_t* out) {
+            switch (encoding) {
+                case BlockEncoding::BC1: encodeColorBlock(texels, false, out); break;
+                case BlockEncoding::BC1Alpha: encodeColorBlock(texels, true, out); break;
+                case BlockEncoding::BC3:
+                    encodeChannelBlock(texels, 3, out);
+                    encodeColorBlock(texels, false, out + 8);
+                    break;
+                case BlockEncoding::BC4: encodeChannelBlock(texels, 0, out); break;
+                case BlockEncoding::BC5:
+                    encodeChannelBlock(texels, 0, out);
+                    encodeChannelBlock(texels, 1, out + 8);
+                    break;
+                case BlockEncoding::BC7: encodeBc7Block(texels, out); break;
+            }
+        }
+    }
+
+    bool ODTextureEncoder::isEncodable(VkFormat format) {
+        EncodingInfo info;
+        return getEncodingInfo(format, info);
+    }
+
+    VkFormat ODTextureEncoder::getSourceFormat(VkFormat format) {
+        EncodingInfo info;
+        if (!getEncodingInfo(format, info)) {
+            throw std::runtime_error("texture format cannot be encoded!");
+        }
+        return info.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    ODTextureHandler::Image ODTextureEncoder::encode(const ODTextureHandler::Image &image, VkFormat format) {
+        if (image.format != getSourceFormat(format)) {
+            throw std::runtime_error("texture encoder source must be RGBA8 of the same color space!");
+        }
+        EncodingInfo info;
+        getEncodingInfo(format, info);
+
+        ODTextureHandler::Image encoded{};
+        encoded.format = format;
+        encoded.width = image.width;
+        encoded.height = image.height;
+        encoded.levels.resize(image.levels.size());
+        for (size_t level = 0; level < image.levels.size(); level++) {
+            uint64_t blocksX = (std::max(image.width >> level, 1u) + 3) / 4;
+            uint64_t blocksY = (std::max(image.height >> level, 1u) + 3) / 4;
+            encoded.levels[level] = {encoded.size, blocksX * blocksY * info.blockBytes};
+            encoded.size += encoded.levels[level].size;
+        }
+        auto storage = std::make_shared<std::vector<uint8_t>>(encoded.size);
+
+        ODThreadPool& pool = ODThreadPool::shared();
+        for (size_t level = 0; level < image.levels.size(); level++) {
+            uint32_t width = std::max(image.width >> level, 1u);
+            uint32_t height = std::max(image.height >> level, 1u);
+            uint32_t blocksX = (width + 3) / 4;
+            uint32_t blocksY = (height + 3) / 4;
+            const uint8_t* pixels = image.data.get() + image.levels[level].offset;
+            uint8_t* out = storage->data() + encoded.levels[level].offset;
+
+            pool.parallelFor(blocksY, std::min<size_t>(blocksY, pool.getConcurrency()),
+                [&](size_t, size_t begin, size_t end) {
+                    Block texels;
+                    for (size_t blockY = begin; blockY < end; blockY++) {
+                        for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                            // texels past the edge repeat the last row or column
+                            for (uint32_t y = 0; y < 4; y++) {
+                                uint32_t row = std::min(static_cast<uint32_t>(blockY) * 4 + y, height - 1);
+                                for (uint32_t x = 0; x < 4; x++) {
+                                    uint32_t column = std::min(blockX * 4 + x, width - 1);
+                                    std::memcpy(&texels[(y * 4 + x) * 4], pixels + (uint64_t{row} * width + column) * 4, 4);
+                                }
+                            }
+                            encodeBlock(info.encoding, texels, out + (blockY * blocksX + blockX) * info.blockBytes);
+                        }
+                    }
+                });
+        }
+
+        encoded.data = std::shared_ptr<const uint8_t>(storage, storage->data());
+        return encoded;
+    }
+}
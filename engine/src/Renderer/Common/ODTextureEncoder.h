@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ODTextureHandler.h"
+
+namespace ODEngine {
+
+    /*
+     * CPU block compression of imported textures, run once when their ODTextureCache is
+     * written. Blocks of each level are encoded in parallel on ODThreadPool::shared().
+     *
+     *  - BC1: principal axis endpoints refined by least squares, 1 bit alpha when a texel is
+     *    under half opacity (the RGBA formats).
+     *  - BC4 / BC5: min/max endpoints, 8 interpolated values.
+     *  - BC3: BC4 alpha block followed by a BC1 color block.
+     *  - BC7: mode 6 only (one RGBA subset, 4 bit indices), principal axis endpoints refined
+     *    by least squares with the best pair of p-bits.
+     *
+     * Every encoder minimizes the error on the stored values: sRGB formats are encoded as
+     * they are, like the hardware decodes them before the sRGB conversion.
+     */
+    class ODTextureEncoder {
+        public:
+            static bool isEncodable(VkFormat format);
+            // RGBA8 format of the same color space as format, the one encode takes
+            static VkFormat getSourceFormat(VkFormat format);
+
+            // image is a mip chain of getSourceFormat(format), as ODTextureCache::buildMipChain
+            // builds them. Throws std::runtime_error for another format.
+            static ODTextureHandler::Image encode(const ODTextureHandler::Image& image, VkFormat format);
+    };
+}
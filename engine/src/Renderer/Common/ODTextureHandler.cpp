@@ -1,5 +1,8 @@
 #include "ODTextureHandler.h"
+#include "ODTextureCache.h"
+#include "ODTextureEncoder.h"
 #include "../Vulkan/ODBuffer.h"
+#include "../Vulkan/ODMipGenerator.h"
 #include "../Vulkan/ODSwapChain.h"
 
 // libs
@@ -7,8 +10,12 @@
 #include <stb_image.h>
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <memory>
 
 namespace ODEngine {
     ODTextureHandler::ODTextureHandler(ODDevice &device)
@@ -18,12 +25,104 @@ namespace ODEngine {
     ODTextureHandler::~ODTextureHandler() {
         vkDestroySampler(m_device.device(), m_textureSampler, nullptr);
         vkDestroyImageView(m_device.device(), m_textureImageView, nullptr);
-        vkDestroyImage(m_device.device(), m_textureImage, nullptr);
-        vkFreeMemory(m_device.device(), m_textureImageMemory, nullptr);
+        m_device.destroyImage(m_textureImage, m_textureImageAllocation);
+    }
+
+    ODTextureHandler::Image ODTextureHandler::decode(const std::string &filepath, VkFormat format) {
+        Image image{};
+        if (std::filesystem::path(filepath).extension() == ".ktx2") {
+            if (!ODTextureCache::loadKtx2(filepath, image)) {
+                throw std::runtime_error("failed to load ktx2 texture!");
+            }
+            return image;
+        }
+        if (ODTextureCache::load(filepath, format, image)) {
+            return image;
+        }
+
+        int texWidth, texHeight, texChannels;
+        std::unique_ptr<stbi_uc, void (*)(void*)> pixels(
+            stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha), stbi_image_free);
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image!");
+        }
+        image = importPixels(pixels.get(), static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), format);
+        if (!ODTextureCache::write(filepath, image)) {
+            std::cerr << "failed to write texture cache for " << filepath << std::endl;
+            return image;
+        }
+        // streamed textures keep their source for later residency changes: a mapping of the
+        // cache rather than the whole chain on the heap
+        Image cached{};
+        if (ODTextureCache::load(filepath, format, cached)) {
+            image = std::move(cached);
+        }
+        return image;
+    }
+
+    ODTextureHandler::Image ODTextureHandler::decode(const uint8_t *encoded, size_t size, VkFormat format) {
+        int texWidth, texHeight, texChannels;
+        std::unique_ptr<stbi_uc, void (*)(void*)> pixels(
+            stbi_load_from_memory(encoded, static_cast<int>(size), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha),
+            stbi_image_free);
+        if (!pixels) {
+            throw std::runtime_error("failed to decode texture image!");
+        }
+        return importPixels(pixels.get(), static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), format);
+    }
+
+    ODTextureHandler::Image ODTextureHandler::importPixels(const uint8_t *pixels, uint32_t width, uint32_t height,
+        VkFormat format) {
+        bool compressed = ODTextureEncoder::isEncodable(format);
+        if (!compressed && format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM) {
+            throw std::runtime_error("texture format cannot be imported!");
+        }
+        Image image = ODTextureCache::buildMipChain(pixels, width, height,
+            compressed ? ODTextureEncoder::getSourceFormat(format) : format);
+        if (compressed) {
+            image = ODTextureEncoder::encode(image, format);
+        }
+        return image;
+    }
+
+    bool ODTextureHandler::isFormatSupported(ODDevice &device, VkFormat format) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(device.physicalDevice(), format, &properties);
+        VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        return (properties.optimalTilingFeatures & features) == features;
+    }
+
+    VkFormat ODTextureHandler::chooseFormat(ODDevice &device) {
+        for (VkFormat format : {VK_FORMAT_BC7_SRGB_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK}) {
+            if (isFormatSupported(device, format)) {
+                return format;
+            }
+        }
+        return VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    uint32_t ODTextureHandler::getLevelForResolution(const Image &image, float texels) {
+        uint32_t size = std::max(image.width, image.height);
+        if (image.levels.empty() || texels >= static_cast<float>(size)) {
+            return 0;
+        }
+        uint32_t level = static_cast<uint32_t>(std::floor(std::log2(size / std::max(texels, 1.f))));
+        return std::min(level, static_cast<uint32_t>(image.levels.size()) - 1);
     }
 
     void ODTextureHandler::addTexture(const std::string &filepath) {
-        createTextureImage(filepath);
+        addTexture(decode(filepath));
+    }
+
+    void ODTextureHandler::addTexture(const Image &image, uint32_t firstLevel) {
+        createTextureImage(image, firstLevel);
+        createTextureImageView();
+        createTextureSampler();
+    }
+
+    void ODTextureHandler::addTexture(const void *pixels, uint32_t width, uint32_t height) {
+        createTextureImage(pixels, width, height);
         createTextureImageView();
         createTextureSampler();
     }
@@ -37,50 +136,62 @@ namespace ODEngine {
         return imageInfo;
     }
 
-    void ODTextureHandler::createTextureImage(const std::string &filepath) {
-        int texWidth, texHeight, texChannels;
-        stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    void ODTextureHandler::createTextureImage(const void *pixels, uint32_t texWidth, uint32_t texHeight) {
         m_mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
+        VkDeviceSize imageSize = VkDeviceSize{texWidth} * texHeight * 4;
+        m_memorySize = imageSize * 4 / 3; // the mips add about a third
         std::cout << "Texture image size: " << imageSize << " bytes\n";
-        if (!pixels) {
-            throw std::runtime_error("failed to load texture image!");
-        }
 
-        ODBuffer stagingBuffer{
-            m_device,
-            imageSize,
-            1,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-        void* data;
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer(pixels, imageSize);
-        stbi_image_free(pixels);
-        ODSwapChain::createImage(m_device, texWidth, texHeight, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, 
-            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            m_textureImage, m_textureImageMemory);
-        
-        m_device.transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, 
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_mipLevels);
-        m_device.copyBufferToImage(stagingBuffer.getBuffer(), m_textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-
-        generateMipmaps(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, m_mipLevels);
-
-    }
-
-    void ODTextureHandler::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) {
-        VkFormatProperties formatProperties;
-        vkGetPhysicalDeviceFormatProperties(m_device.physicalDevice(), imageFormat, &formatProperties);
-        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
-            throw std::runtime_error("texture image format does not support linear blitting!");
+        m_format = VK_FORMAT_R8G8B8A8_SRGB;
+
+        // the mips are written by ODMipGenerator through storage views
+        ODSwapChain::createImage(m_device, texWidth, texHeight, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, m_format, VK_IMAGE_TILING_OPTIMAL, 
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | ODMipGenerator::IMAGE_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            m_textureImage, m_textureImageAllocation, ODMipGenerator::IMAGE_FLAGS);
+
+        m_device.uploadQueue().uploadImage(m_textureImage, m_format, pixels, imageSize, texWidth, texHeight, m_mipLevels, true);
+    }
+
+    void ODTextureHandler::createTextureImage(const Image &image, uint32_t firstLevel) {
+        if (!isFormatSupported(m_device, image.format)) {
+            throw std::runtime_error("texture format not supported by the device!");
+        }
+        if (firstLevel >= image.levels.size()) {
+            throw std::runtime_error("texture first level out of range!");
+        }
+        m_source = image;
+        m_firstLevel = firstLevel;
+        m_mipLevels = static_cast<uint32_t>(image.levels.size()) - firstLevel;
+        m_format = image.format;
+        uint32_t width = std::max(image.width >> firstLevel, 1u);
+        uint32_t height = std::max(image.height >> firstLevel, 1u);
+
+        ODSwapChain::createImage(m_device, width, height, m_mipLevels, VK_SAMPLE_COUNT_1_BIT, m_format,
+            VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_textureImage, m_textureImageAllocation);
+
+        // the resident levels are contiguous in the source (finest first or last), only that
+        // range is staged
+        VkDeviceSize begin = image.size;
+        VkDeviceSize end = 0;
+        for (uint32_t level = firstLevel; level < image.levels.size(); level++) {
+            begin = std::min(begin, image.levels[level].offset);
+            end = std::max(end, image.levels[level].offset + image.levels[level].size);
+        }
+        m_memorySize = 0;
+        std::vector<VkDeviceSize> levelOffsets;
+        for (uint32_t level = firstLevel; level < image.levels.size(); level++) {
+            levelOffsets.push_back(image.levels[level].offset - begin);
+            m_memorySize += image.levels[level].size;
         }
-        m_device.generateMipmaps(m_textureImage, texWidth, texHeight, m_mipLevels);
+        m_device.uploadQueue().uploadImageLevels(m_textureImage, image.data.get() + begin, end - begin, width,
+            height, m_mipLevels, levelOffsets.data());
     }
 
     void ODTextureHandler::createTextureImageView() {
-        m_textureImageView = ODSwapChain::createImageView(m_device, m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels);
+        // an sRGB view cannot carry the storage usage of images with generated mips
+        m_textureImageView = ODSwapChain::createImageView(m_device, m_textureImage, m_format, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels,
+            VK_IMAGE_USAGE_SAMPLED_BIT);
     }
 
     void ODTextureHandler::createTextureSampler() {
@@ -3,7 +3,10 @@
 #include "../Vulkan/ODDevice.h"
 
 // std
+#include <cstdint>
 #include<memory>
+#include <string>
+#include <vector>
 
 namespace ODEngine {
     class ODTextureHandler {
@@ -14,24 +17,81 @@ namespace ODEngine {
         ODTextureHandler(const ODTextureHandler&) = delete;
         ODTextureHandler& operator=(const ODTextureHandler&) = delete;
 
+        // Every mip level of a texture, level 0 first, laid out as the GPU copies them.
+        // data keeps the storage alive: the mapped .ktx2 file or the importer's buffer.
+        struct Image {
+            struct Level {
+                VkDeviceSize offset = 0; // from data
+                VkDeviceSize size = 0;
+            };
+
+            std::shared_ptr<const uint8_t> data;
+            VkDeviceSize size = 0; // bytes from data to the end of the last level
+            VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<Level> levels;
+        };
+
+        // .ktx2 files are read as they are. Other images go through their ODTextureCache of
+        // format: the first load decodes them with stb_image, builds the mips, block compresses
+        // them for the BC formats (ODTextureEncoder) and writes the cache. Safe to call from
+        // worker threads.
+        static Image decode(const std::string& filepath, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+        // Same import from an encoded image in memory (PNG, JPEG...), without a cache
+        static Image decode(const uint8_t* encoded, size_t size, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+
+        // sampled with linear filtering from optimal tiling images
+        static bool isFormatSupported(ODDevice& device, VkFormat format);
+        // Smallest format imported color textures can use on this device: BC7, then BC3, then
+        // RGBA8 (sRGB all of them)
+        static VkFormat chooseFormat(ODDevice& device);
+
+        // Smallest level of image at least texels wide on its largest side (level 0 when the
+        // texture is smaller)
+        static uint32_t getLevelForResolution(const Image& image, float texels);
+
         void addTexture(const std::string& filepath);
+        // One copy of the levels from firstLevel down, copied to the upload staging ring: the
+        // GPU image starts at firstLevel, finer levels take no memory. image is kept as the
+        // source of later residency changes. Throws when the device cannot sample image.format.
+        void addTexture(const Image& image, uint32_t firstLevel = 0);
+        // width * height RGBA8 pixels, mips generated on the GPU
+        void addTexture(const void* pixels, uint32_t width, uint32_t height);
 
         VkDescriptorImageInfo descriptorInfo();
+
+        // empty levels for textures added from a file path or raw pixels
+        const Image& getSource() const { return m_source; }
+        // finest level of the source resident on the GPU
+        uint32_t getFirstLevel() const { return m_firstLevel; }
+        // GPU bytes of the resident levels
+        uint64_t getMemorySize() const { return m_memorySize; }
+
+        // element of ODBindlessTextures holding this texture, set by ODAssetRegistry
+        uint32_t getBindlessIndex() const { return m_bindlessIndex; }
+        void setBindlessIndex(uint32_t index) { m_bindlessIndex = index; }
     
     private:
-            void createTextureImage(const std::string& filepath);
+            // mips built and block compressed for format from RGBA8 pixels
+            static Image importPixels(const uint8_t* pixels, uint32_t width, uint32_t height, VkFormat format);
+            void createTextureImage(const void* pixels, uint32_t width, uint32_t height);
+            void createTextureImage(const Image& image, uint32_t firstLevel);
             void createTextureImageView();
             void createTextureSampler();
 
-            void generateMipmaps(VkImage image,  VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
-
     private:
         ODDevice& m_device;
         
         VkImage m_textureImage = VK_NULL_HANDLE;
         uint32_t m_mipLevels;
-        VkDeviceMemory m_textureImageMemory = VK_NULL_HANDLE;
+        VkFormat m_format = VK_FORMAT_R8G8B8A8_SRGB;
+        Image m_source{};
+        uint32_t m_firstLevel = 0;
+        uint64_t m_memorySize = 0;
+        ODAllocation m_textureImageAllocation{};
         VkImageView m_textureImageView = VK_NULL_HANDLE;
         VkSampler m_textureSampler = VK_NULL_HANDLE;
+        uint32_t m_bindlessIndex = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "ODVertexCompression.h"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+
+namespace ODEngine {
+
+    namespace {
+        constexpr float POSITION_RANGE = 65535.f;
+
+        glm::vec2 signNotZero(const glm::vec2& v){
+            return {v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f};
+        }
+
+        // expects a unit vector
+        glm::vec2 octahedralEncode(const glm::vec3& n){
+            glm::vec2 p = glm::vec2(n.x, n.y) / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+            if(n.z < 0.f){
+                p = (1.f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+            }
+            return p;
+        }
+
+        // must match octahedralDecode in simple_shader_compact.vert
+        glm::vec3 octahedralDecode(const glm::vec2& p){
+            glm::vec3 n(p.x, p.y, 1.f - std::abs(p.x) - std::abs(p.y));
+            if(n.z < 0.f){
+                glm::vec2 xy = (1.f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+                n.x = xy.x;
+                n.y = xy.y;
+            }
+            return glm::normalize(n);
+        }
+
+        float maxComponent(const glm::vec3& v){
+            return std::max(v.x, std::max(v.y, v.z));
+        }
+    }
+
+    bool compressVertices(const ODModel::Vertex* vertices, uint32_t vertexCount, const glm::vec3& boundsMin,
+        const glm::vec3& boundsMax, const ODVertexCompressionSettings& settings, ODCompressedVertices& out){
+        const glm::vec3 extent = boundsMax - boundsMin;
+
+        out.vertices.resize(vertexCount);
+        out.dequantize = glm::mat4{1.f};
+        out.dequantize[0][0] = extent.x;
+        out.dequantize[1][1] = extent.y;
+        out.dequantize[2][2] = extent.z;
+        out.dequantize[3] = glm::vec4(boundsMin, 1.f);
+        out.positionError = out.normalErrorDegrees = out.uvError = out.colorError = 0.f;
+
+        // flat axes keep q = 0, the dequantize scale of 0 restores them exactly
+        glm::vec3 invExtent{0.f};
+        for(int axis = 0; axis < 3; axis++){
+            if(extent[axis] > 0.f){
+                invExtent[axis] = 1.f / extent[axis];
+            }
+        }
+
+        float maxNormalCos = 1.f;
+        for(uint32_t i = 0; i < vertexCount; i++){
+            const ODModel::Vertex& vertex = vertices[i];
+            ODModel::CompactVertex& compact = out.vertices[i];
+
+            glm::vec3 unorm = glm::clamp((vertex.position - boundsMin) * invExtent, 0.f, 1.f);
+            glm::vec3 quantized = glm::round(unorm * POSITION_RANGE);
+            for(int axis = 0; axis < 3; axis++){
+                compact.position[axis] = static_cast<uint16_t>(quantized[axis]);
+            }
+            compact.position[3] = 0;
+            glm::vec3 decodedPosition = boundsMin + quantized / POSITION_RANGE * extent;
+            out.positionError = std::max(out.positionError, maxComponent(glm::abs(decodedPosition - vertex.position)));
+
+            // the shaders normalize the normal anyway, only the direction has to survive
+            float normalLength = glm::length(vertex.normal);
+            if(!(normalLength > 0.f)){
+                return false;
+            }
+            glm::vec3 normal = vertex.normal / normalLength;
+            compact.normal = glm::packSnorm2x16(octahedralEncode(normal));
+            glm::vec3 decodedNormal = octahedralDecode(glm::unpackSnorm2x16(compact.normal));
+            maxNormalCos = std::min(maxNormalCos, glm::dot(normal, decodedNormal));
+
+            compact.uv = glm::packHalf2x16(vertex.uv);
+            glm::vec2 uvError = glm::abs(glm::unpackHalf2x16(compact.uv) - vertex.uv);
+            out.uvError = std::max(out.uvError, std::max(uvError.x, uvError.y));
+
+            compact.color = glm::packUnorm4x8(glm::vec4(vertex.color, 1.f));
+            glm::vec3 decodedColor = glm::vec3(glm::unpackUnorm4x8(compact.color));
+            out.colorError = std::max(out.colorError, maxComponent(glm::abs(decodedColor - vertex.color)));
+        }
+        out.normalErrorDegrees = glm::degrees(std::acos(std::clamp(maxNormalCos, -1.f, 1.f)));
+
+        // uvs beyond the half float range decode to inf and fail here as well
+        return out.positionError <= settings.maxPositionError
+            && out.normalErrorDegrees <= settings.maxNormalErrorDegrees
+            && out.uvError <= settings.maxUvError
+            && out.colorError <= settings.maxColorError;
+    }
+}
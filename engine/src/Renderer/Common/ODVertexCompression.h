@@ -0,0 +1,36 @@
+#pragma once
+
+#include "ODModel.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace ODEngine {
+
+    struct ODCompressedVertices {
+        std::vector<ODModel::CompactVertex> vertices;
+        // translate(boundsMin) * scale(boundsMax - boundsMin), the unorm positions are
+        // fetched in [0, 1] so this rebuilds object space positions
+        glm::mat4 dequantize{1.f};
+
+        // largest round-trip error measured for each attribute
+        float positionError = 0.f;
+        float normalErrorDegrees = 0.f;
+        float uvError = 0.f;
+        float colorError = 0.f;
+    };
+
+    /*
+     * Quantizes vertices into ODModel::CompactVertex:
+     *  - position: 16 bit unorm per axis inside [boundsMin, boundsMax]
+     *  - normal: octahedral mapping, 16 bit snorm per component
+     *  - uv: half floats
+     *  - color: 8 bit unorm
+     * Every vertex is decoded back the way the shader does it. Returns false, and the
+     * mesh should stay in the full Vertex layout, when any error exceeds the settings.
+     * Zero length normals cannot be encoded and reject the mesh.
+     */
+    bool compressVertices(const ODModel::Vertex* vertices, uint32_t vertexCount, const glm::vec3& boundsMin,
+        const glm::vec3& boundsMax, const ODVertexCompressionSettings& settings, ODCompressedVertices& out);
+}
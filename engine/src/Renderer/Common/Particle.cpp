@@ -27,16 +27,6 @@ namespace ODEngine {
             }
         }
         void ParticleSystem::createParticleBuffers() {
-            ODBuffer computeStagingBuffer = ODBuffer {
-                m_device,
-                sizeof(ODParticles::Particle),
-                ODParticles::PARTICLE_COUNT,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // vérifier
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
-            computeStagingBuffer.map();
-            computeStagingBuffer.writeToBuffer((void*)m_particles.data());
-            
             m_particleBuffers.resize(ODSwapChain::MAX_FRAMES_IN_FLIGHT);
             for (size_t i = 0; i < ODSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
             m_particleBuffers[i] = std::make_unique<ODBuffer>( // liste de listes (2*2) plutôt ?
@@ -46,9 +36,9 @@ namespace ODEngine {
                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
                 );
-            m_device.copyBuffer(
-                    computeStagingBuffer.getBuffer(),
+            m_device.uploadQueue().uploadBuffer(
                     m_particleBuffers[i]->getBuffer(),
+                    m_particles.data(),
                     sizeof(ODParticles::Particle) * ODParticles::PARTICLE_COUNT
                 );
             }
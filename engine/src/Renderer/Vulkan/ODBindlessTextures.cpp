@@ -0,0 +1,79 @@
+#include "ODBindlessTextures.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace ODEngine {
+
+ODBindlessTextures::ODBindlessTextures(ODDevice &device, uint32_t capacity)
+    : device_{device} {
+  VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+  vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+  VkPhysicalDeviceProperties2 properties{};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &vulkan12Properties;
+  vkGetPhysicalDeviceProperties2(device_.physicalDevice(), &properties);
+  capacity_ = std::min({capacity,
+      vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+      vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages});
+
+  setLayout_ = ODDescriptorSetLayout::Builder(device_)
+      .addBinding(
+          BINDING,
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          VK_SHADER_STAGE_FRAGMENT_BIT,
+          capacity_,
+          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT)
+      .build();
+  pool_ = ODDescriptorPool::Builder(device_)
+      .setMaxSets(1)
+      .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+      .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity_)
+      .build();
+  if (!pool_->allocateDescriptorSet(setLayout_->getDescriptorSetLayout(), descriptorSet_)) {
+    throw std::runtime_error("failed to allocate bindless texture descriptor set!");
+  }
+}
+
+// the set goes with its pool
+ODBindlessTextures::~ODBindlessTextures() {}
+
+uint32_t ODBindlessTextures::add(const VkDescriptorImageInfo &imageInfo) {
+  uint32_t index;
+  if (!freeIndices_.empty()) {
+    index = freeIndices_.back();
+    freeIndices_.pop_back();
+  } else if (nextIndex_ < capacity_) {
+    index = nextIndex_++;
+  } else {
+    throw std::runtime_error("bindless texture array is full!");
+  }
+  write(index, imageInfo);
+  textureCount_++;
+  return index;
+}
+
+void ODBindlessTextures::remove(uint32_t index) {
+  assert(index != DEFAULT_TEXTURE && index < nextIndex_ && "not an added texture");
+  // partially bound: the stale descriptor stays, nothing samples it anymore
+  freeIndices_.push_back(index);
+  textureCount_--;
+}
+
+void ODBindlessTextures::setDefaultTexture(const VkDescriptorImageInfo &imageInfo) {
+  write(DEFAULT_TEXTURE, imageInfo);
+  if (!hasDefault_) {
+    hasDefault_ = true;
+    textureCount_++;
+  }
+}
+
+void ODBindlessTextures::write(uint32_t index, VkDescriptorImageInfo imageInfo) {
+  ODDescriptorWriter(*setLayout_, *pool_)
+      .writeImage(BINDING, index, &imageInfo)
+      .overwrite(descriptorSet_);
+}
+
+}  // namespace ODEngine
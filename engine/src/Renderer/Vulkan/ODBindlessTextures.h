@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ODDescriptors.h"
+#include "ODDevice.h"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ODEngine {
+
+// One descriptor set holding a large array of combined image samplers (set 1 of the
+// mesh pipelines). Textures are written into a free element when they become
+// resident and drawn by index, pushed per object, so any number of materials is
+// drawn without rebinding descriptor sets.
+//
+// The binding is update-after-bind and partially bound: elements are written while
+// the set is bound by frames in flight, unused elements stay unwritten. An element
+// must not be freed while a frame in flight can still sample it, ODAssetRegistry
+// frees textures MAX_FRAMES_IN_FLIGHT frames after their last release.
+class ODBindlessTextures {
+ public:
+  static constexpr uint32_t BINDING = 0;
+  static constexpr uint32_t DEFAULT_CAPACITY = 4096;
+  // reserved for the texture of objects without one (or whose texture is not
+  // resident yet), set with setDefaultTexture
+  static constexpr uint32_t DEFAULT_TEXTURE = 0;
+
+  // capacity is clamped to the device's update-after-bind sampled image limits
+  ODBindlessTextures(ODDevice &device, uint32_t capacity = DEFAULT_CAPACITY);
+  ~ODBindlessTextures();
+
+  ODBindlessTextures(const ODBindlessTextures &) = delete;
+  ODBindlessTextures &operator=(const ODBindlessTextures &) = delete;
+
+  // index of a free element now holding imageInfo, throws when the array is full
+  uint32_t add(const VkDescriptorImageInfo &imageInfo);
+  // the element can be handed out again right away, callers wait for the frames
+  // in flight first
+  void remove(uint32_t index);
+  void setDefaultTexture(const VkDescriptorImageInfo &imageInfo);
+
+  VkDescriptorSetLayout getSetLayout() const { return setLayout_->getDescriptorSetLayout(); }
+  VkDescriptorSet getDescriptorSet() const { return descriptorSet_; }
+  uint32_t getCapacity() const { return capacity_; }
+  // textures in the array, the default one included once set
+  uint32_t getTextureCount() const { return textureCount_; }
+
+ private:
+  void write(uint32_t index, VkDescriptorImageInfo imageInfo);
+
+  ODDevice &device_;
+  uint32_t capacity_;
+  uint32_t textureCount_ = 0;
+  bool hasDefault_ = false;
+  std::unique_ptr<ODDescriptorSetLayout> setLayout_;
+  std::unique_ptr<ODDescriptorPool> pool_;
+  VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
+
+  // never written elements above nextIndex_, freed ones in freeIndices_
+  uint32_t nextIndex_ = DEFAULT_TEXTURE + 1;
+  std::vector<uint32_t> freeIndices_;
+};
+
+}  // namespace ODEngine
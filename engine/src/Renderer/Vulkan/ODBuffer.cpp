@@ -43,18 +43,20 @@ namespace ODEngine {
         memoryPropertyFlags{memoryPropertyFlags} {
     alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
     bufferSize = alignmentSize * instanceCount;
-    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+    device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
   }
   
   ODBuffer::~ODBuffer() {
     unmap();
-    vkDestroyBuffer(device.device(), buffer, nullptr);
-    vkFreeMemory(device.device(), memory, nullptr);
+    device.destroyBuffer(buffer, allocation);
   }
   
   /**
    * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
    *
+   * @note Host visible memory blocks are persistently mapped by ODMemoryAllocator, so this only
+   * resolves a pointer inside the block and never calls vkMapMemory
+   *
    * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
    * buffer range.
    * @param offset (Optional) Byte offset from beginning
@@ -62,20 +64,21 @@ namespace ODEngine {
    * @return VkResult of the buffer mapping call
    */
   VkResult ODBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-    assert(buffer && memory && "Called map on buffer before create");
-    return vkMapMemory(device.device(), memory, offset, size, 0, &mapped);
+    assert(buffer && allocation.isValid() && "Called map on buffer before create");
+    if (allocation.mapped == nullptr) {
+      return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+    mapped = static_cast<char *>(allocation.mapped) + offset;
+    return VK_SUCCESS;
   }
   
   /**
    * Unmap a mapped memory range
    *
-   * @note Does not return a result as vkUnmapMemory can't fail
+   * @note The underlying block stays mapped, only the buffer's pointer is released
    */
   void ODBuffer::unmap() {
-    if (mapped) {
-      vkUnmapMemory(device.device(), memory);
-      mapped = nullptr;
-    }
+    mapped = nullptr;
   }
   
   /**
@@ -111,11 +114,7 @@ namespace ODEngine {
    * @return VkResult of the flush call
    */
   VkResult ODBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-    VkMappedMemoryRange mappedRange = {};
-    mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
+    VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
     return vkFlushMappedMemoryRanges(device.device(), 1, &mappedRange);
   }
   
@@ -131,12 +130,38 @@ namespace ODEngine {
    * @return VkResult of the invalidate call
    */
   VkResult ODBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
+    VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
+    return vkInvalidateMappedMemoryRanges(device.device(), 1, &mappedRange);
+  }
+  
+  /**
+   * Translate a range of this buffer into a range of its memory block
+   *
+   * @note The buffer lives at an offset inside a shared VkDeviceMemory, and flush/invalidate
+   * ranges must be aligned on nonCoherentAtomSize. Allocator nodes are atom aligned, so rounding
+   * never leaves the buffer's own node.
+   *
+   * @param size Size of the range, or VK_WHOLE_SIZE for the rest of the buffer
+   * @param offset Byte offset from beginning of the buffer
+   *
+   * @return VkMappedMemoryRange covering the requested range
+   */
+  VkMappedMemoryRange ODBuffer::getMappedRange(VkDeviceSize size, VkDeviceSize offset) const {
+    VkDeviceSize atomSize = device.properties.limits.nonCoherentAtomSize;
+    VkDeviceSize start = allocation.offset + offset;
+    VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + bufferSize : start + size;
+
     VkMappedMemoryRange mappedRange = {};
     mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedRange.memory = memory;
-    mappedRange.offset = offset;
-    mappedRange.size = size;
-    return vkInvalidateMappedMemoryRanges(device.device(), 1, &mappedRange);
+    mappedRange.memory = allocation.memory;
+    mappedRange.offset = start - start % atomSize;
+    if (allocation.dedicated) {
+      // a dedicated memory object may not be a multiple of the atom size
+      mappedRange.size = VK_WHOLE_SIZE;
+    } else {
+      mappedRange.size = (end + atomSize - 1) / atomSize * atomSize - mappedRange.offset;
+    }
+    return mappedRange;
   }
   
   /**
@@ -42,11 +42,12 @@ class ODBuffer {
  
  private:
   static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+  VkMappedMemoryRange getMappedRange(VkDeviceSize size, VkDeviceSize offset) const;
  
   ODDevice& device;
   void* mapped = nullptr;
   VkBuffer buffer = VK_NULL_HANDLE;
-  VkDeviceMemory memory = VK_NULL_HANDLE;
+  ODAllocation allocation{};
  
   VkDeviceSize bufferSize;
   uint32_t instanceCount;
@@ -12,7 +12,8 @@ namespace ODEngine {
         uint32_t binding,
         VkDescriptorType descriptorType,
         VkShaderStageFlags stageFlags,
-        uint32_t count) {
+        uint32_t count,
+        VkDescriptorBindingFlags flags) {
         assert(bindings.count(binding) == 0 && "Binding already in use");
         VkDescriptorSetLayoutBinding layoutBinding{};
         layoutBinding.binding = binding;
@@ -20,27 +21,48 @@ namespace ODEngine {
         layoutBinding.descriptorCount = count;
         layoutBinding.stageFlags = stageFlags;
         bindings[binding] = layoutBinding;
+        if (flags != 0) {
+            bindingFlags[binding] = flags;
+        }
         return *this;
     }
     
     std::unique_ptr<ODDescriptorSetLayout> ODDescriptorSetLayout::Builder::build() const {
-        return std::make_unique<ODDescriptorSetLayout>(device, bindings);
+        return std::make_unique<ODDescriptorSetLayout>(device, bindings, bindingFlags);
     }
     
     // *************** Descriptor Set Layout *********************
     
     ODDescriptorSetLayout::ODDescriptorSetLayout(
-        ODDevice &device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+        ODDevice &device,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags)
         : device{device}, bindings{bindings} {
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+        bool updateAfterBind = false;
         for (auto kv : bindings) {
             setLayoutBindings.push_back(kv.second);
+            auto flags = bindingFlags.find(kv.first);
+            setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+            updateAfterBind |= (setLayoutBindingFlags.back() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
         }
     
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+        if (!bindingFlags.empty()) {
+            descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+        }
+        if (updateAfterBind) {
+            descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        }
         
         if (vkCreateDescriptorSetLayout(
                 device.device(),
@@ -181,6 +203,28 @@ namespace ODEngine {
         return *this;
     }
     
+    ODDescriptorWriter &ODDescriptorWriter::writeImage(
+        uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo *imageInfo) {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+        
+        auto &bindingDescription = setLayout.bindings[binding];
+        
+        assert(
+            arrayElement < bindingDescription.descriptorCount &&
+            "Array element out of the binding's range");
+        
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.pImageInfo = imageInfo;
+        write.descriptorCount = 1;
+        
+        writes.push_back(write);
+        return *this;
+    }
+    
     bool ODDescriptorWriter::build(VkDescriptorSet &set) {
         bool success = pool.allocateDescriptorSet(setLayout.getDescriptorSetLayout(), set);
         if (!success) {
@@ -19,16 +19,22 @@ namespace ODEngine {
                     uint32_t binding,
                     VkDescriptorType descriptorType,
                     VkShaderStageFlags stageFlags,
-                    uint32_t count = 1);
+                    uint32_t count = 1,
+                    VkDescriptorBindingFlags bindingFlags = 0);
                 std::unique_ptr<ODDescriptorSetLayout> build() const;
             
             private:
                 ODDevice &device;
                 std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+                std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
             };
     
+            // a layout with update-after-bind bindings has to be allocated from a pool created
+            // with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT
             ODDescriptorSetLayout(
-                ODDevice &device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+                ODDevice &device,
+                std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+                const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
             ~ODDescriptorSetLayout();
             ODDescriptorSetLayout(const ODDescriptorSetLayout &) = delete;
             ODDescriptorSetLayout &operator=(const ODDescriptorSetLayout &) = delete;
@@ -94,6 +100,8 @@ namespace ODEngine {
             
             ODDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
             ODDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+            // one element of an array binding
+            ODDescriptorWriter &writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo *imageInfo);
             
             bool build(VkDescriptorSet &set);
             void overwrite(VkDescriptorSet &set);
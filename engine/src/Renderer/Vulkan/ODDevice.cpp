@@ -50,9 +50,15 @@ ODDevice::ODDevice(ODWindow &window) : m_window(window) {
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  allocator_ = std::make_unique<ODMemoryAllocator>(device_, physicalDevice_);
+  uploadQueue_ = std::make_unique<ODUploadQueue>(*this);
+  geometryPool_ = std::make_unique<ODGeometryPool>(*this);
 }
 
 ODDevice::~ODDevice() {
+  uploadQueue_.reset(); // waits for pending uploads
+  geometryPool_.reset();
+  allocator_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -75,7 +81,7 @@ void ODDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -153,8 +159,13 @@ void ODDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice_);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsAndComputeFamily,
-                                            indices.presentFamily};
+  graphicsFamily_ = indices.graphicsAndComputeFamily;
+  transferFamily_ = indices.transferFamilyHasValue
+                        ? indices.transferFamily
+                        : indices.graphicsAndComputeFamily;
+
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsAndComputeFamily, indices.presentFamily, transferFamily_};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -166,19 +177,60 @@ void ODDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  // optional features, the indirect draw paths of MeshletCullingSystem and
+  // SimpleRendererSystem check them
+  VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+  supportedVulkan12Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &supportedVulkan12Features;
+  vkGetPhysicalDeviceFeatures2(physicalDevice_, &supportedFeatures);
+  multiDrawIndirect_ = supportedFeatures.features.multiDrawIndirect == VK_TRUE;
+  drawIndirectCount_ = multiDrawIndirect_ &&
+                       supportedVulkan12Features.drawIndirectCount == VK_TRUE;
+  drawIndirectFirstInstance_ =
+      supportedFeatures.features.drawIndirectFirstInstance == VK_TRUE;
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
   deviceFeatures.sampleRateShading =
       VK_TRUE; // enable sample shading for the device (multisampling)
+  deviceFeatures.multiDrawIndirect = multiDrawIndirect_ ? VK_TRUE : VK_FALSE;
+  deviceFeatures.drawIndirectFirstInstance =
+      drawIndirectFirstInstance_ ? VK_TRUE : VK_FALSE;
+  deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+  // block compressed textures, ODTextureHandler::chooseFormat checks the formats themselves
+  deviceFeatures.textureCompressionBC = supportedFeatures.features.textureCompressionBC;
+  deviceFeatures.textureCompressionASTC_LDR =
+      supportedFeatures.features.textureCompressionASTC_LDR;
+
+  // core 1.2 features, timeline semaphores are used by ODUploadQueue
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.timelineSemaphore = VK_TRUE;
+  vulkan12Features.drawIndirectCount = drawIndirectCount_ ? VK_TRUE : VK_FALSE;
+  // descriptor indexing, for the texture array of ODBindlessTextures
+  vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+  vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+  vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+
+  VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+  deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  deviceFeatures2.pNext = &vulkan12Features;
+  deviceFeatures2.features = deviceFeatures;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &deviceFeatures2;
 
   createInfo.queueCreateInfoCount =
       static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-  createInfo.pEnabledFeatures = &deviceFeatures;
+  createInfo.pEnabledFeatures = nullptr; // passed through deviceFeatures2
   createInfo.enabledExtensionCount =
       static_cast<uint32_t>(deviceExtensions.size());
   createInfo.ppEnabledExtensionNames = deviceExtensions.data();
@@ -203,6 +255,12 @@ void ODDevice::createLogicalDevice() {
   vkGetDeviceQueue(device_, indices.graphicsAndComputeFamily, 0,
                    &computeQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, transferFamily_, 0, &transferQueue_);
+
+  if (hasDedicatedTransferQueue()) {
+    std::cout << "dedicated transfer queue family: " << transferFamily_
+              << std::endl;
+  }
 }
 
 void ODDevice::createCommandPool() {
@@ -236,11 +294,28 @@ bool ODDevice::isDeviceSuitable(VkPhysicalDevice device) {
                         !swapChainSupport.presentModes.empty();
   }
 
-  VkPhysicalDeviceFeatures supportedFeatures;
-  vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+  VkPhysicalDeviceProperties deviceProperties;
+  vkGetPhysicalDeviceProperties(device, &deviceProperties);
+  if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+
+  VkPhysicalDeviceVulkan12Features supportedVulkan12Features = {};
+  supportedVulkan12Features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &supportedVulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
   return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+         supportedFeatures.features.samplerAnisotropy &&
+         supportedFeatures.features.shaderSampledImageArrayDynamicIndexing &&
+         supportedVulkan12Features.timelineSemaphore &&
+         supportedVulkan12Features.runtimeDescriptorArray &&
+         supportedVulkan12Features.descriptorBindingPartiallyBound &&
+         supportedVulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+         supportedVulkan12Features.shaderSampledImageArrayNonUniformIndexing;
 }
 
 void ODDevice::populateDebugMessengerCreateInfo(
@@ -360,9 +435,13 @@ QueueFamilyIndices ODDevice::findQueueFamilies(VkPhysicalDevice device) {
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount,
                                            queueFamilies.data());
 
+  // a transfer-only family (DMA engine) beats one that also does compute
+  bool transferFamilyIsTransferOnly = false;
+
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if ((queueFamily.queueCount > 0) &&
+    if (!indices.graphicsAndComputeFamilyHasValue &&
+        (queueFamily.queueCount > 0) &&
         (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
         (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
       indices.graphicsAndComputeFamily = i;
@@ -370,12 +449,21 @@ QueueFamilyIndices ODDevice::findQueueFamilies(VkPhysicalDevice device) {
     }
     VkBool32 presentSupport = false;
     vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
+    if (!indices.presentFamilyHasValue && queueFamily.queueCount > 0 &&
+        presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
     }
-    if (indices.isComplete()) {
-      break;
+    if (queueFamily.queueCount > 0 &&
+        (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+        !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+      bool transferOnly = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+      if (!indices.transferFamilyHasValue ||
+          (transferOnly && !transferFamilyIsTransferOnly)) {
+        indices.transferFamily = i;
+        indices.transferFamilyHasValue = true;
+        transferFamilyIsTransferOnly = transferOnly;
+      }
     }
 
     i++;
@@ -445,7 +533,7 @@ uint32_t ODDevice::findMemoryType(uint32_t typeFilter,
 
 void ODDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                             VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                            VkDeviceMemory &bufferMemory) {
+                            ODAllocation &bufferAllocation) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -459,18 +547,19 @@ void ODDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      findMemoryType(memRequirements.memoryTypeBits, properties);
+  bufferAllocation = allocator_->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties), true);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory,
+                         bufferAllocation.offset) != VK_SUCCESS) {
+    throw std::runtime_error("failed to bind vertex buffer memory!");
   }
+}
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+void ODDevice::destroyBuffer(VkBuffer buffer, ODAllocation &bufferAllocation) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_->free(bufferAllocation);
 }
 
 VkCommandBuffer ODDevice::beginSingleTimeCommands() {
@@ -567,80 +656,6 @@ void ODDevice::transitionImageLayout(VkImage image, VkFormat format,
   endSingleTimeCommands(commandBuffer);
 }
 
-void ODDevice::generateMipmaps(VkImage image, int32_t texWidth,
-                               int32_t texHeight, uint32_t mipLevels) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.image = image;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-  barrier.subresourceRange.levelCount = 1;
-
-  int32_t mipWidth = texWidth;
-  int32_t mipHeight = texHeight;
-  for (uint32_t i = 1; i < mipLevels; i++) {
-    barrier.subresourceRange.baseMipLevel = i - 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
-                         nullptr, 1, &barrier);
-
-    VkImageBlit blit{};
-    blit.srcOffsets[0] = {0, 0, 0};
-    blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
-    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    blit.srcSubresource.mipLevel = i - 1;
-    blit.srcSubresource.baseArrayLayer = 0;
-    blit.srcSubresource.layerCount = 1;
-    blit.dstOffsets[0] = {0, 0, 0};
-    blit.dstOffsets[1] = {mipWidth > 1 ? mipWidth / 2 : 1,
-                          mipHeight > 1 ? mipHeight / 2 : 1, 1};
-    blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    blit.dstSubresource.mipLevel = i;
-    blit.dstSubresource.baseArrayLayer = 0;
-    blit.dstSubresource.layerCount = 1;
-
-    vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                   image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
-                   VK_FILTER_LINEAR);
-
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
-                         0, nullptr, 1, &barrier);
-
-    if (mipWidth > 1)
-      mipWidth /= 2;
-    if (mipHeight > 1)
-      mipHeight /= 2;
-  }
-
-  barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-  vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
-
-  endSingleTimeCommands(commandBuffer);
-}
-
 void ODDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
                                  uint32_t height, uint32_t layerCount) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
@@ -666,7 +681,7 @@ void ODDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
 void ODDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo,
                                    VkMemoryPropertyFlags properties,
                                    VkImage &image,
-                                   VkDeviceMemory &imageMemory) {
+                                   ODAllocation &imageAllocation) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -674,22 +689,22 @@ void ODDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo,
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      findMemoryType(memRequirements.memoryTypeBits, properties);
+  imageAllocation = allocator_->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
-
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+  if (vkBindImageMemory(device_, image, imageAllocation.memory,
+                        imageAllocation.offset) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
+void ODDevice::destroyImage(VkImage image, ODAllocation &imageAllocation) {
+  vkDestroyImage(device_, image, nullptr);
+  allocator_->free(imageAllocation);
+}
+
 VkSampleCountFlagBits ODDevice::getMaxUsableSampleCount() {
   VkSampleCountFlags counts = properties.limits.framebufferColorSampleCounts &
                               properties.limits.framebufferDepthSampleCounts;
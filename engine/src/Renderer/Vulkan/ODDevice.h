@@ -1,8 +1,12 @@
 #pragma once
 
 #include "../Common/ODWindow.h"
+#include "ODGeometryPool.h"
+#include "ODMemoryAllocator.h"
+#include "ODUploadQueue.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,8 +21,10 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsAndComputeFamily ;
   uint32_t presentFamily;
+  uint32_t transferFamily; // family without graphics support, optional
   bool graphicsAndComputeFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsAndComputeFamilyHasValue && presentFamilyHasValue; }
 };
 
@@ -46,7 +52,20 @@ class ODDevice {
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue computeQueue() { return computeQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // Falls back to the graphics queue when the device has no dedicated transfer family
+  VkQueue transferQueue() { return transferQueue_; }
+  uint32_t graphicsQueueFamily() { return graphicsFamily_; }
+  uint32_t transferQueueFamily() { return transferFamily_; }
+  bool hasDedicatedTransferQueue() { return transferFamily_ != graphicsFamily_; }
   VkSampleCountFlagBits getMsaaSamples() { return msaaSamples; }
+  ODMemoryAllocator &allocator() { return *allocator_; }
+  ODUploadQueue &uploadQueue() { return *uploadQueue_; }
+  ODGeometryPool &geometryPool() { return *geometryPool_; }
+  // optional features, enabled when the physical device has them
+  bool supportsMultiDrawIndirect() const { return multiDrawIndirect_; }
+  bool supportsDrawIndirectCount() const { return drawIndirectCount_; }
+  // indirect commands with a firstInstance other than 0
+  bool supportsDrawIndirectFirstInstance() const { return drawIndirectFirstInstance_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice_); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -60,14 +79,14 @@ class ODDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      ODAllocation &bufferAllocation);
+  void destroyBuffer(VkBuffer buffer, ODAllocation &bufferAllocation);
   
       VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, 
     uint32_t mipLevels = 1); 
-  void generateMipmaps(VkImage image, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -75,7 +94,8 @@ class ODDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      ODAllocation &imageAllocation);
+  void destroyImage(VkImage image, ODAllocation &imageAllocation);
 
   VkSampleCountFlagBits getMaxUsableSampleCount();
 
@@ -112,6 +132,16 @@ class ODDevice {
   VkQueue graphicsQueue_;
   VkQueue computeQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  uint32_t graphicsFamily_ = 0;
+  uint32_t transferFamily_ = 0;
+  bool multiDrawIndirect_ = false;
+  bool drawIndirectCount_ = false;
+  bool drawIndirectFirstInstance_ = false;
+
+  std::unique_ptr<ODMemoryAllocator> allocator_;
+  std::unique_ptr<ODUploadQueue> uploadQueue_;
+  std::unique_ptr<ODGeometryPool> geometryPool_;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
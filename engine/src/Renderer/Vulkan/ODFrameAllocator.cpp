@@ -0,0 +1,51 @@
+#include "ODFrameAllocator.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace ODEngine {
+
+ODFrameAllocator::ODFrameAllocator(
+    ODDevice &device, uint32_t frameCount, VkDeviceSize bytesPerFrame)
+    : device_{device}, frameCount_{frameCount} {
+  alignment_ = std::max<VkDeviceSize>(
+      1, device_.properties.limits.minUniformBufferOffsetAlignment);
+  bytesPerFrame_ = (bytesPerFrame + alignment_ - 1) / alignment_ * alignment_;
+
+  buffer_ = std::make_unique<ODBuffer>(
+      device_,
+      bytesPerFrame_,
+      frameCount_,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  if (buffer_->map() != VK_SUCCESS) {
+    throw std::runtime_error("failed to map frame allocator buffer!");
+  }
+  mapped_ = static_cast<uint8_t *>(buffer_->getMappedMemory());
+}
+
+void ODFrameAllocator::beginFrame(uint32_t frameIndex) {
+  frameBegin_ = bytesPerFrame_ * (frameIndex % frameCount_);
+  head_ = frameBegin_;
+}
+
+ODFrameAllocator::Allocation ODFrameAllocator::allocate(VkDeviceSize size) {
+  VkDeviceSize offset = (head_ + alignment_ - 1) / alignment_ * alignment_;
+  if (offset + size > frameBegin_ + bytesPerFrame_) {
+    throw std::runtime_error("frame allocator is out of memory for this frame!");
+  }
+  head_ = offset + size;
+
+  Allocation allocation{};
+  allocation.data = mapped_ + offset;
+  allocation.offset = static_cast<uint32_t>(offset);
+  allocation.size = size;
+  return allocation;
+}
+
+VkDescriptorBufferInfo ODFrameAllocator::descriptorInfo(VkDeviceSize range) const {
+  return VkDescriptorBufferInfo{buffer_->getBuffer(), 0, range};
+}
+
+}  // namespace ODEngine
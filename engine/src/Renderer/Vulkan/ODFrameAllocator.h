@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ODBuffer.h"
+#include "ODDevice.h"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+
+namespace ODEngine {
+
+/*
+ * Per-frame bump allocator for uniform data.
+ *
+ * One persistently mapped, host coherent buffer is split into a region per
+ * frame in flight. Allocations are aligned on minUniformBufferOffsetAlignment
+ * and are meant to be bound through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+ * descriptors that point at the start of the buffer: the returned offset is the
+ * dynamic offset. A region is reset by beginFrame(), which ODRenderer calls once
+ * the frame's in-flight fence has signaled.
+ */
+class ODFrameAllocator {
+ public:
+  static constexpr VkDeviceSize DEFAULT_BYTES_PER_FRAME = 1024 * 1024;
+
+  struct Allocation {
+    void *data = nullptr;
+    uint32_t offset = 0; // dynamic offset from the start of the buffer
+    VkDeviceSize size = 0;
+  };
+
+  ODFrameAllocator(
+      ODDevice &device, uint32_t frameCount, VkDeviceSize bytesPerFrame = DEFAULT_BYTES_PER_FRAME);
+
+  ODFrameAllocator(const ODFrameAllocator &) = delete;
+  ODFrameAllocator &operator=(const ODFrameAllocator &) = delete;
+
+  void beginFrame(uint32_t frameIndex);
+
+  Allocation allocate(VkDeviceSize size);
+
+  // Copies value into the current frame region and returns its dynamic offset
+  template <typename T>
+  uint32_t push(const T &value) {
+    Allocation allocation = allocate(sizeof(T));
+    *static_cast<T *>(allocation.data) = value;
+    return allocation.offset;
+  }
+
+  // Descriptor for a dynamic uniform binding reading `range` bytes at each offset
+  VkDescriptorBufferInfo descriptorInfo(VkDeviceSize range) const;
+
+  VkBuffer getBuffer() const { return buffer_->getBuffer(); }
+  VkDeviceSize getUsedBytes() const { return head_ - frameBegin_; }
+
+ private:
+  ODDevice &device_;
+  std::unique_ptr<ODBuffer> buffer_;
+  uint8_t *mapped_ = nullptr;
+
+  uint32_t frameCount_;
+  VkDeviceSize bytesPerFrame_;
+  VkDeviceSize alignment_;
+  VkDeviceSize frameBegin_ = 0;
+  VkDeviceSize head_ = 0;
+};
+
+}  // namespace ODEngine
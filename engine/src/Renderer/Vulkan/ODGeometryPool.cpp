@@ -0,0 +1,270 @@
+#include "ODGeometryPool.h"
+
+#include "ODBuffer.h"
+#include "ODDevice.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace ODEngine {
+
+ODGeometryPool::RangeAllocator::RangeAllocator(uint32_t capacity) : capacity_{capacity} {
+  if (capacity_ > 0) {
+    freeRanges_[0] = capacity_;
+  }
+}
+
+bool ODGeometryPool::RangeAllocator::allocate(uint32_t count, uint32_t &offset) {
+  if (count == 0) {
+    offset = 0;
+    return true;
+  }
+  for (auto it = freeRanges_.begin(); it != freeRanges_.end(); ++it) {
+    if (it->second < count) {
+      continue;
+    }
+    offset = it->first;
+    uint32_t remaining = it->second - count;
+    freeRanges_.erase(it);
+    if (remaining > 0) {
+      freeRanges_[offset + count] = remaining;
+    }
+    return true;
+  }
+  return false;
+}
+
+void ODGeometryPool::RangeAllocator::free(uint32_t offset, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto next = freeRanges_.lower_bound(offset);
+  if (next != freeRanges_.begin()) {
+    auto prev = std::prev(next);
+    assert(prev->first + prev->second <= offset && "geometry range freed twice");
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      count += prev->second;
+      freeRanges_.erase(prev);
+    }
+  }
+  if (next != freeRanges_.end() && offset + count == next->first) {
+    count += next->second;
+    freeRanges_.erase(next);
+  }
+  freeRanges_[offset] = count;
+}
+
+ODGeometryPool::ODGeometryPool(ODDevice &device) : device_{device} {}
+
+ODGeometryPool::~ODGeometryPool() {}
+
+ODGeometryPool::Arena &ODGeometryPool::createArena(
+    uint32_t positionStride,
+    uint32_t vertexStride,
+    VkIndexType indexType,
+    uint32_t vertexCapacity,
+    uint32_t indexCapacity) {
+  auto arena = std::unique_ptr<Arena>(new Arena{
+      positionStride,
+      vertexStride,
+      indexType,
+      nullptr,
+      nullptr,
+      nullptr,
+      RangeAllocator{vertexCapacity},
+      RangeAllocator{indexCapacity}});
+
+  VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if (positionStride > 0) {
+    arena->positionBuffer = std::make_unique<ODBuffer>(
+        device_,
+        positionStride,
+        vertexCapacity,
+        vertexUsage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+  arena->vertexBuffer = std::make_unique<ODBuffer>(
+      device_,
+      vertexStride,
+      vertexCapacity,
+      vertexUsage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (indexCapacity > 0) {
+    arena->indexBuffer = std::make_unique<ODBuffer>(
+        device_,
+        indexSize(indexType),
+        indexCapacity,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  arenas_.push_back(std::move(arena));
+  return *arenas_.back();
+}
+
+ODGeometryRange ODGeometryPool::allocate(
+    uint32_t vertexStride,
+    uint32_t vertexCount,
+    const void *vertices,
+    uint32_t indexCount,
+    const uint32_t *indices) {
+  return allocateRange(
+      {0, nullptr, vertexStride, vertices}, vertexCount, indexCount, indices, VK_INDEX_TYPE_UINT32);
+}
+
+ODGeometryRange ODGeometryPool::allocate(
+    uint32_t vertexStride,
+    uint32_t vertexCount,
+    const void *vertices,
+    uint32_t indexCount,
+    const uint16_t *indices) {
+  assert(vertexCount <= 65536 && "uint16 indices address at most 65536 vertices");
+  return allocateRange(
+      {0, nullptr, vertexStride, vertices}, vertexCount, indexCount, indices, VK_INDEX_TYPE_UINT16);
+}
+
+ODGeometryRange ODGeometryPool::allocate(
+    const ODVertexStreams &streams,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    const uint32_t *indices) {
+  return allocateRange(streams, vertexCount, indexCount, indices, VK_INDEX_TYPE_UINT32);
+}
+
+ODGeometryRange ODGeometryPool::allocate(
+    const ODVertexStreams &streams,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    const uint16_t *indices) {
+  assert(vertexCount <= 65536 && "uint16 indices address at most 65536 vertices");
+  return allocateRange(streams, vertexCount, indexCount, indices, VK_INDEX_TYPE_UINT16);
+}
+
+ODGeometryRange ODGeometryPool::allocateRange(
+    const ODVertexStreams &streams,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    const void *indices,
+    VkIndexType indexType) {
+  ODGeometryRange range{};
+  range.vertexCount = vertexCount;
+  range.indexCount = indexCount;
+  range.indexType = indexType;
+
+  for (uint32_t i = 0; i < arenas_.size() && !range.isValid(); i++) {
+    Arena &arena = *arenas_[i];
+    if (arena.positionStride != streams.positionStride ||
+        arena.vertexStride != streams.attributeStride || arena.indexType != indexType) {
+      continue;
+    }
+    if (!arena.vertices.allocate(vertexCount, range.firstVertex)) {
+      continue;
+    }
+    if (!arena.indices.allocate(indexCount, range.firstIndex)) {
+      arena.vertices.free(range.firstVertex, vertexCount);
+      continue;
+    }
+    range.arena = i;
+  }
+
+  if (!range.isValid()) {
+    // meshes bigger than the default arena get an arena of their own size
+    uint32_t vertexCapacity = std::max(
+        vertexCount,
+        static_cast<uint32_t>(
+            VERTEX_ARENA_SIZE / (streams.positionStride + streams.attributeStride)));
+    // index-less data (e.g. meshlet records) gets an arena without index buffer
+    uint32_t indexCapacity = indexCount == 0 ? 0 : std::max(
+        indexCount, static_cast<uint32_t>(INDEX_ARENA_SIZE / indexSize(indexType)));
+    Arena &arena = createArena(
+        streams.positionStride, streams.attributeStride, indexType, vertexCapacity, indexCapacity);
+    arena.vertices.allocate(vertexCount, range.firstVertex);
+    arena.indices.allocate(indexCount, range.firstIndex);
+    range.arena = static_cast<uint32_t>(arenas_.size() - 1);
+  }
+
+  Arena &arena = *arenas_[range.arena];
+  ODUploadQueue &uploadQueue = device_.uploadQueue();
+  if (arena.positionStride > 0) {
+    uploadQueue.uploadBuffer(
+        arena.positionBuffer->getBuffer(),
+        streams.positions,
+        static_cast<VkDeviceSize>(arena.positionStride) * vertexCount,
+        static_cast<VkDeviceSize>(arena.positionStride) * range.firstVertex);
+  }
+  uploadQueue.uploadBuffer(
+      arena.vertexBuffer->getBuffer(),
+      streams.attributes,
+      static_cast<VkDeviceSize>(arena.vertexStride) * vertexCount,
+      static_cast<VkDeviceSize>(arena.vertexStride) * range.firstVertex);
+  if (indexCount > 0) {
+    uploadQueue.uploadBuffer(
+        arena.indexBuffer->getBuffer(),
+        indices,
+        indexSize(indexType) * static_cast<VkDeviceSize>(indexCount),
+        indexSize(indexType) * static_cast<VkDeviceSize>(range.firstIndex));
+  }
+  return range;
+}
+
+void ODGeometryPool::free(ODGeometryRange &range) {
+  if (!range.isValid()) {
+    return;
+  }
+  Arena &arena = *arenas_[range.arena];
+  arena.vertices.free(range.firstVertex, range.vertexCount);
+  arena.indices.free(range.firstIndex, range.indexCount);
+  range = ODGeometryRange{};
+}
+
+void ODGeometryPool::bind(VkCommandBuffer commandBuffer, uint32_t arena) const {
+  const Arena &bound = *arenas_[arena];
+  VkDeviceSize offsets[] = {0, 0};
+  if (bound.positionBuffer) {
+    VkBuffer buffers[] = {bound.positionBuffer->getBuffer(), bound.vertexBuffer->getBuffer()};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+  } else {
+    VkBuffer buffers[] = {bound.vertexBuffer->getBuffer()};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+  }
+  if (bound.indexBuffer) {
+    vkCmdBindIndexBuffer(commandBuffer, bound.indexBuffer->getBuffer(), 0, bound.indexType);
+  }
+}
+
+void ODGeometryPool::bindPositions(VkCommandBuffer commandBuffer, uint32_t arena) const {
+  const Arena &bound = *arenas_[arena];
+  assert(bound.positionBuffer && "arena has no separate position stream");
+  VkBuffer buffers[] = {bound.positionBuffer->getBuffer()};
+  VkDeviceSize offsets[] = {0};
+  vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+  if (bound.indexBuffer) {
+    vkCmdBindIndexBuffer(commandBuffer, bound.indexBuffer->getBuffer(), 0, bound.indexType);
+  }
+}
+
+VkBuffer ODGeometryPool::getVertexBuffer(uint32_t arena) const {
+  return arenas_[arena]->vertexBuffer->getBuffer();
+}
+
+VkBuffer ODGeometryPool::getPositionBuffer(uint32_t arena) const {
+  const auto &positionBuffer = arenas_[arena]->positionBuffer;
+  return positionBuffer ? positionBuffer->getBuffer() : VK_NULL_HANDLE;
+}
+
+VkIndexType ODGeometryPool::getIndexType(uint32_t arena) const {
+  return arenas_[arena]->indexType;
+}
+
+VkBuffer ODGeometryPool::getIndexBuffer(uint32_t arena) const {
+  const auto &indexBuffer = arenas_[arena]->indexBuffer;
+  return indexBuffer ? indexBuffer->getBuffer() : VK_NULL_HANDLE;
+}
+
+}  // namespace ODEngine
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ODEngine {
+
+class ODDevice;
+class ODBuffer;
+
+// Vertex and index ranges of one mesh inside an ODGeometryPool arena.
+// firstVertex is the vertexOffset and firstIndex the firstIndex of vkCmdDrawIndexed,
+// counted in indices of indexType (the arena's index type).
+struct ODGeometryRange {
+  uint32_t arena = UINT32_MAX;
+  uint32_t firstVertex = 0;
+  uint32_t vertexCount = 0;
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+  bool isValid() const { return arena != UINT32_MAX; }
+};
+
+// Vertex data of one mesh: a single interleaved stream when positionStride is 0,
+// otherwise positions and the remaining attributes as two streams of the same
+// vertex count
+struct ODVertexStreams {
+  uint32_t positionStride = 0;
+  const void *positions = nullptr;
+  uint32_t attributeStride = 0;
+  const void *attributes = nullptr;
+};
+
+/*
+ * Shared vertex/index storage for static meshes.
+ *
+ * Meshes are sub-allocated in arenas, each arena being one device local vertex
+ * buffer and one index buffer. All meshes of an arena share the vertex stride
+ * and the index type (uint16 or uint32), so a pass binds an arena once and
+ * draws every mesh in it back to back with (firstIndex, vertexOffset) from its
+ * ODGeometryRange. Data is uploaded through the device's ODUploadQueue.
+ *
+ * An arena can also hold a split vertex layout: positions in a tightly packed
+ * stream of their own next to the other attributes, both sharing the vertex
+ * range. Depth-only passes bind the position stream alone (bindPositions).
+ *
+ * Vertex buffers are also storage buffers, so other static per-element records
+ * (ODModel::Meshlet) are allocated here with indexCount 0, in arenas of their
+ * own stride that have no index buffer.
+ */
+class ODGeometryPool {
+ public:
+  static constexpr VkDeviceSize VERTEX_ARENA_SIZE = 64ull * 1024 * 1024;
+  static constexpr VkDeviceSize INDEX_ARENA_SIZE = 32ull * 1024 * 1024;
+
+  ODGeometryPool(ODDevice &device);
+  ~ODGeometryPool();
+
+  ODGeometryPool(const ODGeometryPool &) = delete;
+  ODGeometryPool &operator=(const ODGeometryPool &) = delete;
+
+  ODGeometryRange allocate(
+      uint32_t vertexStride,
+      uint32_t vertexCount,
+      const void *vertices,
+      uint32_t indexCount,
+      const uint32_t *indices);
+  // goes to a VK_INDEX_TYPE_UINT16 arena, vertexCount must be at most 65536
+  ODGeometryRange allocate(
+      uint32_t vertexStride,
+      uint32_t vertexCount,
+      const void *vertices,
+      uint32_t indexCount,
+      const uint16_t *indices);
+  // split layouts: positions at binding 0, attributes at binding 1
+  ODGeometryRange allocate(
+      const ODVertexStreams &streams,
+      uint32_t vertexCount,
+      uint32_t indexCount,
+      const uint32_t *indices);
+  ODGeometryRange allocate(
+      const ODVertexStreams &streams,
+      uint32_t vertexCount,
+      uint32_t indexCount,
+      const uint16_t *indices);
+  void free(ODGeometryRange &range);
+
+  // Binds the vertex streams from binding 0 and the index buffer of the arena
+  void bind(VkCommandBuffer commandBuffer, uint32_t arena) const;
+  // Binds the position stream alone at binding 0 and the index buffer, for
+  // depth-only pipelines (split arenas only)
+  void bindPositions(VkCommandBuffer commandBuffer, uint32_t arena) const;
+
+  static uint32_t indexSize(VkIndexType indexType) {
+    return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+  }
+
+  // the interleaved stream, or the attribute stream of a split arena
+  VkBuffer getVertexBuffer(uint32_t arena) const;
+  // VK_NULL_HANDLE for single stream arenas
+  VkBuffer getPositionBuffer(uint32_t arena) const;
+  bool isSplit(uint32_t arena) const { return arenas_[arena]->positionStride > 0; }
+  // VK_NULL_HANDLE for arenas holding index-less data
+  VkBuffer getIndexBuffer(uint32_t arena) const;
+  VkIndexType getIndexType(uint32_t arena) const;
+  uint32_t getArenaCount() const { return static_cast<uint32_t>(arenas_.size()); }
+
+ private:
+  // first fit free list over [0, capacity) elements, coalesced on free
+  class RangeAllocator {
+   public:
+    explicit RangeAllocator(uint32_t capacity);
+    bool allocate(uint32_t count, uint32_t &offset);
+    void free(uint32_t offset, uint32_t count);
+
+   private:
+    uint32_t capacity_;
+    std::map<uint32_t, uint32_t> freeRanges_; // offset -> count
+  };
+
+  struct Arena {
+    uint32_t positionStride; // 0: single stream
+    uint32_t vertexStride;
+    VkIndexType indexType;
+    std::unique_ptr<ODBuffer> positionBuffer;
+    std::unique_ptr<ODBuffer> vertexBuffer;
+    std::unique_ptr<ODBuffer> indexBuffer;
+    RangeAllocator vertices;
+    RangeAllocator indices;
+  };
+
+  Arena &createArena(
+      uint32_t positionStride,
+      uint32_t vertexStride,
+      VkIndexType indexType,
+      uint32_t vertexCapacity,
+      uint32_t indexCapacity);
+  ODGeometryRange allocateRange(
+      const ODVertexStreams &streams,
+      uint32_t vertexCount,
+      uint32_t indexCount,
+      const void *indices,
+      VkIndexType indexType);
+
+  ODDevice &device_;
+  std::vector<std::unique_ptr<Arena>> arenas_;
+};
+
+}  // namespace ODEngine
@@ -0,0 +1,352 @@
+#include "ODMemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace ODEngine {
+
+namespace {
+VkDeviceSize nextPowerOfTwo(VkDeviceSize value) {
+  VkDeviceSize result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+uint32_t log2Floor(VkDeviceSize value) {
+  uint32_t result = 0;
+  while (value > 1) {
+    value >>= 1;
+    result++;
+  }
+  return result;
+}
+
+float toMiB(VkDeviceSize bytes) {
+  return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+}
+} // namespace
+
+ODMemoryAllocator::ODMemoryAllocator(VkDevice device,
+                                     VkPhysicalDevice physicalDevice)
+    : device_{device} {
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties_);
+
+  // host visible blocks are flushed per node, so a node must never be
+  // smaller than the non coherent atom
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  minNodeSize_ = nextPowerOfTwo(
+      std::max(MIN_NODE_SIZE, properties.limits.nonCoherentAtomSize));
+}
+
+ODMemoryAllocator::~ODMemoryAllocator() {
+  for (auto &pool : pools_) {
+    for (auto &block : pool.blocks) {
+      if (block->allocationCount > 0) {
+        std::cerr << "ODMemoryAllocator: " << block->allocationCount
+                  << " allocation(s) still alive in memory type "
+                  << pool.memoryTypeIndex << std::endl;
+      }
+      destroyBlock(*block);
+    }
+  }
+  if (dedicatedCount_ > 0) {
+    std::cerr << "ODMemoryAllocator: " << dedicatedCount_
+              << " dedicated allocation(s) leaked" << std::endl;
+  }
+}
+
+ODAllocation ODMemoryAllocator::allocate(const VkMemoryRequirements &requirements,
+                                         uint32_t memoryTypeIndex,
+                                         bool linearResource) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint32_t poolIndex = getPoolIndex(memoryTypeIndex, linearResource);
+  Pool &pool = pools_[poolIndex];
+
+  ODAllocation allocation{};
+  allocation.size = requirements.size;
+  allocation.poolIndex = poolIndex;
+
+  VkDeviceSize nodeSize = nextPowerOfTwo(
+      std::max({requirements.size, requirements.alignment, minNodeSize_}));
+
+  // big resources (render targets, large textures) would waste most of a
+  // buddy node, give them their own VkDeviceMemory instead
+  if (nodeSize > pool.blockSize / 2) {
+    allocation.memory = allocateDeviceMemory(requirements.size, memoryTypeIndex,
+                                             &allocation.mapped);
+    allocation.offset = 0;
+    allocation.dedicated = true;
+    dedicatedCount_++;
+    dedicatedBytes_ += requirements.size;
+    dedicatedUsedBytes_ += requirements.size;
+    return allocation;
+  }
+
+  uint32_t level = log2Floor(pool.blockSize / nodeSize);
+
+  Block *target = nullptr;
+  VkDeviceSize offset = 0;
+  for (auto &block : pool.blocks) {
+    if (allocateFromBlock(*block, level, offset)) {
+      target = block.get();
+      break;
+    }
+  }
+  if (target == nullptr) {
+    target = createBlock(pool);
+    if (!allocateFromBlock(*target, level, offset)) {
+      throw std::runtime_error("failed to sub-allocate from a fresh memory block!");
+    }
+  }
+
+  target->usedBytes += requirements.size;
+  target->allocatedBytes += nodeSize;
+  target->allocationCount++;
+
+  allocation.memory = target->memory;
+  allocation.offset = offset;
+  allocation.level = level;
+  allocation.block = target;
+  if (target->mapped != nullptr) {
+    allocation.mapped = static_cast<char *>(target->mapped) + offset;
+  }
+  return allocation;
+}
+
+void ODMemoryAllocator::free(ODAllocation &allocation) {
+  if (!allocation.isValid()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (allocation.dedicated) {
+    if (allocation.mapped != nullptr) {
+      vkUnmapMemory(device_, allocation.memory);
+    }
+    vkFreeMemory(device_, allocation.memory, nullptr);
+    dedicatedCount_--;
+    dedicatedBytes_ -= allocation.size;
+    dedicatedUsedBytes_ -= allocation.size;
+    allocation = ODAllocation{};
+    return;
+  }
+
+  assert(allocation.poolIndex < pools_.size() && "Allocation from unknown pool");
+  Pool &pool = pools_[allocation.poolIndex];
+  Block *block = static_cast<Block *>(allocation.block);
+
+  freeInBlock(*block, allocation.offset, allocation.level);
+  block->usedBytes -= allocation.size;
+  block->allocatedBytes -= block->size >> allocation.level;
+  block->allocationCount--;
+
+  // keep one empty block per pool around so that load/unload cycles do not
+  // hammer vkAllocateMemory, release the others
+  if (block->allocationCount == 0 && pool.blocks.size() > 1) {
+    auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                           [block](const std::unique_ptr<Block> &b) {
+                             return b.get() == block;
+                           });
+    destroyBlock(*block);
+    pool.blocks.erase(it);
+  }
+
+  allocation = ODAllocation{};
+}
+
+ODMemoryAllocator::Stats ODMemoryAllocator::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Stats stats{};
+  VkDeviceSize summedLargestFree = 0;
+  for (const auto &pool : pools_) {
+    for (const auto &block : pool.blocks) {
+      stats.blockCount++;
+      stats.allocationCount += block->allocationCount;
+      stats.reservedBytes += block->size;
+      stats.usedBytes += block->usedBytes;
+      stats.wastedBytes += block->allocatedBytes - block->usedBytes;
+      stats.freeBytes += block->size - block->allocatedBytes;
+
+      for (uint32_t level = 0; level < block->freeNodes.size(); level++) {
+        if (!block->freeNodes[level].empty()) {
+          VkDeviceSize largest = block->size >> level;
+          summedLargestFree += largest;
+          stats.largestFreeRange = std::max(stats.largestFreeRange, largest);
+          break;
+        }
+      }
+    }
+  }
+
+  stats.dedicatedAllocationCount = dedicatedCount_;
+  stats.allocationCount += dedicatedCount_;
+  stats.reservedBytes += dedicatedBytes_;
+  stats.usedBytes += dedicatedUsedBytes_;
+
+  if (stats.freeBytes > 0) {
+    stats.fragmentation =
+        1.0f - static_cast<float>(summedLargestFree) /
+                   static_cast<float>(stats.freeBytes);
+  }
+  return stats;
+}
+
+void ODMemoryAllocator::printStats() const {
+  Stats stats = getStats();
+  std::cout << "GPU memory: " << stats.blockCount << " block(s), "
+            << stats.dedicatedAllocationCount << " dedicated, "
+            << stats.allocationCount << " live allocation(s)" << std::endl;
+  std::cout << "\treserved: " << toMiB(stats.reservedBytes) << " MiB"
+            << ", used: " << toMiB(stats.usedBytes) << " MiB"
+            << ", wasted: " << toMiB(stats.wastedBytes) << " MiB"
+            << ", free: " << toMiB(stats.freeBytes) << " MiB" << std::endl;
+  std::cout << "\tlargest free range: " << toMiB(stats.largestFreeRange)
+            << " MiB, fragmentation: " << stats.fragmentation * 100.0f << "%"
+            << std::endl;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &pool : pools_) {
+    if (pool.blocks.empty()) {
+      continue;
+    }
+    VkDeviceSize used = 0;
+    for (const auto &block : pool.blocks) {
+      used += block->usedBytes;
+    }
+    std::cout << "\ttype " << pool.memoryTypeIndex
+              << (pool.linear ? " (linear): " : " (optimal): ")
+              << pool.blocks.size() << " x " << toMiB(pool.blockSize)
+              << " MiB, " << toMiB(used) << " MiB used" << std::endl;
+  }
+}
+
+uint32_t ODMemoryAllocator::getPoolIndex(uint32_t memoryTypeIndex, bool linear) {
+  for (uint32_t i = 0; i < pools_.size(); i++) {
+    if (pools_[i].memoryTypeIndex == memoryTypeIndex && pools_[i].linear == linear) {
+      return i;
+    }
+  }
+  pools_.push_back(Pool{memoryTypeIndex, linear, chooseBlockSize(memoryTypeIndex), {}});
+  return static_cast<uint32_t>(pools_.size() - 1);
+}
+
+VkDeviceSize ODMemoryAllocator::chooseBlockSize(uint32_t memoryTypeIndex) const {
+  VkDeviceSize blockSize = isHostVisible(memoryTypeIndex) ? HOST_VISIBLE_BLOCK_SIZE
+                                                          : DEFAULT_BLOCK_SIZE;
+
+  // small heaps (e.g. the 256 MiB BAR window) should not be eaten by a
+  // couple of blocks
+  uint32_t heapIndex = memoryProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+  VkDeviceSize heapSize = memoryProperties_.memoryHeaps[heapIndex].size;
+  while (blockSize > heapSize / 8 && blockSize > minNodeSize_ * 2) {
+    blockSize >>= 1;
+  }
+  return blockSize;
+}
+
+ODMemoryAllocator::Block *ODMemoryAllocator::createBlock(Pool &pool) {
+  auto block = std::make_unique<Block>();
+  block->size = pool.blockSize;
+  block->memory = allocateDeviceMemory(pool.blockSize, pool.memoryTypeIndex,
+                                       &block->mapped);
+  block->freeNodes.resize(levelCount(*block));
+  block->freeNodes[0].insert(0);
+
+  pool.blocks.push_back(std::move(block));
+  return pool.blocks.back().get();
+}
+
+void ODMemoryAllocator::destroyBlock(Block &block) {
+  if (block.mapped != nullptr) {
+    vkUnmapMemory(device_, block.memory);
+    block.mapped = nullptr;
+  }
+  vkFreeMemory(device_, block.memory, nullptr);
+  block.memory = VK_NULL_HANDLE;
+}
+
+bool ODMemoryAllocator::allocateFromBlock(Block &block, uint32_t level,
+                                          VkDeviceSize &offset) {
+  // find the smallest free node that can hold the request
+  int32_t found = -1;
+  for (int32_t l = static_cast<int32_t>(level); l >= 0; l--) {
+    if (!block.freeNodes[l].empty()) {
+      found = l;
+      break;
+    }
+  }
+  if (found < 0) {
+    return false;
+  }
+
+  auto first = block.freeNodes[found].begin();
+  offset = *first;
+  block.freeNodes[found].erase(first);
+
+  // split it down, keeping the lower half and freeing the upper buddy
+  for (uint32_t l = static_cast<uint32_t>(found) + 1; l <= level; l++) {
+    block.freeNodes[l].insert(offset + (block.size >> l));
+  }
+  return true;
+}
+
+void ODMemoryAllocator::freeInBlock(Block &block, VkDeviceSize offset,
+                                    uint32_t level) {
+  // merge with the buddy as long as it is free too
+  while (level > 0) {
+    VkDeviceSize buddy = offset ^ (block.size >> level);
+    auto it = block.freeNodes[level].find(buddy);
+    if (it == block.freeNodes[level].end()) {
+      break;
+    }
+    block.freeNodes[level].erase(it);
+    offset = std::min(offset, buddy);
+    level--;
+  }
+  block.freeNodes[level].insert(offset);
+}
+
+uint32_t ODMemoryAllocator::levelCount(const Block &block) const {
+  return log2Floor(block.size / minNodeSize_) + 1;
+}
+
+VkDeviceMemory ODMemoryAllocator::allocateDeviceMemory(VkDeviceSize size,
+                                                       uint32_t memoryTypeIndex,
+                                                       void **mapped) {
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+  VkDeviceMemory memory;
+  if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate device memory block!");
+  }
+
+  *mapped = nullptr;
+  if (isHostVisible(memoryTypeIndex)) {
+    // a VkDeviceMemory can only be mapped once, so host visible blocks stay
+    // mapped for their whole lifetime and allocations get a sub-pointer
+    if (vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+      vkFreeMemory(device_, memory, nullptr);
+      throw std::runtime_error("failed to map device memory block!");
+    }
+  }
+  return memory;
+}
+
+bool ODMemoryAllocator::isHostVisible(uint32_t memoryTypeIndex) const {
+  return (memoryProperties_.memoryTypes[memoryTypeIndex].propertyFlags &
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+} // namespace ODEngine
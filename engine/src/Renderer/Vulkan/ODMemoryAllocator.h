@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace ODEngine {
+
+// A sub-range of a VkDeviceMemory block handed out by ODMemoryAllocator.
+// Buffers and images bind to (memory, offset) instead of owning their memory.
+struct ODAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0; // size requested by the resource
+  void *mapped = nullptr; // persistent mapping (host visible memory only)
+
+  // bookkeeping for ODMemoryAllocator::free
+  uint32_t poolIndex = UINT32_MAX;
+  uint32_t level = 0;
+  bool dedicated = false;
+  void *block = nullptr;
+
+  bool isValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+/*
+ * Block based device memory allocator.
+ *
+ * Memory is reserved in large VkDeviceMemory blocks, one pool of blocks per
+ * (memory type, linear/optimal resource) pair so that buffers and optimal
+ * images never share a block (bufferImageGranularity). Each block is split
+ * with a buddy allocator: nodes are power of two sized and aligned on their
+ * size, which covers every alignment a resource can ask for up to the node
+ * size. Requests larger than half a block get a dedicated allocation.
+ */
+class ODMemoryAllocator {
+ public:
+  struct Stats {
+    uint32_t blockCount = 0;
+    uint32_t dedicatedAllocationCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize reservedBytes = 0; // sum of all VkDeviceMemory sizes
+    VkDeviceSize usedBytes = 0;     // bytes requested by live resources
+    VkDeviceSize wastedBytes = 0;   // buddy rounding + alignment padding
+    VkDeviceSize freeBytes = 0;
+    VkDeviceSize largestFreeRange = 0;
+    // 0 = all free space is contiguous, 1 = free space is fully scattered
+    float fragmentation = 0.0f;
+  };
+
+  static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+  static constexpr VkDeviceSize HOST_VISIBLE_BLOCK_SIZE = 16ull * 1024 * 1024;
+  static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+  ODMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+  ~ODMemoryAllocator();
+
+  ODMemoryAllocator(const ODMemoryAllocator &) = delete;
+  ODMemoryAllocator &operator=(const ODMemoryAllocator &) = delete;
+
+  ODAllocation allocate(const VkMemoryRequirements &requirements,
+                        uint32_t memoryTypeIndex, bool linearResource);
+  void free(ODAllocation &allocation);
+
+  Stats getStats() const;
+  void printStats() const;
+
+ private:
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void *mapped = nullptr;
+    VkDeviceSize size = 0;
+    VkDeviceSize usedBytes = 0;
+    VkDeviceSize allocatedBytes = 0; // sum of node sizes handed out
+    uint32_t allocationCount = 0;
+    // freeNodes[level] holds the offsets of free nodes of size (size >> level)
+    std::vector<std::set<VkDeviceSize>> freeNodes;
+  };
+
+  struct Pool {
+    uint32_t memoryTypeIndex;
+    bool linear;
+    VkDeviceSize blockSize;
+    std::vector<std::unique_ptr<Block>> blocks;
+  };
+
+  uint32_t getPoolIndex(uint32_t memoryTypeIndex, bool linear);
+  VkDeviceSize chooseBlockSize(uint32_t memoryTypeIndex) const;
+  Block *createBlock(Pool &pool);
+  void destroyBlock(Block &block);
+  bool allocateFromBlock(Block &block, uint32_t level, VkDeviceSize &offset);
+  void freeInBlock(Block &block, VkDeviceSize offset, uint32_t level);
+  uint32_t levelCount(const Block &block) const;
+  VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex,
+                                      void **mapped);
+  bool isHostVisible(uint32_t memoryTypeIndex) const;
+
+  VkDevice device_;
+  VkPhysicalDeviceMemoryProperties memoryProperties_;
+  VkDeviceSize minNodeSize_ = MIN_NODE_SIZE;
+
+  std::vector<Pool> pools_;
+  uint32_t dedicatedCount_ = 0;
+  VkDeviceSize dedicatedBytes_ = 0;
+  VkDeviceSize dedicatedUsedBytes_ = 0;
+
+  mutable std::mutex mutex_;
+};
+
+} // namespace ODEngine
@@ -0,0 +1,266 @@
+#include "ODMipGenerator.h"
+
+#include "ODDescriptors.h"
+#include "ODDevice.h"
+#include "ODPipeline.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace ODEngine {
+
+// same layout as in mip_downsample.comp
+struct MipDownsamplePushConstantData {
+  int32_t srcWidth;
+  int32_t srcHeight;
+  uint32_t levelCount;
+  uint32_t srgb;
+};
+
+// workgroup side in texels of the first level a pass writes
+static constexpr uint32_t TILE_SIZE = 16;
+static constexpr uint32_t SETS_PER_POOL = 64;
+
+ODMipGenerator::ODMipGenerator(ODDevice &device) : device_{device} {
+  setLayout_ = ODDescriptorSetLayout::Builder(device_)
+                   .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+                   .addBinding(
+                       1,
+                       VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                       VK_SHADER_STAGE_COMPUTE_BIT,
+                       LEVELS_PER_PASS)
+                   .build();
+  createPipeline();
+  currentPool_ = createDescriptorPool();
+}
+
+ODMipGenerator::~ODMipGenerator() {
+  for (auto &recording : recordings_) {
+    for (VkImageView view : recording.views) {
+      vkDestroyImageView(device_.device(), view, nullptr);
+    }
+  }
+  pipeline_.reset();
+  vkDestroyPipelineLayout(device_.device(), pipelineLayout_, nullptr);
+}
+
+bool ODMipGenerator::isFormatSupported(VkFormat format) {
+  return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+void ODMipGenerator::createPipeline() {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(MipDownsamplePushConstantData);
+
+  VkDescriptorSetLayout setLayout = setLayout_->getDescriptorSetLayout();
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &setLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  if (vkCreatePipelineLayout(device_.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout_) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("failed to create mip generation pipeline layout!");
+  }
+
+  ODComputePipelineConfigInfo pipelineConfig{};
+  pipelineConfig.pipelineLayout = pipelineLayout_;
+  pipeline_ = std::make_unique<ODComputePipeline>(
+      device_, ENGINE_PATH "/shaders/compiled/mip_downsample.spv", pipelineConfig);
+}
+
+ODMipGenerator::DescriptorPool ODMipGenerator::createDescriptorPool() {
+  if (!freePools_.empty()) {
+    DescriptorPool pool = std::move(freePools_.back());
+    freePools_.pop_back();
+    return pool;
+  }
+  DescriptorPool pool;
+  pool.pool = ODDescriptorPool::Builder(device_)
+                  .setMaxSets(SETS_PER_POOL)
+                  .addPoolSize(
+                      VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, SETS_PER_POOL * (1 + LEVELS_PER_PASS))
+                  .build();
+  return pool;
+}
+
+VkDescriptorSet ODMipGenerator::allocateSet(uint64_t ticket) {
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  if (!currentPool_.pool->allocateDescriptorSet(setLayout_->getDescriptorSetLayout(), set)) {
+    // full: it is reset once its last recording completes
+    usedPools_.push_back(std::move(currentPool_));
+    currentPool_ = createDescriptorPool();
+    if (!currentPool_.pool->allocateDescriptorSet(setLayout_->getDescriptorSetLayout(), set)) {
+      throw std::runtime_error("failed to allocate mip generation descriptor set!");
+    }
+  }
+  currentPool_.lastTicket = ticket;
+  return set;
+}
+
+void ODMipGenerator::record(
+    VkCommandBuffer commandBuffer,
+    VkImage image,
+    VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    uint64_t ticket) {
+  if (!isFormatSupported(format)) {
+    throw std::runtime_error("mip generation does not support the image format!");
+  }
+
+  Recording recording{ticket, {}};
+  recording.views.resize(mipLevels);
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = level;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_.device(), &viewInfo, nullptr, &recording.views[level]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create mip level view!");
+    }
+  }
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mipLevels;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  pipeline_->bind(commandBuffer);
+
+  MipDownsamplePushConstantData push{};
+  push.srgb = format == VK_FORMAT_R8G8B8A8_SRGB ? 1 : 0;
+  uint32_t srcWidth = width;
+  uint32_t srcHeight = height;
+  for (uint32_t srcLevel = 0; srcLevel + 1 < mipLevels; srcLevel += LEVELS_PER_PASS) {
+    uint32_t levelCount = std::min(LEVELS_PER_PASS, mipLevels - 1 - srcLevel);
+
+    // unused destinations repeat the last level, the shader never writes them
+    VkDescriptorImageInfo srcInfo{VK_NULL_HANDLE, recording.views[srcLevel], VK_IMAGE_LAYOUT_GENERAL};
+    std::array<VkDescriptorImageInfo, LEVELS_PER_PASS> dstInfos{};
+    for (uint32_t i = 0; i < LEVELS_PER_PASS; i++) {
+      uint32_t level = srcLevel + 1 + std::min(i, levelCount - 1);
+      dstInfos[i] = {VK_NULL_HANDLE, recording.views[level], VK_IMAGE_LAYOUT_GENERAL};
+    }
+    VkDescriptorSet set = allocateSet(ticket);
+    ODDescriptorWriter writer(*setLayout_, *currentPool_.pool);
+    writer.writeImage(0, &srcInfo);
+    for (uint32_t i = 0; i < LEVELS_PER_PASS; i++) {
+      writer.writeImage(1, i, &dstInfos[i]);
+    }
+    writer.overwrite(set);
+
+    if (srcLevel > 0) {
+      // the previous pass wrote the source level
+      VkMemoryBarrier memoryBarrier{};
+      memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      vkCmdPipelineBarrier(
+          commandBuffer,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          0,
+          1,
+          &memoryBarrier,
+          0,
+          nullptr,
+          0,
+          nullptr);
+    }
+
+    push.srcWidth = static_cast<int32_t>(srcWidth);
+    push.srcHeight = static_cast<int32_t>(srcHeight);
+    push.levelCount = levelCount;
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(
+        commandBuffer,
+        pipelineLayout_,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(MipDownsamplePushConstantData),
+        &push);
+
+    uint32_t dstWidth = std::max(srcWidth >> 1, 1u);
+    uint32_t dstHeight = std::max(srcHeight >> 1, 1u);
+    vkCmdDispatch(
+        commandBuffer, (dstWidth + TILE_SIZE - 1) / TILE_SIZE, (dstHeight + TILE_SIZE - 1) / TILE_SIZE, 1);
+
+    srcWidth = std::max(srcWidth >> LEVELS_PER_PASS, 1u);
+    srcHeight = std::max(srcHeight >> LEVELS_PER_PASS, 1u);
+  }
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  recordings_.push_back(std::move(recording));
+}
+
+void ODMipGenerator::release(uint64_t completedTicket) {
+  while (!recordings_.empty() && recordings_.front().ticket <= completedTicket) {
+    for (VkImageView view : recordings_.front().views) {
+      vkDestroyImageView(device_.device(), view, nullptr);
+    }
+    recordings_.pop_front();
+  }
+
+  while (!usedPools_.empty() && usedPools_.front().lastTicket <= completedTicket) {
+    usedPools_.front().pool->resetPool();
+    freePools_.push_back(std::move(usedPools_.front()));
+    usedPools_.pop_front();
+  }
+  if (currentPool_.lastTicket != 0 && currentPool_.lastTicket <= completedTicket) {
+    currentPool_.pool->resetPool();
+    currentPool_.lastTicket = 0;
+  }
+}
+
+}  // namespace ODEngine
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace ODEngine {
+
+class ODDevice;
+class ODDescriptorSetLayout;
+class ODDescriptorPool;
+class ODComputePipeline;
+
+/*
+ * Mip chain generation with a compute shader (mip_downsample.comp).
+ *
+ * One dispatch writes up to LEVELS_PER_PASS levels: each workgroup box filters a tile of
+ * the source level and reduces it further in shared memory, so a 4096 texture takes 3
+ * dispatches and 3 barriers instead of a blit and two barriers per level. sRGB texels
+ * are averaged in linear space, blits filter the encoded values.
+ *
+ * The images are written as storage images through R8G8B8A8_UNORM views: they need
+ * IMAGE_USAGE, and IMAGE_FLAGS when their format is sRGB (their sampled view then has to
+ * leave out the storage usage, see ODSwapChain::createImageView).
+ *
+ * ODUploadQueue records it after the level 0 copy. The per level views and descriptor
+ * sets of a recording live until the ticket it was recorded for completes.
+ */
+class ODMipGenerator {
+ public:
+  static constexpr uint32_t LEVELS_PER_PASS = 5;
+  static constexpr VkImageUsageFlags IMAGE_USAGE = VK_IMAGE_USAGE_STORAGE_BIT;
+  static constexpr VkImageCreateFlags IMAGE_FLAGS =
+      VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+
+  explicit ODMipGenerator(ODDevice &device);
+  ~ODMipGenerator();
+
+  ODMipGenerator(const ODMipGenerator &) = delete;
+  ODMipGenerator &operator=(const ODMipGenerator &) = delete;
+
+  // RGBA8, sRGB or UNORM
+  static bool isFormatSupported(VkFormat format);
+
+  // Records the passes into a command buffer of a compute capable queue. Expects every
+  // mip level in TRANSFER_DST_OPTIMAL with level 0 written by a transfer, and leaves them
+  // in SHADER_READ_ONLY_OPTIMAL.
+  void record(
+      VkCommandBuffer commandBuffer,
+      VkImage image,
+      VkFormat format,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mipLevels,
+      uint64_t ticket);
+  // Destroys what the recordings up to completedTicket used
+  void release(uint64_t completedTicket);
+
+ private:
+  struct Recording {
+    uint64_t ticket;
+    std::vector<VkImageView> views;
+  };
+
+  struct DescriptorPool {
+    std::unique_ptr<ODDescriptorPool> pool;
+    uint64_t lastTicket = 0;
+  };
+
+  void createPipeline();
+  VkDescriptorSet allocateSet(uint64_t ticket);
+  DescriptorPool createDescriptorPool();
+
+  ODDevice &device_;
+  std::unique_ptr<ODDescriptorSetLayout> setLayout_;
+  VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+  std::unique_ptr<ODComputePipeline> pipeline_;
+
+  DescriptorPool currentPool_;
+  // full pools waiting for their last recording, oldest first
+  std::deque<DescriptorPool> usedPools_;
+  std::vector<DescriptorPool> freePools_;
+  std::deque<Recording> recordings_;
+};
+
+}  // namespace ODEngine
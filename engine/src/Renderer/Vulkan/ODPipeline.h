@@ -66,6 +66,8 @@ namespace ODEngine {
 
             static void defaultPipelineConfigInfo(ODDevice& device, ODGraphicsPipelineConfigInfo& configInfo);
             static void enableAlphaBlending(ODGraphicsPipelineConfigInfo& configInfo);
+            // position stream only and no color writes, for depth prepass and shadow pipelines
+            static void enableDepthOnly(ODGraphicsPipelineConfigInfo& configInfo);
 
         private:
             void createGraphicsPipeline(
@@ -0,0 +1,54 @@
+#include "ODSampler.h"
+
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace ODEngine {
+
+size_t ODSamplerSettingsHash::operator()(const ODSamplerSettings &settings) const {
+  uint32_t maxLodBits = 0;
+  std::memcpy(&maxLodBits, &settings.maxLod, sizeof(maxLodBits));
+  const uint32_t fields[] = {
+      static_cast<uint32_t>(settings.magFilter),
+      static_cast<uint32_t>(settings.minFilter),
+      static_cast<uint32_t>(settings.mipmapMode),
+      static_cast<uint32_t>(settings.addressMode),
+      settings.anisotropy ? 1u : 0u,
+      maxLodBits};
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint32_t field : fields) {
+    hash = (hash ^ field) * 0x100000001b3ull;
+  }
+  return static_cast<size_t>(hash);
+}
+
+ODSampler::ODSampler(ODDevice &device, const ODSamplerSettings &settings)
+    : device_{device}, settings_{settings} {
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = settings.magFilter;
+  samplerInfo.minFilter = settings.minFilter;
+  samplerInfo.addressModeU = settings.addressMode;
+  samplerInfo.addressModeV = settings.addressMode;
+  samplerInfo.addressModeW = settings.addressMode;
+  samplerInfo.anisotropyEnable = settings.anisotropy ? VK_TRUE : VK_FALSE;
+  samplerInfo.maxAnisotropy =
+      settings.anisotropy ? device.properties.limits.maxSamplerAnisotropy : 1.0f;
+  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+  samplerInfo.unnormalizedCoordinates = VK_FALSE;
+  samplerInfo.compareEnable = VK_FALSE;
+  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+  samplerInfo.mipmapMode = settings.mipmapMode;
+  samplerInfo.mipLodBias = 0.0f;
+  samplerInfo.minLod = 0.0f;
+  samplerInfo.maxLod = settings.maxLod;
+
+  if (vkCreateSampler(device_.device(), &samplerInfo, nullptr, &sampler_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create sampler!");
+  }
+}
+
+ODSampler::~ODSampler() { vkDestroySampler(device_.device(), sampler_, nullptr); }
+
+}  // namespace ODEngine
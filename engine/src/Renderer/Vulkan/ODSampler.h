@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ODDevice.h"
+
+// std lib headers
+#include <cstddef>
+
+namespace ODEngine {
+
+struct ODSamplerSettings {
+  VkFilter magFilter = VK_FILTER_LINEAR;
+  VkFilter minFilter = VK_FILTER_LINEAR;
+  VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  bool anisotropy = true; // at the device's maxSamplerAnisotropy
+  float maxLod = VK_LOD_CLAMP_NONE;
+
+  bool operator==(const ODSamplerSettings &other) const {
+    return magFilter == other.magFilter && minFilter == other.minFilter &&
+        mipmapMode == other.mipmapMode && addressMode == other.addressMode &&
+        anisotropy == other.anisotropy && maxLod == other.maxLod;
+  }
+};
+
+struct ODSamplerSettingsHash {
+  size_t operator()(const ODSamplerSettings &settings) const;
+};
+
+// Owns one VkSampler, shared through ODAssetRegistry::getSampler
+class ODSampler {
+ public:
+  ODSampler(ODDevice &device, const ODSamplerSettings &settings);
+  ~ODSampler();
+
+  ODSampler(const ODSampler &) = delete;
+  ODSampler &operator=(const ODSampler &) = delete;
+
+  VkSampler getSampler() const { return sampler_; }
+  const ODSamplerSettings &getSettings() const { return settings_; }
+
+ private:
+  ODDevice &device_;
+  ODSamplerSettings settings_;
+  VkSampler sampler_ = VK_NULL_HANDLE;
+};
+
+}  // namespace ODEngine
@@ -48,13 +48,11 @@ ODSwapChain::~ODSwapChain() {
 
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-    vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.destroyImage(depthImages[i], depthImageAllocations[i]);
   }
   // for multisampling
   vkDestroyImageView(device.device(), msaaColorImageView, nullptr);
-  vkDestroyImage(device.device(), msaaColorImage, nullptr);
-  vkFreeMemory(device.device(), msaaColorImageMemory, nullptr);
+  device.destroyImage(msaaColorImage, msaaColorImageAllocation);
 
   for (auto framebuffer : swapChainFramebuffers) {
     vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
@@ -276,9 +274,15 @@ void ODSwapChain::createSwapChain() {
 VkImageView ODSwapChain::createImageView(ODDevice &app_device, VkImage image,
                                          VkFormat format,
                                          VkImageAspectFlags aspectMask,
-                                         uint32_t mipLevels) {
+                                         uint32_t mipLevels,
+                                         VkImageUsageFlags usage) {
+  VkImageViewUsageCreateInfo usageInfo{};
+  usageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+  usageInfo.usage = usage;
+
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.pNext = usage != 0 ? &usageInfo : nullptr;
   viewInfo.image = image;
   viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
   viewInfo.format = format;
@@ -416,7 +420,7 @@ void ODSwapChain::createDepthResources() {
   VkExtent2D swapChainExtent = getSwapChainExtent();
 
   depthImages.resize(imageCount());
-  depthImageMemorys.resize(imageCount());
+  depthImageAllocations.resize(imageCount());
   depthImageViews.resize(imageCount());
 
   for (int i = 0; i < depthImages.size(); i++) {
@@ -424,7 +428,7 @@ void ODSwapChain::createDepthResources() {
                 device.getMsaaSamples(), depthFormat, VK_IMAGE_TILING_OPTIMAL,
                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i],
-                depthImageMemorys[i]);
+                depthImageAllocations[i]);
     depthImageViews[i] = createImageView(
         device, depthImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT,
         1); // Ajout de l'assignation depthImageViews[i] = ...
@@ -436,7 +440,8 @@ void ODSwapChain::createImage(ODDevice &app_device, uint32_t width,
                               VkSampleCountFlagBits numSamples, VkFormat format,
                               VkImageTiling tiling, VkImageUsageFlags usage,
                               VkMemoryPropertyFlags properties, VkImage &image,
-                              VkDeviceMemory &imageMemory) {
+                              ODAllocation &imageAllocation,
+                              VkImageCreateFlags flags) {
   VkImageCreateInfo imageInfo{};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -446,34 +451,14 @@ void ODSwapChain::createImage(ODDevice &app_device, uint32_t width,
   imageInfo.mipLevels = mipLevels;
   imageInfo.arrayLayers = 1;
   imageInfo.format = format;
-  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.tiling = tiling;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   imageInfo.usage = usage;
   imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-  imageInfo.flags = 0;
+  imageInfo.flags = flags;
   imageInfo.samples = numSamples;
 
-  if (vkCreateImage(app_device.device(), &imageInfo, nullptr, &image) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to create image!");
-  }
-
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(app_device.device(), image, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = app_device.findMemoryType(
-      memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-  if (vkAllocateMemory(app_device.device(), &allocInfo, nullptr,
-                       &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
-
-  vkBindImageMemory(app_device.device(), image, imageMemory, 0);
+  app_device.createImageWithInfo(imageInfo, properties, image, imageAllocation);
 }
 
 void ODSwapChain::createMsaaColorResources() {
@@ -484,7 +469,7 @@ void ODSwapChain::createMsaaColorResources() {
               VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
                   VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, msaaColorImage,
-              msaaColorImageMemory);
+              msaaColorImageAllocation);
   msaaColorImageView =
       createImageView(device, msaaColorImage, colorFormat,
                       VK_IMAGE_ASPECT_COLOR_BIT, 1); // vérifier
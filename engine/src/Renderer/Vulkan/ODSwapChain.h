@@ -84,16 +84,20 @@ public:
            swapChain.swapChainImageFormat == swapChainImageFormat;
   }
 
+  // usage restricts the view to part of the image's usage (0 keeps all of it),
+  // needed on images created with VK_IMAGE_CREATE_EXTENDED_USAGE_BIT
   static VkImageView createImageView(ODDevice &app_device, VkImage image,
                                      VkFormat format,
                                      VkImageAspectFlags aspectMask,
-                                     uint32_t mipLevels = 1);
+                                     uint32_t mipLevels = 1,
+                                     VkImageUsageFlags usage = 0);
   static void createImage(ODDevice &app_device, uint32_t width, uint32_t height,
                           uint32_t mipLevels, VkSampleCountFlagBits numSamples,
                           VkFormat format, VkImageTiling tiling,
                           VkImageUsageFlags usage,
                           VkMemoryPropertyFlags properties, VkImage &image,
-                          VkDeviceMemory &imageMemory);
+                          ODAllocation &imageAllocation,
+                          VkImageCreateFlags flags = 0);
 
 private:
   void init();
@@ -120,7 +124,7 @@ private:
   VkRenderPass renderPass;
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<ODAllocation> depthImageAllocations;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
@@ -141,7 +145,7 @@ private:
 
   // for multisampling
   VkImage msaaColorImage;
-  VkDeviceMemory msaaColorImageMemory;
+  ODAllocation msaaColorImageAllocation;
   VkImageView msaaColorImageView;
 };
 
@@ -0,0 +1,631 @@
+#include "ODUploadQueue.h"
+
+#include "ODBuffer.h"
+#include "ODDevice.h"
+#include "ODMipGenerator.h"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ODEngine {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+ODUploadQueue::ODUploadQueue(ODDevice &device, VkDeviceSize stagingSize)
+    : device_{device}, ringSize_{stagingSize} {
+  ownershipTransfer_ = device_.hasDedicatedTransferQueue();
+
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.queueFamilyIndex = device_.transferQueueFamily();
+  poolInfo.flags =
+      VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  if (vkCreateCommandPool(device_.device(), &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload command pool!");
+  }
+  if (ownershipTransfer_) {
+    poolInfo.queueFamilyIndex = device_.graphicsQueueFamily();
+    if (vkCreateCommandPool(device_.device(), &poolInfo, nullptr, &acquireCommandPool_) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload acquire command pool!");
+    }
+  }
+
+  VkSemaphoreTypeCreateInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timelineInfo.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = &timelineInfo;
+  if (vkCreateSemaphore(device_.device(), &semaphoreInfo, nullptr, &timeline_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create upload timeline semaphore!");
+  }
+
+  stagingRing_ = std::make_unique<ODBuffer>(
+      device_,
+      ringSize_,
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  if (stagingRing_->map() != VK_SUCCESS) {
+    throw std::runtime_error("failed to map upload staging ring!");
+  }
+  ringData_ = static_cast<uint8_t *>(stagingRing_->getMappedMemory());
+}
+
+ODUploadQueue::~ODUploadQueue() {
+  flush();
+  waitIdle();
+
+  for (auto &batch : freeBatches_) {
+    if (batch->transferFinished != VK_NULL_HANDLE) {
+      vkDestroySemaphore(device_.device(), batch->transferFinished, nullptr);
+    }
+  }
+  freeBatches_.clear();
+  mipGenerator_.reset();
+  stagingRing_.reset();
+  vkDestroySemaphore(device_.device(), timeline_, nullptr);
+  if (acquireCommandPool_ != VK_NULL_HANDLE) {
+    vkDestroyCommandPool(device_.device(), acquireCommandPool_, nullptr);
+  }
+  vkDestroyCommandPool(device_.device(), commandPool_, nullptr);
+}
+
+VkCommandBuffer ODUploadQueue::allocateCommandBuffer(VkCommandPool pool) {
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandPool = pool;
+  allocInfo.commandBufferCount = 1;
+
+  VkCommandBuffer commandBuffer;
+  if (vkAllocateCommandBuffers(device_.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to allocate upload command buffer!");
+  }
+  return commandBuffer;
+}
+
+std::unique_ptr<ODUploadQueue::Batch> ODUploadQueue::acquireBatch() {
+  if (!freeBatches_.empty()) {
+    auto batch = std::move(freeBatches_.back());
+    freeBatches_.pop_back();
+    vkResetCommandBuffer(batch->commandBuffer, 0);
+    if (batch->acquireCommandBuffer != VK_NULL_HANDLE) {
+      vkResetCommandBuffer(batch->acquireCommandBuffer, 0);
+    }
+    return batch;
+  }
+
+  auto batch = std::make_unique<Batch>();
+  batch->commandBuffer = allocateCommandBuffer(commandPool_);
+  if (ownershipTransfer_) {
+    batch->acquireCommandBuffer = allocateCommandBuffer(acquireCommandPool_);
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    if (vkCreateSemaphore(device_.device(), &semaphoreInfo, nullptr, &batch->transferFinished) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to create upload semaphore!");
+    }
+  }
+  return batch;
+}
+
+VkCommandBuffer ODUploadQueue::getCommandBuffer() {
+  if (!openBatch_) {
+    openBatch_ = acquireBatch();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(openBatch_->commandBuffer, &beginInfo);
+  }
+  return openBatch_->commandBuffer;
+}
+
+bool ODUploadQueue::hasPendingData() const {
+  return openBatchUsesRing_ || !inFlight_.empty();
+}
+
+/*
+ * The ring is used from tail_ to head_ (wrapping at ringSize_). When head_ == tail_ the
+ * ring is either empty or full, hasPendingData() tells which.
+ */
+bool ODUploadQueue::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+  if (!hasPendingData()) {
+    head_ = 0;
+    tail_ = 0;
+  }
+
+  VkDeviceSize aligned = alignUp(head_, alignment);
+  if (head_ > tail_ || !hasPendingData()) {
+    if (aligned + size <= ringSize_) {
+      offset = aligned;
+    } else if (size <= tail_) {
+      offset = 0;
+    } else {
+      return false;
+    }
+  } else if (head_ < tail_) {
+    if (aligned + size > tail_) {
+      return false;
+    }
+    offset = aligned;
+  } else {
+    return false;
+  }
+
+  head_ = offset + size;
+  openBatchUsesRing_ = true;
+  return true;
+}
+
+VkBuffer ODUploadQueue::stage(
+    const void *data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+  retireCompleted();
+
+  if (size <= ringSize_) {
+    bool allocated = tryAllocate(size, alignment, offset);
+    while (!allocated && (openBatch_ || !inFlight_.empty())) {
+      // the ring is full: submit what is recorded and recycle the oldest batch
+      flush();
+      retireOldest();
+      allocated = tryAllocate(size, alignment, offset);
+    }
+    if (allocated) {
+      getCommandBuffer();
+      std::memcpy(ringData_ + offset, data, static_cast<size_t>(size));
+      return stagingRing_->getBuffer();
+    }
+  }
+
+  // larger than the whole ring: dedicated staging buffer that lives as long as the batch
+  getCommandBuffer();
+  auto overflow = std::make_unique<ODBuffer>(
+      device_,
+      size,
+      1,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  overflow->map();
+  overflow->writeToBuffer(const_cast<void *>(data), size);
+  offset = 0;
+  VkBuffer buffer = overflow->getBuffer();
+  openBatch_->overflowBuffers.push_back(std::move(overflow));
+  return buffer;
+}
+
+void ODUploadQueue::uploadBuffer(
+    VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset) {
+  if (size == 0) {
+    return;
+  }
+
+  VkDeviceSize srcOffset = 0;
+  VkBuffer srcBuffer = stage(data, size, 16, srcOffset);
+
+  VkCommandBuffer commandBuffer = getCommandBuffer();
+
+  VkBufferCopy copyRegion{};
+  copyRegion.srcOffset = srcOffset;
+  copyRegion.dstOffset = dstOffset;
+  copyRegion.size = size;
+  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+  if (!ownershipTransfer_) {
+    return;
+  }
+
+  // release the written range to the graphics family, acquired in recordAcquires
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = 0;
+  barrier.srcQueueFamilyIndex = device_.transferQueueFamily();
+  barrier.dstQueueFamilyIndex = device_.graphicsQueueFamily();
+  barrier.buffer = dstBuffer;
+  barrier.offset = dstOffset;
+  barrier.size = size;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0,
+      nullptr,
+      1,
+      &barrier,
+      0,
+      nullptr);
+
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                          VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+                          VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT |
+                          VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  openBatch_->bufferAcquires.push_back(barrier);
+}
+
+void ODUploadQueue::uploadImage(
+    VkImage image,
+    VkFormat format,
+    const void *data,
+    VkDeviceSize size,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    bool generateMips) {
+  VkDeviceSize alignment =
+      std::max<VkDeviceSize>(16, device_.properties.limits.optimalBufferCopyOffsetAlignment);
+  VkDeviceSize srcOffset = 0;
+  VkBuffer srcBuffer = stage(data, size, alignment, srcOffset);
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = srcOffset;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {width, height, 1};
+  recordImageCopy(image, format, srcBuffer, &region, 1, width, height, mipLevels, generateMips);
+}
+
+void ODUploadQueue::uploadImageLevels(
+    VkImage image,
+    const void *data,
+    VkDeviceSize size,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    const VkDeviceSize *levelOffsets) {
+  VkDeviceSize alignment =
+      std::max<VkDeviceSize>(16, device_.properties.limits.optimalBufferCopyOffsetAlignment);
+  VkDeviceSize srcOffset = 0;
+  VkBuffer srcBuffer = stage(data, size, alignment, srcOffset);
+
+  // one copy command for the whole chain
+  std::vector<VkBufferImageCopy> regions(mipLevels);
+  for (uint32_t level = 0; level < mipLevels; level++) {
+    VkBufferImageCopy &region = regions[level];
+    region.bufferOffset = srcOffset + levelOffsets[level];
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = level;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {std::max(width >> level, 1u), std::max(height >> level, 1u), 1};
+  }
+  recordImageCopy(
+      image, VK_FORMAT_UNDEFINED, srcBuffer, regions.data(), mipLevels, width, height, mipLevels,
+      false);
+}
+
+void ODUploadQueue::recordImageCopy(
+    VkImage image,
+    VkFormat format,
+    VkBuffer srcBuffer,
+    const VkBufferImageCopy *regions,
+    uint32_t regionCount,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels,
+    bool generateMips) {
+  VkCommandBuffer commandBuffer = getCommandBuffer();
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mipLevels;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+
+  vkCmdCopyBufferToImage(
+      commandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions);
+
+  generateMips = generateMips && mipLevels > 1;
+
+  if (ownershipTransfer_) {
+    // release to the graphics family. The layout change (if any) is part of the
+    // release/acquire pair, and mipmaps are generated after the acquire.
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = generateMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                                     : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = device_.transferQueueFamily();
+    barrier.dstQueueFamilyIndex = device_.graphicsQueueFamily();
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+
+    openBatch_->imageAcquires.push_back({image, format, width, height, mipLevels, generateMips});
+    return;
+  }
+
+  if (generateMips) {
+    recordGenerateMips(commandBuffer, {image, format, width, height, mipLevels, generateMips});
+    return;
+  }
+
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &barrier);
+}
+
+void ODUploadQueue::recordAcquires(Batch &batch) {
+  VkCommandBuffer commandBuffer = batch.acquireCommandBuffer;
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+  if (!batch.bufferAcquires.empty()) {
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(batch.bufferAcquires.size()),
+        batch.bufferAcquires.data(),
+        0,
+        nullptr);
+  }
+
+  for (const auto &pending : batch.imageAcquires) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = pending.generateMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                                             : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = pending.generateMips
+                                ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+                                : VK_ACCESS_SHADER_READ_BIT;
+    barrier.srcQueueFamilyIndex = device_.transferQueueFamily();
+    barrier.dstQueueFamilyIndex = device_.graphicsQueueFamily();
+    barrier.image = pending.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = pending.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        pending.generateMips ? VK_PIPELINE_STAGE_TRANSFER_BIT
+                             : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0,
+        0,
+        nullptr,
+        0,
+        nullptr,
+        1,
+        &barrier);
+
+    if (pending.generateMips) {
+      recordGenerateMips(commandBuffer, pending);
+    }
+  }
+}
+
+void ODUploadQueue::recordGenerateMips(VkCommandBuffer commandBuffer, const PendingImage &pending) {
+  if (!mipGenerator_) {
+    mipGenerator_ = std::make_unique<ODMipGenerator>(device_);
+  }
+  // recorded into the open batch, the next ticket flush() hands out
+  mipGenerator_->record(
+      commandBuffer,
+      pending.image,
+      pending.format,
+      pending.width,
+      pending.height,
+      pending.mipLevels,
+      submittedValue_ + 1);
+}
+
+uint64_t ODUploadQueue::flush() {
+  if (!openBatch_) {
+    return submittedValue_;
+  }
+
+  Batch &batch = *openBatch_;
+  uint64_t value = submittedValue_ + 1;
+  bool acquire = ownershipTransfer_ &&
+                 (!batch.bufferAcquires.empty() || !batch.imageAcquires.empty());
+
+  // make every write of the batch visible to the work submitted after it. With a
+  // dedicated transfer queue the release/acquire barriers do this instead.
+  VkMemoryBarrier memoryBarrier{};
+  memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+                                VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT |
+                                VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  if (!ownershipTransfer_) {
+    vkCmdPipelineBarrier(
+        batch.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &memoryBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+  }
+
+  if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error("failed to record upload command buffer!");
+  }
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues = &value;
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &batch.commandBuffer;
+  submitInfo.signalSemaphoreCount = 1;
+  if (acquire) {
+    submitInfo.pSignalSemaphores = &batch.transferFinished;
+  } else {
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.pSignalSemaphores = &timeline_;
+  }
+  if (vkQueueSubmit(device_.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+    throw std::runtime_error("failed to submit upload batch!");
+  }
+
+  if (acquire) {
+    // the graphics queue waits for the copies on the GPU, takes ownership, generates
+    // mipmaps and signals the ticket. Later graphics submissions are ordered behind
+    // the final barrier.
+    recordAcquires(batch);
+    vkCmdPipelineBarrier(
+        batch.acquireCommandBuffer,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &memoryBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    if (vkEndCommandBuffer(batch.acquireCommandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("failed to record upload acquire command buffer!");
+    }
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkSubmitInfo acquireInfo{};
+    acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    acquireInfo.pNext = &timelineInfo;
+    acquireInfo.waitSemaphoreCount = 1;
+    acquireInfo.pWaitSemaphores = &batch.transferFinished;
+    acquireInfo.pWaitDstStageMask = &waitStage;
+    acquireInfo.commandBufferCount = 1;
+    acquireInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+    acquireInfo.signalSemaphoreCount = 1;
+    acquireInfo.pSignalSemaphores = &timeline_;
+    if (vkQueueSubmit(device_.graphicsQueue(), 1, &acquireInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+      throw std::runtime_error("failed to submit upload acquire batch!");
+    }
+  }
+
+  batch.value = value;
+  batch.ringEnd = head_;
+  submittedValue_ = value;
+  inFlight_.push_back(std::move(openBatch_));
+  openBatchUsesRing_ = false;
+  return submittedValue_;
+}
+
+void ODUploadQueue::retireOldest() {
+  auto batch = std::move(inFlight_.front());
+  inFlight_.pop_front();
+
+  if (completedValue_ < batch->value) {
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline_;
+    waitInfo.pValues = &batch->value;
+    vkWaitSemaphores(device_.device(), &waitInfo, UINT64_MAX);
+    completedValue_ = batch->value;
+  }
+
+  tail_ = batch->ringEnd;
+  if (mipGenerator_) {
+    mipGenerator_->release(completedValue_);
+  }
+  batch->bufferAcquires.clear();
+  batch->imageAcquires.clear();
+  batch->overflowBuffers.clear();
+  freeBatches_.push_back(std::move(batch));
+}
+
+void ODUploadQueue::retireCompleted() {
+  if (inFlight_.empty()) {
+    return;
+  }
+  uint64_t counter = 0;
+  vkGetSemaphoreCounterValue(device_.device(), timeline_, &counter);
+  completedValue_ = std::max(completedValue_, counter);
+  while (!inFlight_.empty() && inFlight_.front()->value <= completedValue_) {
+    retireOldest();
+  }
+}
+
+bool ODUploadQueue::isComplete(uint64_t ticket) {
+  retireCompleted();
+  return ticket <= completedValue_;
+}
+
+void ODUploadQueue::wait(uint64_t ticket) {
+  if (ticket > submittedValue_) {
+    flush();
+  }
+  while (completedValue_ < ticket && !inFlight_.empty()) {
+    retireOldest();
+  }
+}
+
+void ODUploadQueue::waitIdle() {
+  wait(submittedValue_);
+}
+
+}  // namespace ODEngine
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace ODEngine {
+
+class ODDevice;
+class ODBuffer;
+class ODMipGenerator;
+
+/*
+ * Batched GPU uploads through a persistently mapped staging ring.
+ *
+ * uploadBuffer/uploadImage copy the source data into the ring and record the
+ * transfer into the open batch command buffer; nothing is submitted until
+ * flush(). Batches run on the dedicated transfer queue when the device has
+ * one. The written ranges are then released to the graphics family, and a
+ * small acquire submission on the graphics queue waits for the copy on the
+ * GPU, acquires them and generates mipmaps (ODMipGenerator, on the graphics and
+ * compute family).
+ *
+ * Every batch is signed off with a value on a timeline semaphore: the upload
+ * ticket returned by flush(). Work submitted to the graphics queue after
+ * flush() is ordered behind the batch without a CPU wait. Submissions to other
+ * queues can wait on timelineSemaphore() at that ticket, and the CPU can poll
+ * it with isComplete().
+ */
+class ODUploadQueue {
+ public:
+  static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+  ODUploadQueue(ODDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+  ~ODUploadQueue();
+
+  ODUploadQueue(const ODUploadQueue &) = delete;
+  ODUploadQueue &operator=(const ODUploadQueue &) = delete;
+
+  void uploadBuffer(
+      VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+  // Uploads mip 0 of a 2D color image created with TRANSFER_DST (and the ODMipGenerator
+  // usage and flags when generateMips is set). The image ends in SHADER_READ_ONLY_OPTIMAL
+  // for every mip level.
+  void uploadImage(
+      VkImage image,
+      VkFormat format,
+      const void *data,
+      VkDeviceSize size,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mipLevels,
+      bool generateMips);
+
+  // Uploads a precomputed mip chain with one copy, no blits. data holds every level,
+  // level i at levelOffsets[i] (aligned to the format's texel block size). The image
+  // ends in SHADER_READ_ONLY_OPTIMAL for every mip level.
+  void uploadImageLevels(
+      VkImage image,
+      const void *data,
+      VkDeviceSize size,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mipLevels,
+      const VkDeviceSize *levelOffsets);
+
+  // Submits the open batch and returns its ticket, or the last submitted ticket when
+  // nothing was recorded.
+  uint64_t flush();
+  bool isComplete(uint64_t ticket);
+  void wait(uint64_t ticket);
+  void waitIdle();
+
+  VkSemaphore timelineSemaphore() const { return timeline_; }
+  uint64_t lastSubmittedTicket() const { return submittedValue_; }
+
+ private:
+  struct PendingImage {
+    VkImage image;
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    bool generateMips;
+  };
+
+  struct Batch {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    // graphics family side of the ownership transfer, dedicated transfer queue only
+    VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+    VkSemaphore transferFinished = VK_NULL_HANDLE;
+    std::vector<VkBufferMemoryBarrier> bufferAcquires;
+    std::vector<PendingImage> imageAcquires;
+
+    VkDeviceSize ringEnd = 0;
+    uint64_t value = 0;
+    // staging for uploads that do not fit in the ring, released with the batch
+    std::vector<std::unique_ptr<ODBuffer>> overflowBuffers;
+  };
+
+  VkCommandBuffer getCommandBuffer();
+  // layout transitions around the copy, then mip generation or the release to graphics
+  void recordImageCopy(
+      VkImage image,
+      VkFormat format,
+      VkBuffer srcBuffer,
+      const VkBufferImageCopy *regions,
+      uint32_t regionCount,
+      uint32_t width,
+      uint32_t height,
+      uint32_t mipLevels,
+      bool generateMips);
+  // Returns the staging buffer and offset holding a copy of data
+  VkBuffer stage(const void *data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+  bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+  bool hasPendingData() const;
+  void recordAcquires(Batch &batch);
+  void retireCompleted();
+  void retireOldest();
+  std::unique_ptr<Batch> acquireBatch();
+  VkCommandBuffer allocateCommandBuffer(VkCommandPool pool);
+  void recordGenerateMips(VkCommandBuffer commandBuffer, const PendingImage &pending);
+
+  ODDevice &device_;
+  bool ownershipTransfer_ = false;
+  VkCommandPool commandPool_ = VK_NULL_HANDLE;
+  VkCommandPool acquireCommandPool_ = VK_NULL_HANDLE;
+  VkSemaphore timeline_ = VK_NULL_HANDLE;
+
+  // created with the first mip generation
+  std::unique_ptr<ODMipGenerator> mipGenerator_;
+
+  std::unique_ptr<ODBuffer> stagingRing_;
+  uint8_t *ringData_ = nullptr;
+  VkDeviceSize ringSize_ = 0;
+  VkDeviceSize head_ = 0; // next free byte
+  VkDeviceSize tail_ = 0; // first byte still read by an in-flight batch
+
+  std::unique_ptr<Batch> openBatch_;
+  bool openBatchUsesRing_ = false;
+  std::deque<std::unique_ptr<Batch>> inFlight_;
+  std::vector<std::unique_ptr<Batch>> freeBatches_;
+
+  uint64_t submittedValue_ = 0;
+  uint64_t completedValue_ = 0;
+};
+
+}  // namespace ODEngine
@@ -107,7 +107,9 @@ void GPUParticleSystem::render(FrameInfo &frameInfo) {
   vkCmdBindDescriptorSets(frameInfo.commandBuffer,
                           VK_PIPELINE_BIND_POINT_GRAPHICS,
                           m_graphicsPipelineLayout, 0, 1,
-                          &frameInfo.globalDescriptorSet, 0, nullptr);
+                          &frameInfo.globalDescriptorSet,
+                          GLOBAL_DYNAMIC_OFFSET_COUNT,
+                          frameInfo.globalDynamicOffsets.data());
 
   VkDeviceSize offsets[] = {0};
   vkCmdBindVertexBuffers(frameInfo.commandBuffer, 0, 1,
@@ -158,7 +160,9 @@ void GPUParticleSystem::recordComputeCommandBuffer(
 
   vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                           m_computePipelineLayout, 0, 1,
-                          &frameInfo.globalDescriptorSet, 0, nullptr);
+                          &frameInfo.globalDescriptorSet,
+                          GLOBAL_DYNAMIC_OFFSET_COUNT,
+                          frameInfo.globalDynamicOffsets.data());
 
   vkCmdDispatch(commandBuffer, ODParticles::PARTICLE_COUNT / 256, 1, 1);
 
@@ -84,8 +84,8 @@ namespace ODEngine {
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr
+            GLOBAL_DYNAMIC_OFFSET_COUNT,
+            frameInfo.globalDynamicOffsets.data()
         );
         m_grid->bind(frameInfo.commandBuffer);
         m_grid->draw(frameInfo.commandBuffer);
@@ -0,0 +1,295 @@
+#include "MeshletCullingSystem.h"
+#include "Renderer/Common/ODAssetRegistry.h"
+#include "Renderer/Common/ODFrustumCuller.h"
+#include "Renderer/Vulkan/ODSwapChain.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE // -> valeur de profondeur de 0 à 1
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace ODEngine {
+// same layouts as in meshlet_cull.comp
+struct MeshletCullUbo {
+  glm::vec4 frustumPlanes[6]; // xyz inward normal, w distance, world space
+};
+
+struct MeshletCullPushConstantData {
+  glm::mat4 modelMatrix{1.0f};
+  glm::vec4 cameraPosition{0.f}; // object space, w = 1 enables cone culling
+  uint32_t firstMeshlet = 0;
+  uint32_t meshletCount = 0;
+  uint32_t firstCommand = 0;
+  uint32_t countSlot = 0;
+  uint32_t firstIndex = 0; // of the model in its arena
+  int32_t vertexOffset = 0;
+  float maxScale = 1.f;
+  uint32_t compact = 0; // 1: append visible meshlets through the count slot
+};
+
+MeshletCullingSystem::MeshletCullingSystem(ODDevice &device,
+                                           ODFrameAllocator &frameAllocator)
+    : m_device(device), m_frameAllocator(frameAllocator) {
+  createDescriptors();
+  createPipelineLayout();
+  createPipeline();
+}
+
+MeshletCullingSystem::~MeshletCullingSystem() {
+  vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+}
+
+void MeshletCullingSystem::createDescriptors() {
+  m_setLayout =
+      ODDescriptorSetLayout::Builder(m_device)
+          .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                      VK_SHADER_STAGE_COMPUTE_BIT)
+          .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                      VK_SHADER_STAGE_COMPUTE_BIT) // meshlets
+          .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                      VK_SHADER_STAGE_COMPUTE_BIT) // draw commands
+          .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                      VK_SHADER_STAGE_COMPUTE_BIT) // draw counts
+          .build();
+
+  addDescriptorPool();
+
+  m_frames.resize(ODSwapChain::MAX_FRAMES_IN_FLIGHT);
+  for (FrameResources &frame : m_frames) {
+    frame.commands = std::make_unique<ODBuffer>(
+        m_device, sizeof(VkDrawIndexedIndirectCommand), MAX_DRAW_COMMANDS,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    frame.counts = std::make_unique<ODBuffer>(
+        m_device, sizeof(uint32_t), MAX_OBJECTS,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+}
+
+void MeshletCullingSystem::addDescriptorPool() {
+  m_descriptorPools.push_back(
+      ODDescriptorPool::Builder(m_device)
+          .setMaxSets(ARENA_SETS_PER_POOL)
+          .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                       ARENA_SETS_PER_POOL)
+          .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                       ARENA_SETS_PER_POOL * 3)
+          .build());
+}
+
+VkDescriptorSet MeshletCullingSystem::getArenaSet(FrameResources &frame,
+                                                  uint32_t arena) {
+  auto it = frame.arenaSets.find(arena);
+  if (it != frame.arenaSets.end()) {
+    return it->second;
+  }
+
+  // meshlet arenas live as long as the geometry pool, the set is never updated
+  auto uboInfo = m_frameAllocator.descriptorInfo(sizeof(MeshletCullUbo));
+  VkDescriptorBufferInfo meshletInfo{
+      m_device.geometryPool().getVertexBuffer(arena), 0, VK_WHOLE_SIZE};
+  auto commandInfo = frame.commands->descriptorInfo();
+  auto countInfo = frame.counts->descriptorInfo();
+
+  auto writeSet = [&](VkDescriptorSet &set) {
+    return ODDescriptorWriter(*m_setLayout, *m_descriptorPools.back())
+        .writeBuffer(0, &uboInfo)
+        .writeBuffer(1, &meshletInfo)
+        .writeBuffer(2, &commandInfo)
+        .writeBuffer(3, &countInfo)
+        .build(set);
+  };
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  if (!writeSet(set)) {
+    // the geometry pool grew past the arenas the pools were sized for
+    addDescriptorPool();
+    if (!writeSet(set)) {
+      throw std::runtime_error("failed to allocate meshlet culling descriptor set!");
+    }
+  }
+  frame.arenaSets.emplace(arena, set);
+  return set;
+}
+
+void MeshletCullingSystem::createPipelineLayout() {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(MeshletCullPushConstantData);
+
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+      m_setLayout->getDescriptorSetLayout()};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount =
+      static_cast<uint32_t>(descriptorSetLayouts.size());
+  pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+  if (vkCreatePipelineLayout(m_device.device(), &pipelineLayoutInfo, nullptr,
+                             &m_pipelineLayout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline layout!");
+  }
+}
+
+void MeshletCullingSystem::createPipeline() {
+  assert(m_pipelineLayout != nullptr &&
+         "Pipeline layout must be created before creating the pipeline");
+
+  ODComputePipelineConfigInfo pipelineConfig{};
+  pipelineConfig.pipelineLayout = m_pipelineLayout;
+
+  m_odComputePipeline = std::make_unique<ODComputePipeline>(
+      m_device, ENGINE_PATH "/shaders/compiled/meshlet_cull.spv",
+      pipelineConfig);
+}
+
+void MeshletCullingSystem::cull(
+    FrameInfo &frameInfo, const std::vector<ODGameObject *> &objects) {
+  FrameResources &frame = m_frames[frameInfo.frameIndex];
+  frame.draws.clear();
+
+  const bool compact = m_device.supportsDrawIndirectCount();
+  VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+  MeshletCullUbo ubo{};
+  ODFrustumCuller::extractPlanes(frameInfo.camera.getProjection() *
+                                     frameInfo.camera.getView(),
+                                 ubo.frustumPlanes);
+  uint32_t uboOffset = 0;
+  glm::vec3 cameraPosition = frameInfo.camera.getInverseView()[3];
+
+  uint32_t commandCount = 0;
+  bool recording = false;
+  VkDescriptorSet boundSet = VK_NULL_HANDLE;
+
+  // objects outside of the frustum get neither a dispatch nor command slots
+  for (ODGameObject *object : objects) {
+    ODGameObject &obj = *object;
+    const ODModel *resolved = frameInfo.assets->getModel(obj.model);
+    if (resolved == nullptr || !resolved->hasMeshlets()) {
+      continue;
+    }
+    const ODModel &model = *resolved;
+    const ODModel::Lod &lod =
+        model.getLod(std::min(obj.lod, model.getLodCount() - 1));
+    if (lod.meshletCount == 0 ||
+        commandCount + lod.meshletCount > MAX_DRAW_COMMANDS ||
+        frame.draws.size() >= MAX_OBJECTS) {
+      continue;
+    }
+
+    if (!recording) {
+      // the counts are appended to, they start at 0 every frame
+      vkCmdFillBuffer(commandBuffer, frame.counts->getBuffer(), 0,
+                      VK_WHOLE_SIZE, 0);
+      VkMemoryBarrier clearBarrier{};
+      clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+      clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      clearBarrier.dstAccessMask =
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                           &clearBarrier, 0, nullptr, 0, nullptr);
+
+      m_odComputePipeline->bind(commandBuffer);
+      uboOffset = m_frameAllocator.push(ubo);
+      recording = true;
+    }
+
+    VkDescriptorSet set = getArenaSet(frame, model.getMeshlets().arena);
+    if (set != boundSet) {
+      vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                              m_pipelineLayout, 0, 1, &set, 1, &uboOffset);
+      boundSet = set;
+    }
+
+    MeshletCullPushConstantData push{};
+    push.modelMatrix = obj.transform.mat4();
+    glm::vec3 scale = glm::abs(obj.transform.scale);
+    push.maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+    // the cone test runs in object space, where only a uniform scale keeps angles
+    bool uniformScale = glm::max(scale.x, glm::max(scale.y, scale.z)) -
+                            glm::min(scale.x, glm::min(scale.y, scale.z)) <=
+                        1e-4f * push.maxScale;
+    push.cameraPosition = glm::vec4(
+        glm::vec3(glm::inverse(push.modelMatrix) *
+                  glm::vec4(cameraPosition, 1.f)),
+        m_coneCulling && uniformScale ? 1.f : 0.f);
+    push.firstMeshlet = model.getMeshlets().firstVertex + lod.firstMeshlet;
+    push.meshletCount = lod.meshletCount;
+    push.firstCommand = commandCount;
+    push.countSlot = static_cast<uint32_t>(frame.draws.size());
+    push.firstIndex = model.getGeometry().firstIndex;
+    push.vertexOffset = static_cast<int32_t>(model.getGeometry().firstVertex);
+    push.compact = compact ? 1 : 0;
+
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(MeshletCullPushConstantData), &push);
+    vkCmdDispatch(commandBuffer,
+                  (lod.meshletCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1,
+                  1);
+
+    frame.draws.emplace(obj.getId(), ObjectDraw{commandCount, lod.meshletCount,
+                                                push.countSlot});
+    commandCount += lod.meshletCount;
+  }
+
+  if (recording) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+  }
+}
+
+bool MeshletCullingSystem::hasDraw(const FrameInfo &frameInfo,
+                                   const ODGameObject &obj) const {
+  return m_frames[frameInfo.frameIndex].draws.count(obj.getId()) != 0;
+}
+
+bool MeshletCullingSystem::draw(const FrameInfo &frameInfo,
+                                const ODGameObject &obj) const {
+  const FrameResources &frame = m_frames[frameInfo.frameIndex];
+  auto it = frame.draws.find(obj.getId());
+  if (it == frame.draws.end()) {
+    return false;
+  }
+
+  const ObjectDraw &draw = it->second;
+  constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  VkDeviceSize offset = VkDeviceSize{draw.firstCommand} * stride;
+  VkBuffer commands = frame.commands->getBuffer();
+  if (m_device.supportsDrawIndirectCount()) {
+    vkCmdDrawIndexedIndirectCount(frameInfo.commandBuffer, commands, offset,
+                                  frame.counts->getBuffer(),
+                                  VkDeviceSize{draw.countSlot} * sizeof(uint32_t),
+                                  draw.commandCount, stride);
+  } else if (m_device.supportsMultiDrawIndirect()) {
+    vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, commands, offset,
+                             draw.commandCount, stride);
+  } else {
+    for (uint32_t i = 0; i < draw.commandCount; i++) {
+      vkCmdDrawIndexedIndirect(frameInfo.commandBuffer, commands,
+                               offset + VkDeviceSize{i} * stride, 1, stride);
+    }
+  }
+  return true;
+}
+
+} // namespace ODEngine
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Renderer/Common/ODCamera.h"
+#include "Renderer/Vulkan/ODBuffer.h"
+#include "Renderer/Vulkan/ODDescriptors.h"
+#include "Renderer/Vulkan/ODDevice.h"
+#include "Renderer/Vulkan/ODFrameAllocator.h"
+#include "Renderer/Common/ODModel.h"
+#include "Renderer/Common/ODGameObject.h"
+#include "Renderer/Vulkan/ODPipeline.h"
+#include "Renderer/Common/FrameInfo.h"
+
+// std
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ODEngine {
+    /*
+     * GPU meshlet culling without mesh shaders. Before the render pass, meshlet_cull.comp
+     * tests every meshlet of the selected LOD of each model against the frustum (and the
+     * backface cone when enabled) and writes VkDrawIndexedIndirectCommands into a per-frame
+     * buffer. The graphics pass then draws each object with one indirect call:
+     *  - drawIndirectCount: surviving meshlets are compacted with an atomic counter per
+     *    object, vkCmdDrawIndexedIndirectCount reads the count
+     *  - otherwise: one command per meshlet, culled ones get instanceCount 0
+     */
+    class MeshletCullingSystem {
+        public:
+            static constexpr uint32_t WORKGROUP_SIZE = 64;
+            // per frame in flight
+            static constexpr uint32_t MAX_DRAW_COMMANDS = 65536;
+            static constexpr uint32_t MAX_OBJECTS = 4096;
+            // Descriptor sets per pool, one per frame in flight and geometry pool arena holding
+            // meshlets. Another pool is added when the arenas outgrow it.
+            static constexpr uint32_t ARENA_SETS_PER_POOL = 16;
+
+            MeshletCullingSystem(ODDevice& device, ODFrameAllocator& frameAllocator);
+            virtual ~MeshletCullingSystem();
+
+            MeshletCullingSystem(const MeshletCullingSystem&) = delete;
+            MeshletCullingSystem& operator=(const MeshletCullingSystem&) = delete;
+
+            // Records the culling of the objects with meshlets among objects (the ones left by
+            // SimpleRendererSystem::cull), outside of a render pass and once obj.lod is
+            // selected for this frame
+            void cull(FrameInfo& frameInfo, const std::vector<ODGameObject*>& objects);
+            // Draws obj with the commands written by cull, the geometry arena, pipeline and push
+            // constants being bound by the caller. Returns false when obj went through the
+            // regular path (no meshlets or over the per frame limits).
+            bool draw(const FrameInfo& frameInfo, const ODGameObject& obj) const;
+            // true when cull wrote commands for obj this frame
+            bool hasDraw(const FrameInfo& frameInfo, const ODGameObject& obj) const;
+
+            // Cone culling drops meshlets whose triangles all face away from the camera, which
+            // is only correct for pipelines culling back faces. SimpleRendererSystem draws
+            // double sided (VK_CULL_MODE_NONE), so it stays off by default.
+            void setConeCulling(bool enabled) { m_coneCulling = enabled; }
+
+        private:
+            struct ObjectDraw {
+                uint32_t firstCommand;
+                uint32_t commandCount;
+                uint32_t countSlot;
+            };
+
+            struct FrameResources {
+                std::unique_ptr<ODBuffer> commands;
+                std::unique_ptr<ODBuffer> counts;
+                std::unordered_map<uint32_t, VkDescriptorSet> arenaSets; // meshlet arena -> set
+                std::unordered_map<ODGameObject::id_t, ObjectDraw> draws;
+            };
+
+            void createDescriptors();
+            void addDescriptorPool();
+            void createPipelineLayout();
+            void createPipeline();
+            VkDescriptorSet getArenaSet(FrameResources& frame, uint32_t arena);
+
+        private:
+            ODDevice& m_device;
+            ODFrameAllocator& m_frameAllocator;
+            std::unique_ptr<ODDescriptorSetLayout> m_setLayout;
+            // the sets are never freed, only the last pool has room left
+            std::vector<std::unique_ptr<ODDescriptorPool>> m_descriptorPools;
+            std::unique_ptr<ODComputePipeline> m_odComputePipeline;
+            VkPipelineLayout m_pipelineLayout = nullptr;
+            std::vector<FrameResources> m_frames;
+            bool m_coneCulling = false;
+    };
+
+}
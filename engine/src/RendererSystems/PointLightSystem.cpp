@@ -116,8 +116,8 @@ namespace ODEngine {
             0,
             1,
             &frameInfo.globalDescriptorSet,
-            0,
-            nullptr
+            GLOBAL_DYNAMIC_OFFSET_COUNT,
+            frameInfo.globalDynamicOffsets.data()
         );
 
         // iterate through sorted in reverse order
@@ -1,4 +1,8 @@
 #include "SimpleRendererSystem.h"
+#include "MeshletCullingSystem.h"
+#include "Renderer/Common/ODAssetRegistry.h"
+#include "Renderer/Vulkan/ODSwapChain.h"
+#include "Utils/ODThreadPool.h"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,24 +11,38 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <thread>
 
 namespace ODEngine {
-struct SimplePushConstantData {
+// same layouts as in simple_shader.vert
+struct SimpleObjectData {
   glm::mat4 modelMatrix{1.0f};
-  glm::mat4 normalMatrix{1.0f};
-  // alignas(16)glm::vec3 color;
+  // mat3 in the shaders, std430 pads its columns to 16 bytes
+  glm::mat3x4 normalMatrix{1.0f};
+  // element of the bindless texture array (set 1)
+  uint32_t textureIndex = 0;
+  uint32_t padding[3] = {};
+};
+
+struct SimplePushConstantData {
+  // added to gl_InstanceIndex, 0 for the indirect draws
+  uint32_t objectIndex = 0;
 };
 
 SimpleRendererSystem::SimpleRendererSystem(
     ODDevice &device, VkRenderPass renderPass,
-    VkDescriptorSetLayout globalSetLayout)
+    VkDescriptorSetLayout globalSetLayout,
+    VkDescriptorSetLayout textureSetLayout)
     : m_device(device) {
-  createPipelineLayout(globalSetLayout);
+  createObjectDescriptors();
+  createPipelineLayout(globalSetLayout, textureSetLayout);
   createPipeline(renderPass);
 }
 
@@ -32,15 +50,97 @@ SimpleRendererSystem::~SimpleRendererSystem() {
   vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
 }
 
+void SimpleRendererSystem::createObjectDescriptors() {
+  m_objectSetLayout =
+      ODDescriptorSetLayout::Builder(m_device)
+          .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                      VK_SHADER_STAGE_VERTEX_BIT)
+          .build();
+  m_objectDescriptorPool =
+      ODDescriptorPool::Builder(m_device)
+          .setMaxSets(ODSwapChain::MAX_FRAMES_IN_FLIGHT)
+          .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                       ODSwapChain::MAX_FRAMES_IN_FLIGHT)
+          .build();
+
+  m_frames.resize(ODSwapChain::MAX_FRAMES_IN_FLIGHT);
+  for (FrameResources &frame : m_frames) {
+    reserveObjects(frame, INITIAL_OBJECT_CAPACITY);
+  }
+}
+
+void SimpleRendererSystem::reserveObjects(FrameResources &frame,
+                                          uint32_t count) {
+  if (count <= frame.capacity) {
+    return;
+  }
+  frame.capacity = std::max(count, frame.capacity * 2);
+
+  // written by the CPU every frame and read once by the GPU, host visible
+  frame.objects = std::make_unique<ODBuffer>(
+      m_device, sizeof(SimpleObjectData), frame.capacity,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  frame.objects->map();
+  frame.commands = std::make_unique<ODBuffer>(
+      m_device, sizeof(VkDrawIndexedIndirectCommand), frame.capacity,
+      VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  frame.commands->map();
+
+  auto objectInfo = frame.objects->descriptorInfo();
+  ODDescriptorWriter writer(*m_objectSetLayout, *m_objectDescriptorPool);
+  writer.writeBuffer(0, &objectInfo);
+  if (frame.objectSet == VK_NULL_HANDLE) {
+    if (!writer.build(frame.objectSet)) {
+      throw std::runtime_error("failed to allocate object descriptor set!");
+    }
+  } else {
+    writer.overwrite(frame.objectSet);
+  }
+}
+
+SimpleRendererSystem::DrawGroup &
+SimpleRendererSystem::getGroup(bool compact, uint32_t arena) {
+  // a handful of arenas at most, a linear search is enough
+  for (DrawGroup &group : m_groups) {
+    if (group.compact == compact && group.arena == arena) {
+      return group;
+    }
+  }
+  m_groups.push_back({compact, arena, {}});
+  return m_groups.back();
+}
+
+SimpleRendererSystem::InstanceBatch &
+SimpleRendererSystem::getBatch(ODModel *model, uint32_t lod) {
+  auto [it, inserted] = m_batchLookup.try_emplace(BatchKey{model, lod}, m_batchCount);
+  if (!inserted) {
+    return m_batches[it->second];
+  }
+  if (m_batchCount == m_batches.size()) {
+    m_batches.emplace_back();
+  }
+  InstanceBatch &batch = m_batches[m_batchCount++];
+  batch.model = model;
+  batch.lod = lod;
+  batch.objects.clear();
+  return batch;
+}
+
 void SimpleRendererSystem::createPipelineLayout(
-    VkDescriptorSetLayout globalSetLayout) {
+    VkDescriptorSetLayout globalSetLayout,
+    VkDescriptorSetLayout textureSetLayout) {
   VkPushConstantRange pushConstantRange{};
-  pushConstantRange.stageFlags =
-      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
   pushConstantRange.offset = 0;
   pushConstantRange.size = sizeof(SimplePushConstantData);
 
-  std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+      globalSetLayout, textureSetLayout,
+      m_objectSetLayout->getDescriptorSetLayout()};
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -61,6 +161,7 @@ void SimpleRendererSystem::createPipeline(VkRenderPass renderPass) {
          "Pipeline layout must be created before creating the pipeline");
 
   m_odPipeline.reset();
+  m_compactPipeline.reset();
 
   ODGraphicsPipelineConfigInfo pipelineConfig{};
   ODGraphicsPipeline::defaultPipelineConfigInfo(m_device, pipelineConfig);
@@ -70,32 +171,234 @@ void SimpleRendererSystem::createPipeline(VkRenderPass renderPass) {
   m_odPipeline = std::make_unique<ODGraphicsPipeline>(
       m_device, ENGINE_PATH "/shaders/compiled/simple_shader.vert.spv",
       ENGINE_PATH "/shaders/compiled/simple_shader.frag.spv", pipelineConfig);
+
+  pipelineConfig.bindingDescriptions =
+      ODModel::CompactVertex::getBindingDescriptions();
+  pipelineConfig.attributeDescriptions =
+      ODModel::CompactVertex::getAttributeDescriptions();
+  m_compactPipeline = std::make_unique<ODGraphicsPipeline>(
+      m_device, ENGINE_PATH "/shaders/compiled/simple_shader_compact.vert.spv",
+      ENGINE_PATH "/shaders/compiled/simple_shader.frag.spv", pipelineConfig);
 }
 
-void SimpleRendererSystem::renderGameObjects(FrameInfo &frameInfo) {
+float SimpleRendererSystem::getPixelsPerUnit(const FrameInfo &frameInfo,
+                                             const ODGameObject &obj,
+                                             const ODModel &model,
+                                             const glm::mat4 &modelMatrix) const {
+  // distance from the camera to the closest point of the bounding sphere
+  glm::vec3 center = model.getBoundsCenter();
+  glm::vec3 scale = glm::abs(obj.transform.scale);
+  float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+  float radius = model.getBoundsRadius() * maxScale;
+  glm::vec3 cameraPosition = frameInfo.camera.getInverseView()[3];
+  glm::vec3 centerWorld = modelMatrix * glm::vec4(center, 1.f);
+  float distance = glm::length(centerWorld - cameraPosition) - radius;
+  if (distance <= 0.f) {
+    return std::numeric_limits<float>::infinity();
+  }
 
-  m_odPipeline->bind(frameInfo.commandBuffer);
+  // pixels covered by one object space unit at that distance
+  float focalScale = glm::abs(frameInfo.camera.getProjection()[1][1]);
+  return maxScale * focalScale * 0.5f *
+         static_cast<float>(frameInfo.extent.height) / distance;
+}
 
-  vkCmdBindDescriptorSets(frameInfo.commandBuffer,
-                          VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0,
-                          1, &frameInfo.globalDescriptorSet, 0, nullptr);
+uint32_t SimpleRendererSystem::selectLod(const ODGameObject &obj,
+                                         const ODModel &model,
+                                         float pixelsPerUnit) const {
+  if (model.getLodCount() == 1 || std::isinf(pixelsPerUnit)) {
+    return 0;
+  }
+  return model.selectLod(pixelsPerUnit, obj.lod, LOD_PIXEL_ERROR,
+                         LOD_HYSTERESIS);
+}
 
+void SimpleRendererSystem::cull(FrameInfo &frameInfo) {
+  m_cullObjects.clear();
+  m_culler.clear();
+  m_culler.reserve(frameInfo.gameObjects.size());
   for (auto &kv : frameInfo.gameObjects) {
     auto &obj = kv.second;
-    if (obj.model == nullptr)
+    ODModel *model = frameInfo.assets->getModel(obj.model);
+    if (model == nullptr)
       continue;
+    glm::mat4 modelMatrix = obj.transform.mat4();
+    m_culler.add(modelMatrix, model->getBoundsCenter(), model->getBoundsRadius(),
+                 0.5f * (model->getBoundsMax() - model->getBoundsMin()));
+    m_cullObjects.push_back({&obj, model, modelMatrix});
+  }
+
+  // the plane tests are split over the frame pool for large scenes only, the
+  // shared one may be busy encoding streamed textures
+  m_culler.cull(frameInfo.camera.getProjection() * frameInfo.camera.getView(),
+                m_visible, &ODThreadPool::frame());
+
+  m_visibleObjects.clear();
+  for (uint32_t index : m_visible) {
+    m_visibleObjects.push_back(m_cullObjects[index].obj);
+  }
+}
+
+void SimpleRendererSystem::selectLods(FrameInfo &frameInfo) {
+  if (frameInfo.extent.height == 0) {
+    return;
+  }
+  for (uint32_t index : m_visible) {
+    CullObject &object = m_cullObjects[index];
+    ODGameObject &obj = *object.obj;
+    const ODModel *model = object.model;
+    float pixelsPerUnit =
+        getPixelsPerUnit(frameInfo, obj, *model, object.modelMatrix);
+    obj.lod = selectLod(obj, *model, pixelsPerUnit);
 
-    SimplePushConstantData push{};
-    push.modelMatrix = obj.transform.mat4();
-    push.normalMatrix = obj.transform.normalMatrix();
+    // the texture is assumed to span the object once, it needs about as many
+    // texels as the object covers pixels
+    if (obj.texture.isValid()) {
+      float size = glm::length(model->getBoundsMax() - model->getBoundsMin());
+      frameInfo.assets->requestTextureResolution(obj.texture,
+                                                 pixelsPerUnit * size);
+    }
+  }
+}
 
-    vkCmdPushConstants(frameInfo.commandBuffer, m_pipelineLayout,
-                       VK_SHADER_STAGE_VERTEX_BIT |
-                           VK_SHADER_STAGE_FRAGMENT_BIT,
-                       0, // offset
+void SimpleRendererSystem::renderGameObjects(
+    FrameInfo &frameInfo, const MeshletCullingSystem *meshletCulling) {
+  FrameResources &frame = m_frames[frameInfo.frameIndex];
+  reserveObjects(frame, static_cast<uint32_t>(m_visible.size()));
+
+  for (DrawGroup &group : m_groups) {
+    group.commands.clear();
+  }
+  m_directDraws.clear();
+  m_batchLookup.clear();
+  m_batchCount = 0;
+
+  // objects drawing the same model at the same LOD become instances of one
+  // batch, meshlet culled ones keep a draw of their own
+  auto *objects = static_cast<SimpleObjectData *>(frame.objects->getMappedMemory());
+  uint32_t objectCount = 0;
+  auto writeObject = [&](const CullObject &object) {
+    const ODGameObject &obj = *object.obj;
+    const ODModel &model = *object.model;
+    SimpleObjectData &data = objects[objectCount];
+    data.modelMatrix = object.modelMatrix;
+    if (model.isCompact()) {
+      data.modelMatrix = data.modelMatrix * model.getDequantizeMatrix();
+    }
+    data.normalMatrix = glm::mat3x4(obj.transform.normalMatrix());
+    data.textureIndex = frameInfo.assets->getTextureIndex(obj.texture);
+    return objectCount++;
+  };
+  for (uint32_t index : m_visible) {
+    const CullObject &object = m_cullObjects[index];
+    const ODGameObject &obj = *object.obj;
+    ODModel *model = object.model;
+
+    if (meshletCulling != nullptr && meshletCulling->hasDraw(frameInfo, obj)) {
+      m_directDraws.push_back({model, &obj, obj.lod, writeObject(object), 1});
+      continue;
+    }
+    getBatch(model, std::min(obj.lod, model->getLodCount() - 1))
+        .objects.push_back(index);
+  }
+
+  // the instances of a batch are consecutive in the object buffer
+  const bool firstInstance = m_device.supportsDrawIndirectFirstInstance();
+  for (uint32_t i = 0; i < m_batchCount; i++) {
+    const InstanceBatch &batch = m_batches[i];
+    uint32_t firstObject = objectCount;
+    for (uint32_t index : batch.objects) {
+      writeObject(m_cullObjects[index]);
+    }
+    uint32_t instanceCount = static_cast<uint32_t>(batch.objects.size());
+    if (batch.model->hasIndexBuffer() && firstInstance) {
+      getGroup(batch.model->isCompact(), batch.model->getGeometry().arena)
+          .commands.push_back(batch.model->getDrawCommand(batch.lod, firstObject,
+                                                          instanceCount));
+    } else {
+      m_directDraws.push_back(
+          {batch.model, nullptr, batch.lod, firstObject, instanceCount});
+    }
+  }
+  if (objectCount == 0) {
+    return;
+  }
+
+  VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          m_pipelineLayout, 0, 1,
+                          &frameInfo.globalDescriptorSet,
+                          GLOBAL_DYNAMIC_OFFSET_COUNT,
+                          frameInfo.globalDynamicOffsets.data());
+  // every texture is in this one set, objects select theirs by index
+  VkDescriptorSet textureSet =
+      frameInfo.assets->getBindlessTextures().getDescriptorSet();
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          m_pipelineLayout, 1, 1, &textureSet, 0, nullptr);
+  vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          m_pipelineLayout, 2, 1, &frame.objectSet, 0,
+                          nullptr);
+
+  // both pipelines share the layout, the descriptor sets stay bound
+  int boundPipeline = -1;
+  auto bindPipeline = [&](bool compact) {
+    if (boundPipeline != static_cast<int>(compact)) {
+      (compact ? m_compactPipeline : m_odPipeline)->bind(commandBuffer);
+      boundPipeline = static_cast<int>(compact);
+    }
+  };
+  // models share the geometry pool arenas, rebind only when the arena changes
+  uint32_t boundArena = UINT32_MAX;
+  auto bindArena = [&](uint32_t arena) {
+    if (arena != boundArena) {
+      m_device.geometryPool().bind(commandBuffer, arena);
+      boundArena = arena;
+    }
+  };
+
+  SimplePushConstantData push{};
+  vkCmdPushConstants(commandBuffer, m_pipelineLayout,
+                     VK_SHADER_STAGE_VERTEX_BIT, 0,
+                     sizeof(SimplePushConstantData), &push);
+
+  constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+  auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(
+      frame.commands->getMappedMemory());
+  uint32_t commandCount = 0;
+  for (const DrawGroup &group : m_groups) {
+    if (group.commands.empty()) {
+      continue;
+    }
+    bindPipeline(group.compact);
+    bindArena(group.arena);
+
+    std::copy(group.commands.begin(), group.commands.end(),
+              commands + commandCount);
+    VkDeviceSize offset = VkDeviceSize{commandCount} * stride;
+    uint32_t drawCount = static_cast<uint32_t>(group.commands.size());
+    if (m_device.supportsMultiDrawIndirect()) {
+      vkCmdDrawIndexedIndirect(commandBuffer, frame.commands->getBuffer(),
+                               offset, drawCount, stride);
+    } else {
+      for (uint32_t i = 0; i < drawCount; i++) {
+        vkCmdDrawIndexedIndirect(commandBuffer, frame.commands->getBuffer(),
+                                 offset + VkDeviceSize{i} * stride, 1, stride);
+      }
+    }
+    commandCount += drawCount;
+  }
+
+  for (const DirectDraw &draw : m_directDraws) {
+    bindPipeline(draw.model->isCompact());
+    bindArena(draw.model->getGeometry().arena);
+    push.objectIndex = draw.objectIndex;
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout,
+                       VK_SHADER_STAGE_VERTEX_BIT, 0,
                        sizeof(SimplePushConstantData), &push);
-    obj.model->bind(frameInfo.commandBuffer);
-    obj.model->draw(frameInfo.commandBuffer);
+    if (draw.obj != nullptr && meshletCulling->draw(frameInfo, *draw.obj)) {
+      continue;
+    }
+    draw.model->draw(commandBuffer, draw.lod, draw.instanceCount);
   }
 }
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Renderer/Common/ODCamera.h"
+#include "Renderer/Common/ODFrustumCuller.h"
+#include "Renderer/Vulkan/ODBuffer.h"
+#include "Renderer/Vulkan/ODDescriptors.h"
 #include "Renderer/Vulkan/ODDevice.h"
 #include "Renderer/Common/ODModel.h"
 #include "Renderer/Common/ODGameObject.h"
@@ -8,29 +11,143 @@
 #include "Renderer/Common/FrameInfo.h"
 
 // std
+#include <functional>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace ODEngine {
+    class MeshletCullingSystem;
+
+    /*
+     * Lit, textured pass over every game object with a model.
+     *
+     * cull() first tests the world bounds of the objects (ODModel's sphere and box under the
+     * object's transform) against the camera frustum, selectLods and renderGameObjects then
+     * only visit the objects left and reuse the model matrices computed for the test.
+     *
+     * Each frame the objects are batched by model and LOD, and the per-object data (model and
+     * normal matrices, bindless texture index) of every instance is written to a storage buffer
+     * (set 2) that the shaders index with gl_InstanceIndex, a batch's instances back to back.
+     * A batch is one instanced VkDrawIndexedIndirectCommand with the index of its first
+     * instance in firstInstance. The textures being per instance data, objects sharing a model
+     * with different textures still share a batch.
+     *
+     * The commands are grouped by pipeline (full or compact vertices) and geometry pool arena,
+     * each group is drawn with a single vkCmdDrawIndexedIndirect, so the Vulkan calls no longer
+     * grow with the object count. Objects drawn by MeshletCullingSystem, non-indexed models and
+     * devices without drawIndirectFirstInstance take the direct path: the index of the first
+     * instance is pushed as a constant before a regular (instanced) draw.
+     */
     class SimpleRendererSystem {
         public:
+            // objects per frame the buffers hold at first, they grow when a frame needs more
+            static constexpr uint32_t INITIAL_OBJECT_CAPACITY = 1024;
 
-            SimpleRendererSystem(ODDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+            // textureSetLayout: ODBindlessTextures::getSetLayout, bound as set 1
+            SimpleRendererSystem(ODDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                VkDescriptorSetLayout textureSetLayout);
             virtual ~SimpleRendererSystem();
 
             SimpleRendererSystem(const SimpleRendererSystem&) = delete;
             SimpleRendererSystem& operator=(const SimpleRendererSystem&) = delete;
             
-            void renderGameObjects(FrameInfo& frameInfo);
+            // Runs first each frame, the objects outside of the camera frustum are neither
+            // given a LOD nor drawn. MeshletCullingSystem tests the meshlets of the objects left
+            // on the GPU.
+            void cull(FrameInfo& frameInfo);
+            // objects with a model that passed cull this frame
+            const std::vector<ODGameObject*>& getVisibleObjects() const { return m_visibleObjects; }
+            // Picks obj.lod for every visible object, before MeshletCullingSystem::cull reads it, and
+            // requests the texture resolution each textured object needs on screen
+            void selectLods(FrameInfo& frameInfo);
+            // objects culled by meshletCulling this frame are drawn from its indirect commands
+            void renderGameObjects(FrameInfo& frameInfo, const MeshletCullingSystem* meshletCulling = nullptr);
+
+            // a LOD is used while its error stays under this many pixels on screen
+            static constexpr float LOD_PIXEL_ERROR = 1.0f;
+            static constexpr float LOD_HYSTERESIS = 0.25f;
 
         private:
-            void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+            struct FrameResources {
+                std::unique_ptr<ODBuffer> objects;  // ObjectData, set 2
+                std::unique_ptr<ODBuffer> commands; // indirect commands, grouped
+                VkDescriptorSet objectSet = VK_NULL_HANDLE;
+                uint32_t capacity = 0;
+            };
+
+            // objects sharing a pipeline and a geometry pool arena
+            struct DrawGroup {
+                bool compact;
+                uint32_t arena;
+                std::vector<VkDrawIndexedIndirectCommand> commands;
+            };
+
+            struct InstanceBatch {
+                ODModel* model = nullptr;
+                uint32_t lod = 0;
+                std::vector<uint32_t> objects; // into m_cullObjects
+            };
+
+            struct BatchKey {
+                const ODModel* model;
+                uint32_t lod;
+                bool operator==(const BatchKey& other) const { return model == other.model && lod == other.lod; }
+            };
+
+            struct BatchKeyHash {
+                size_t operator()(const BatchKey& key) const {
+                    return std::hash<const ODModel*>{}(key.model) ^ (size_t{key.lod} << 1);
+                }
+            };
+
+            struct CullObject {
+                ODGameObject* obj;
+                ODModel* model;
+                glm::mat4 modelMatrix;
+            };
+
+            struct DirectDraw {
+                ODModel* model;
+                const ODGameObject* obj; // set for the meshlet culled objects
+                uint32_t lod;
+                uint32_t objectIndex;
+                uint32_t instanceCount;
+            };
+
+            void createObjectDescriptors();
+            // the buffers of the frame index are not read by the GPU anymore at this point
+            void reserveObjects(FrameResources& frame, uint32_t count);
+            DrawGroup& getGroup(bool compact, uint32_t arena);
+            InstanceBatch& getBatch(ODModel* model, uint32_t lod);
+            void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout);
             void createPipeline(VkRenderPass renderPass);
+            // infinity when the camera is inside the bounding sphere
+            float getPixelsPerUnit(const FrameInfo& frameInfo, const ODGameObject& obj, const ODModel& model,
+                const glm::mat4& modelMatrix) const;
+            uint32_t selectLod(const ODGameObject& obj, const ODModel& model, float pixelsPerUnit) const;
 
         private:
             ODDevice& m_device;
             std::unique_ptr<ODGraphicsPipeline> m_odPipeline;
+            // same layout and fragment shader, fed with ODModel::CompactVertex
+            std::unique_ptr<ODGraphicsPipeline> m_compactPipeline;
             VkPipelineLayout m_pipelineLayout = nullptr;
+
+            std::unique_ptr<ODDescriptorSetLayout> m_objectSetLayout;
+            std::unique_ptr<ODDescriptorPool> m_objectDescriptorPool;
+            std::vector<FrameResources> m_frames;
+            // rebuilt every frame, kept to reuse their allocations
+            ODFrustumCuller m_culler;
+            std::vector<CullObject> m_cullObjects; // objects with a model, in culler order
+            std::vector<uint32_t> m_visible;       // into m_cullObjects
+            std::vector<ODGameObject*> m_visibleObjects;
+            std::vector<DrawGroup> m_groups;
+            std::vector<DirectDraw> m_directDraws;
+            // the first m_batchCount are this frame's
+            std::vector<InstanceBatch> m_batches;
+            uint32_t m_batchCount = 0;
+            std::unordered_map<BatchKey, uint32_t, BatchKeyHash> m_batchLookup;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "ODJson.h"
+
+// std
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace ODEngine {
+
+    namespace {
+        const ODJson NULL_VALUE{};
+        const std::string EMPTY_STRING{};
+        const std::map<std::string, ODJson> EMPTY_OBJECT{};
+
+        // nesting deeper than this is not a glTF, stops runaway recursion on hostile input
+        constexpr uint32_t MAX_DEPTH = 256;
+    }
+
+    class ODJson::Parser {
+        public:
+            explicit Parser(std::string_view text) : m_text(text) {}
+
+            ODJson parseDocument() {
+                ODJson value = parseValue(0);
+                skipWhitespace();
+                if (m_pos != m_text.size()) {
+                    fail("trailing characters");
+                }
+                return value;
+            }
+
+        private:
+            [[noreturn]] void fail(const char* what) const {
+                throw std::runtime_error("invalid json at offset " + std::to_string(m_pos) + ": " + what + "!");
+            }
+
+            void skipWhitespace() {
+                while (m_pos < m_text.size() &&
+                    (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+                    m_pos++;
+                }
+            }
+
+            char peek() {
+                skipWhitespace();
+                if (m_pos >= m_text.size()) {
+                    fail("unexpected end");
+                }
+                return m_text[m_pos];
+            }
+
+            void expect(char c) {
+                if (peek() != c) {
+                    fail("unexpected character");
+                }
+                m_pos++;
+            }
+
+            bool consumeLiteral(std::string_view literal) {
+                if (m_text.substr(m_pos, literal.size()) != literal) {
+                    return false;
+                }
+                m_pos += literal.size();
+                return true;
+            }
+
+            ODJson parseValue(uint32_t depth) {
+                if (depth > MAX_DEPTH) {
+                    fail("nesting too deep");
+                }
+                ODJson value{};
+                char c = peek();
+                if (c == '{') {
+                    value.m_type = Type::Object;
+                    m_pos++;
+                    if (peek() == '}') {
+                        m_pos++;
+                        return value;
+                    }
+                    while (true) {
+                        if (peek() != '"') {
+                            fail("expected a key");
+                        }
+                        std::string key = parseString();
+                        expect(':');
+                        value.m_object.insert_or_assign(std::move(key), parseValue(depth + 1));
+                        if (peek() == ',') {
+                            m_pos++;
+                            continue;
+                        }
+                        expect('}');
+                        return value;
+                    }
+                }
+                if (c == '[') {
+                    value.m_type = Type::Array;
+                    m_pos++;
+                    if (peek() == ']') {
+                        m_pos++;
+                        return value;
+                    }
+                    while (true) {
+                        value.m_array.push_back(parseValue(depth + 1));
+                        if (peek() == ',') {
+                            m_pos++;
+                            continue;
+                        }
+                        expect(']');
+                        return value;
+                    }
+                }
+                if (c == '"') {
+                    value.m_type = Type::String;
+                    value.m_string = parseString();
+                    return value;
+                }
+                if (consumeLiteral("true")) {
+                    value.m_type = Type::Bool;
+                    value.m_bool = true;
+                    return value;
+                }
+                if (consumeLiteral("false")) {
+                    value.m_type = Type::Bool;
+                    return value;
+                }
+                if (consumeLiteral("null")) {
+                    return value;
+                }
+                value.m_type = Type::Number;
+                value.m_number = parseNumber();
+                return value;
+            }
+
+            double parseNumber() {
+                const char* begin = m_text.data() + m_pos;
+                const char* end = m_text.data() + m_text.size();
+                double number = 0.0;
+                auto [ptr, ec] = std::from_chars(begin, end, number);
+                if (ec != std::errc{} || ptr == begin) {
+                    fail("expected a value");
+                }
+                // from_chars also reads inf and nan, which JSON has no literal for
+                if (!std::isfinite(number)) {
+                    fail("expected a finite number");
+                }
+                m_pos += static_cast<size_t>(ptr - begin);
+                return number;
+            }
+
+            uint32_t parseHex4() {
+                if (m_pos + 4 > m_text.size()) {
+                    fail("truncated escape");
+                }
+                uint32_t code = 0;
+                auto [ptr, ec] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_pos + 4, code, 16);
+                if (ec != std::errc{} || ptr != m_text.data() + m_pos + 4) {
+                    fail("invalid escape");
+                }
+                m_pos += 4;
+                return code;
+            }
+
+            static void appendUtf8(std::string& out, uint32_t code) {
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            std::string parseString() {
+                m_pos++; // opening quote
+                std::string out;
+                while (true) {
+                    if (m_pos >= m_text.size()) {
+                        fail("unterminated string");
+                    }
+                    char c = m_text[m_pos++];
+                    if (c == '"') {
+                        return out;
+                    }
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+                    if (m_pos >= m_text.size()) {
+                        fail("unterminated string");
+                    }
+                    char escape = m_text[m_pos++];
+                    switch (escape) {
+                        case '"': out += '"'; break;
+                        case '\\': out += '\\'; break;
+                        case '/': out += '/'; break;
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        case 'n': out += '\n'; break;
+                        case 'r': out += '\r'; break;
+                        case 't': out += '\t'; break;
+                        case 'u': {
+                            uint32_t code = parseHex4();
+                            // surrogate pair
+                            if (code >= 0xD800 && code < 0xDC00 && consumeLiteral("\\u")) {
+                                uint32_t low = parseHex4();
+                                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            }
+                            appendUtf8(out, code);
+                            break;
+                        }
+                        default: fail("invalid escape");
+                    }
+                }
+            }
+
+            std::string_view m_text;
+            size_t m_pos = 0;
+    };
+
+    ODJson ODJson::parse(std::string_view text) {
+        return Parser{text}.parseDocument();
+    }
+
+    bool ODJson::has(const std::string &key) const {
+        return m_type == Type::Object && m_object.count(key) > 0;
+    }
+
+    size_t ODJson::size() const {
+        if (m_type == Type::Array) {
+            return m_array.size();
+        }
+        return m_type == Type::Object ? m_object.size() : 0;
+    }
+
+    const ODJson &ODJson::operator[](size_t index) const {
+        return m_type == Type::Array && index < m_array.size() ? m_array[index] : NULL_VALUE;
+    }
+
+    const ODJson &ODJson::operator[](const std::string &key) const {
+        if (m_type != Type::Object) {
+            return NULL_VALUE;
+        }
+        auto it = m_object.find(key);
+        return it != m_object.end() ? it->second : NULL_VALUE;
+    }
+
+    const std::map<std::string, ODJson> &ODJson::members() const {
+        return m_type == Type::Object ? m_object : EMPTY_OBJECT;
+    }
+
+    int64_t ODJson::asInt(int64_t fallback) const {
+        if (m_type != Type::Number) {
+            return fallback;
+        }
+        // 2^63, the first double past the int64_t range
+        constexpr double INT64_LIMIT = 9223372036854775808.0;
+        if (!std::isfinite(m_number) || m_number < -INT64_LIMIT || m_number >= INT64_LIMIT) {
+            throw std::runtime_error("json number out of the integer range!");
+        }
+        return static_cast<int64_t>(m_number);
+    }
+
+    const std::string &ODJson::asString() const {
+        return m_type == Type::String ? m_string : EMPTY_STRING;
+    }
+}
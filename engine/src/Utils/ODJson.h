@@ -0,0 +1,54 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ODEngine {
+    // Read-only JSON document, enough for glTF: parse() builds the whole tree up front and
+    // throws std::runtime_error on malformed input. Lookups on missing keys, out of range
+    // indices or values of another type return the null value instead of throwing.
+    class ODJson {
+        public:
+            enum class Type { Null, Bool, Number, String, Array, Object };
+
+            ODJson() = default;
+
+            static ODJson parse(std::string_view text);
+
+            Type getType() const { return m_type; }
+            bool isNull() const { return m_type == Type::Null; }
+            bool isObject() const { return m_type == Type::Object; }
+            bool isArray() const { return m_type == Type::Array; }
+            bool isNumber() const { return m_type == Type::Number; }
+            bool has(const std::string& key) const;
+
+            // array length or object member count
+            size_t size() const;
+            const ODJson& operator[](size_t index) const;
+            const ODJson& operator[](const std::string& key) const;
+            const std::map<std::string, ODJson>& members() const;
+
+            bool asBool(bool fallback = false) const { return m_type == Type::Bool ? m_bool : fallback; }
+            double asNumber(double fallback = 0.0) const { return m_type == Type::Number ? m_number : fallback; }
+            // truncated toward zero, throws for a number outside the int64_t range
+            int64_t asInt(int64_t fallback = 0) const;
+            float asFloat(float fallback = 0.f) const { return static_cast<float>(asNumber(fallback)); }
+            const std::string& asString() const;
+
+        private:
+            class Parser;
+
+            Type m_type = Type::Null;
+            bool m_bool = false;
+            double m_number = 0.0;
+            std::string m_string;
+            std::vector<ODJson> m_array;
+            std::map<std::string, ODJson> m_object;
+    };
+}
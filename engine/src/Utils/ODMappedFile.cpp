@@ -0,0 +1,121 @@
+#include "ODMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// std
+#include <utility>
+
+namespace ODEngine {
+    ODMappedFile::ODMappedFile(ODMappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    ODMappedFile& ODMappedFile::operator=(ODMappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+            m_fileHandle = std::exchange(other.m_fileHandle, nullptr);
+            m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool ODMappedFile::open(const std::string& filepath) {
+        close();
+
+        HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_fileHandle = file;
+        m_mappingHandle = mapping;
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+    }
+
+    void ODMappedFile::close() {
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mappingHandle) {
+            CloseHandle(m_mappingHandle);
+        }
+        if (m_fileHandle) {
+            CloseHandle(m_fileHandle);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_fileHandle = nullptr;
+        m_mappingHandle = nullptr;
+    }
+#else
+    bool ODMappedFile::open(const std::string& filepath) {
+        close();
+
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+        m_data = static_cast<const uint8_t*>(view);
+        m_size = static_cast<size_t>(fileStat.st_size);
+        return true;
+    }
+
+    void ODMappedFile::close() {
+        if (m_data) {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+}
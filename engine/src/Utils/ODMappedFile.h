@@ -0,0 +1,37 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ODEngine {
+    // Read-only memory mapping of a whole file (mmap / MapViewOfFile)
+    class ODMappedFile {
+        public:
+            ODMappedFile() = default;
+            explicit ODMappedFile(const std::string& filepath) { open(filepath); }
+            ~ODMappedFile() { close(); }
+
+            ODMappedFile(const ODMappedFile&) = delete;
+            ODMappedFile& operator=(const ODMappedFile&) = delete;
+            ODMappedFile(ODMappedFile&& other) noexcept;
+            ODMappedFile& operator=(ODMappedFile&& other) noexcept;
+
+            // returns false if the file does not exist, is empty or cannot be mapped
+            bool open(const std::string& filepath);
+            void close();
+
+            bool isOpen() const { return m_data != nullptr; }
+            const uint8_t* data() const { return m_data; }
+            size_t size() const { return m_size; }
+
+        private:
+            const uint8_t* m_data = nullptr;
+            size_t m_size = 0;
+#ifdef _WIN32
+            void* m_fileHandle = nullptr;
+            void* m_mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,92 @@
+#include "ODThreadPool.h"
+
+// std
+#include <algorithm>
+
+namespace ODEngine {
+    ODThreadPool::ODThreadPool(uint32_t workerCount) {
+        m_workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; i++) {
+            m_workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ODThreadPool::~ODThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    ODThreadPool& ODThreadPool::shared() {
+        static ODThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    ODThreadPool& ODThreadPool::frame() {
+        static ODThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+
+    void ODThreadPool::workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+                // drain the queue before leaving so no future is left without a value
+                if (m_tasks.empty()) {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ODThreadPool::parallelFor(size_t count, size_t chunkCount,
+        const std::function<void(size_t chunk, size_t begin, size_t end)>& fn) {
+        chunkCount = std::clamp<size_t>(chunkCount, 1, std::max<size_t>(count, 1));
+        auto chunkBegin = [count, chunkCount](size_t chunk) { return count * chunk / chunkCount; };
+
+        if (m_workers.empty() || chunkCount == 1) {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                fn(chunk, chunkBegin(chunk), chunkBegin(chunk + 1));
+            }
+            return;
+        }
+
+        std::vector<std::future<void>> pending;
+        pending.reserve(chunkCount - 1);
+        for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+            pending.push_back(submit([&fn, chunk, begin = chunkBegin(chunk), end = chunkBegin(chunk + 1)]() {
+                fn(chunk, begin, end);
+            }));
+        }
+
+        // every chunk has to finish before returning, fn and its captures live on our stack
+        std::exception_ptr error;
+        try {
+            fn(0, chunkBegin(0), chunkBegin(1));
+        } catch (...) {
+            error = std::current_exception();
+        }
+        for (auto& future : pending) {
+            try {
+                future.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// std
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ODEngine {
+    // Fixed set of worker threads consuming a FIFO task queue
+    class ODThreadPool {
+        public:
+            // workerCount = 0 gives a pool where parallelFor runs everything on the caller
+            explicit ODThreadPool(uint32_t workerCount);
+            ~ODThreadPool();
+
+            ODThreadPool(const ODThreadPool&) = delete;
+            ODThreadPool& operator=(const ODThreadPool&) = delete;
+
+            // pool shared by the engine, one worker per hardware thread minus the caller
+            static ODThreadPool& shared();
+            // Same size, reserved for the work the main thread waits on every frame (culling...).
+            // Its queue never holds the long background chunks the shared pool gets from asset
+            // streaming (mips, block compression, cache writes), so a frame is not stalled
+            // behind them: the OS time slices the two sets of workers instead.
+            static ODThreadPool& frame();
+
+            uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+            // threads taking part in a parallelFor: the workers plus the calling thread
+            uint32_t getConcurrency() const { return getWorkerCount() + 1; }
+
+            template<typename F>
+            auto submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+                using Result = std::invoke_result_t<F>;
+                auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+                std::future<Result> future = packaged->get_future();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.emplace_back([packaged]() { (*packaged)(); });
+                }
+                m_condition.notify_one();
+                return future;
+            }
+
+            // Splits [0, count) in chunkCount contiguous ranges of (almost) equal size and
+            // calls fn(chunk, begin, end) for each of them. Chunk 0 runs on the caller, the
+            // call returns once every chunk is done and rethrows the first exception.
+            void parallelFor(size_t count, size_t chunkCount,
+                const std::function<void(size_t chunk, size_t begin, size_t end)>& fn);
+
+        private:
+            void workerLoop();
+
+            std::vector<std::thread> m_workers;
+            std::deque<std::function<void()>> m_tasks;
+            std::mutex m_mutex;
+            std::condition_variable m_condition;
+            bool m_stopping = false;
+    };
+}
@@ -1,9 +1,11 @@
 #include "app.h"
 
+#include "Renderer/Common/ODGltfLoader.h"
 #include "Renderer/Common/Particle.h"
 #include "Renderer/Vulkan/ODBuffer.h"
 #include "RendererSystems/GPUParticleSystem.h"
 #include "RendererSystems/GridSystem.h"
+#include "RendererSystems/MeshletCullingSystem.h"
 #include "RendererSystems/PointLightSystem.h"
 #include "RendererSystems/SimpleRendererSystem.h"
 #include "Utils/keyboardMovementController.h"
@@ -28,16 +30,14 @@ App::App() {
       ODDescriptorPool::Builder(m_device)
           .setMaxSets(ODSwapChain::MAX_FRAMES_IN_FLIGHT)
           .addPoolSize(
-              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
               ODSwapChain::MAX_FRAMES_IN_FLIGHT) // contient les infos de la
                                                  // caméra et de l'éclairage
-          .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                       ODSwapChain::MAX_FRAMES_IN_FLIGHT) // texture
           .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                        ODSwapChain::MAX_FRAMES_IN_FLIGHT *
                            2) // buffer compute.comp <-> compute.vert et .frag
           .addPoolSize(
-              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
               ODSwapChain::MAX_FRAMES_IN_FLIGHT) // info de pas de temps pour le
                                                  // compute shader
           .build();
@@ -76,32 +76,16 @@ void App::run() {
       m_renderer.getSwapChain().getSwapChainImageFormat(),
       m_device.graphicsQueue());
 
-  std::vector<std::unique_ptr<ODBuffer>> uboComputeBuffers(
-      ODSwapChain::MAX_FRAMES_IN_FLIGHT);
-  for (int i = 0; i < uboComputeBuffers.size(); i++) {
-    uboComputeBuffers[i] =
-        std::make_unique<ODBuffer>(m_device, sizeof(ComputeShaderUbo), 1,
-                                   VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    uboComputeBuffers[i]->map();
-  }
-
-  std::vector<std::unique_ptr<ODBuffer>> uboBuffers(
-      ODSwapChain::MAX_FRAMES_IN_FLIGHT);
-  for (int i = 0; i < uboBuffers.size(); i++) {
-    uboBuffers[i] = std::make_unique<ODBuffer>(
-        m_device, sizeof(GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-    uboBuffers[i]->map();
-  }
+  // uniform data lives in the renderer's frame allocator, bindings 0 and 4
+  // are dynamic and get their offsets at bind time
+  ODFrameAllocator &frameAllocator = m_renderer.getFrameAllocator();
 
   auto globalSetLayout =
       ODDescriptorSetLayout::Builder(m_device)
-          .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                       VK_SHADER_STAGE_ALL_GRAPHICS |
                           VK_SHADER_STAGE_COMPUTE_BIT)
-          .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                      VK_SHADER_STAGE_FRAGMENT_BIT)
+          // binding 1 (the texture) moved to ODBindlessTextures, set 1
 
           // computer shader binding
           .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
@@ -109,7 +93,7 @@ void App::run() {
           .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                       VK_SHADER_STAGE_COMPUTE_BIT)
 
-          .addBinding(4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          .addBinding(4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
                       VK_SHADER_STAGE_COMPUTE_BIT)
 
           .build();
@@ -117,26 +101,31 @@ void App::run() {
   std::vector<VkDescriptorSet> globalDescriptorSets(
       ODSwapChain::MAX_FRAMES_IN_FLIGHT); // 1 descriptor set per frame
   for (int i = 0; i < globalDescriptorSets.size(); i++) {
-    auto bufferInfo = uboBuffers[i]->descriptorInfo();
-    auto imageInfo = m_textureHandler->descriptorInfo();
+    auto bufferInfo = frameAllocator.descriptorInfo(sizeof(GlobalUbo));
     auto computeBufferInfo0 =
         m_particleSystem.getParticleBuffers()[i]->descriptorInfo();
     auto computeBufferInfo1 =
         m_particleSystem.getParticleBuffers()[(i + 1) % 2]->descriptorInfo();
-    auto coomputeBufferTime = uboComputeBuffers[i]->descriptorInfo();
+    auto coomputeBufferTime =
+        frameAllocator.descriptorInfo(sizeof(ComputeShaderUbo));
 
     ODDescriptorWriter(*globalSetLayout, *m_globalDescriptorPool)
         .writeBuffer(0, &bufferInfo)
-        .writeImage(1, &imageInfo)
         .writeBuffer(2, &computeBufferInfo0)
         .writeBuffer(3, &computeBufferInfo1)
         .writeBuffer(4, &coomputeBufferTime)
         .build(globalDescriptorSets[i]);
   }
 
+  // objects without a texture of their own sample the global one
+  ODBindlessTextures &bindlessTextures = m_assets.getBindlessTextures();
+  bindlessTextures.setDefaultTexture(m_textureHandler->descriptorInfo());
+
   SimpleRendererSystem simpleRendererSystem(
       m_device, m_renderer.getSwapChainRenderPass(),
-      globalSetLayout->getDescriptorSetLayout());
+      globalSetLayout->getDescriptorSetLayout(),
+      bindlessTextures.getSetLayout());
+  MeshletCullingSystem meshletCullingSystem(m_device, frameAllocator);
   PointLightSystem pointLightSystem(m_device,
                                     m_renderer.getSwapChainRenderPass(),
                                     globalSetLayout->getDescriptorSetLayout());
@@ -158,6 +147,11 @@ void App::run() {
   m_cameraObject.camera->setPerspectiveProjection(glm::radians(50.0f), aspect,
                                                   0.1f, 1000.0f);
 
+  // every startup resource is allocated at this point, submit their uploads
+  // in one batch
+  m_device.uploadQueue().flush();
+  m_device.allocator().printStats();
+
   auto currentTime = std::chrono::high_resolution_clock::now();
 
   while (!m_window.shouldClose()) {
@@ -184,6 +178,12 @@ void App::run() {
     float aspect = m_renderer.getAspectRatio();
     m_cameraObject.camera->updatePerspectiveProjection(aspect);
 
+    // streamed assets record their uploads within the frame budget, then the
+    // uploads recorded since the last frame are submitted before the frame
+    // that uses them
+    m_assets.update();
+    m_device.uploadQueue().flush();
+
     int frameIndex = m_renderer.getCurrentFrameIndex();
     auto commandBuffer = m_renderer.beginFrame();
 
@@ -198,6 +198,8 @@ void App::run() {
           m_gameObjects,
           m_particleSystem.getParticleBuffers()[(frameIndex + 1) % 2]
               ->getBuffer()};
+      frameInfo.extent = m_renderer.getSwapChain().getSwapChainExtent();
+      frameInfo.assets = &m_assets;
 
       // update
       GlobalUbo ubo{};
@@ -205,15 +207,14 @@ void App::run() {
       ubo.view = m_cameraObject.camera->getView();
       ubo.inverseView = m_cameraObject.camera->getInverseView();
       pointLightSystem.update(frameInfo, ubo);
-      uboBuffers[frameIndex]->writeToBuffer(&ubo);
-      uboBuffers[frameIndex]->flush();
+      frameInfo.globalDynamicOffsets[0] = frameAllocator.push(ubo);
 
       // compute
       ComputeShaderFrameInfo computeFrameInfo{deltaTime, commandBuffer,
                                               globalDescriptorSets[frameIndex]};
 
-      uboComputeBuffers[frameIndex]->writeToBuffer(&deltaTime);
-      uboComputeBuffers[frameIndex]->flush();
+      frameInfo.globalDynamicOffsets[1] =
+          frameAllocator.push(ComputeShaderUbo{deltaTime});
 
       // compute
       gpuParticleSystem.compute(frameInfo,
@@ -221,12 +222,19 @@ void App::run() {
                                 m_renderer.getComputeFinishedSemaphores(),
                                 m_renderer.getComputeInFlightFences());
 
+      // meshlet culling writes the indirect draws of this frame, it needs the
+      // LODs and has to run outside of the render pass
+      simpleRendererSystem.cull(frameInfo);
+      simpleRendererSystem.selectLods(frameInfo);
+      meshletCullingSystem.cull(frameInfo,
+                                simpleRendererSystem.getVisibleObjects());
+
       // render
       m_renderer.beginSwapChainRenderPass(commandBuffer);
 
       // order matters for alpha blending
       gpuParticleSystem.render(frameInfo);
-      simpleRendererSystem.renderGameObjects(frameInfo);
+      simpleRendererSystem.renderGameObjects(frameInfo, &meshletCullingSystem);
       // gridSystem.render(frameInfo);
       pointLightSystem.render(frameInfo);
 
@@ -310,9 +318,99 @@ void App::run() {
   vkDeviceWaitIdle(m_device.device());
 }
 
-std::shared_ptr<ODModel>
-App::createModelFromFile(const std::string &modelPath) {
-  return ODModel::createModelFromFile(m_device, modelPath);
+ODModelHandle
+App::createModelFromFile(const std::string &modelPath,
+                         const ODVertexCompressionSettings &compression) {
+  return m_assets.loadModel(modelPath, compression,
+                            ODAssetRegistry::LoadMode::Blocking);
+}
+
+ODModelHandle
+App::loadModelAsync(const std::string &modelPath,
+                    const ODVertexCompressionSettings &compression,
+                    ODAssetRegistry::ModelCallback onDone) {
+  return m_assets.loadModel(modelPath, compression,
+                            ODAssetRegistry::LoadMode::Async,
+                            std::move(onDone));
+}
+
+ODTextureHandle
+App::loadTextureAsync(const std::string &texturePath,
+                      ODAssetRegistry::TextureCallback onDone) {
+  return m_assets.loadTexture(texturePath, ODAssetRegistry::LoadMode::Async,
+                              std::move(onDone));
+}
+
+std::vector<ODTextureHandle>
+App::loadTextures(const std::vector<std::string> &texturePaths) {
+  return m_assets.loadTextures(texturePaths,
+                               ODAssetRegistry::LoadMode::Blocking);
+}
+
+std::vector<ODGameObject::id_t>
+App::loadGltfScene(const std::string &scenePath) {
+  ODGltfScene scene = ODGltfLoader::load(scenePath);
+
+  // primitives are registered as <canonical path>#<mesh>/<primitive>, loading
+  // the scene again reuses the uploaded models
+  std::string key = ODAssetRegistry::canonicalPath(scenePath);
+  std::vector<std::vector<ODModelHandle>> meshModels(scene.meshes.size());
+  for (size_t m = 0; m < scene.meshes.size(); m++) {
+    for (size_t p = 0; p < scene.meshes[m].primitives.size(); p++) {
+      meshModels[m].push_back(m_assets.addModel(
+          key + "#" + std::to_string(m) + "/" + std::to_string(p),
+          scene.meshes[m].primitives[p].builder));
+    }
+  }
+
+  // base color images as <canonical path>#image<index>, decoded once however
+  // many materials share them
+  std::vector<ODTextureHandle> images(scene.images.size());
+  auto materialTexture = [&](int32_t material) {
+    if (material < 0 || static_cast<size_t>(material) >= scene.materials.size()) {
+      return ODTextureHandle{};
+    }
+    int32_t image = scene.materials[material].baseColorImage;
+    if (image < 0) {
+      return ODTextureHandle{};
+    }
+    if (!images[image].isValid()) {
+      const std::vector<uint8_t> &data = scene.images[image].data;
+      images[image] = m_assets.addTexture(
+          key + "#image" + std::to_string(image), data.data(), data.size());
+    }
+    return images[image];
+  };
+
+  std::vector<ODGameObject::id_t> ids;
+  for (const ODGltfScene::Node &node : scene.nodes) {
+    if (node.mesh < 0) {
+      continue;
+    }
+    const auto &primitives = scene.meshes[node.mesh].primitives;
+    for (size_t p = 0; p < primitives.size(); p++) {
+      auto gameObject = ODGameObject::createGameObject();
+      gameObject.model.reset(m_assets, meshModels[node.mesh][p]);
+      gameObject.texture.reset(m_assets, materialTexture(primitives[p].material));
+      gameObject.transform.setFromMatrix(node.world);
+      ids.push_back(gameObject.getId());
+      m_gameObjects.emplace(gameObject.getId(), std::move(gameObject));
+    }
+  }
+
+  // the objects hold their own references, the ones addModel and addTexture
+  // returned are dropped so unused primitives and images can be evicted
+  for (const auto &models : meshModels) {
+    for (ODModelHandle model : models) {
+      m_assets.release(model);
+    }
+  }
+  for (ODTextureHandle image : images) {
+    if (image.isValid()) {
+      m_assets.release(image);
+    }
+  }
+  return ids;
 }
 
 void App::createTransitionResources() {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Renderer/Common/ODAssetRegistry.h"
 #include "Renderer/Common/ODCamera.h"
 #include "Renderer/Common/ODGameObject.h"
 #include "Renderer/Common/ODModel.h"
@@ -32,7 +33,29 @@ public:
   ODDevice &getDevice() { return m_device; }
 
 protected:
-  std::shared_ptr<ODModel> createModelFromFile(const std::string &modelPath);
+  // compression opts the mesh into the compact vertex layout when it fits the tolerances.
+  // Loads (or shares) the model before returning, the handle holds one reference.
+  ODModelHandle
+  createModelFromFile(const std::string &modelPath,
+                      const ODVertexCompressionSettings &compression = {});
+  // returns right away, the model becomes resident during a later frame and
+  // onDone runs on the main thread at that point
+  ODModelHandle
+  loadModelAsync(const std::string &modelPath,
+                 const ODVertexCompressionSettings &compression = {},
+                 ODAssetRegistry::ModelCallback onDone = {});
+  ODTextureHandle
+  loadTextureAsync(const std::string &texturePath,
+                   ODAssetRegistry::TextureCallback onDone = {});
+  // decodes the files concurrently and uploads them before returning, each
+  // handle holds one reference
+  std::vector<ODTextureHandle>
+  loadTextures(const std::vector<std::string> &texturePaths);
+  // Imports a .glb: one game object per primitive of every node with a mesh,
+  // placed at the node's world transform and textured with the base color image
+  // of its material. Returns the created objects.
+  std::vector<ODGameObject::id_t> loadGltfScene(const std::string &scenePath);
+  ODAssetRegistry &getAssets() { return m_assets; }
 
 private:
   virtual void loadGameObjects() = 0;
@@ -46,6 +69,7 @@ private:
   ODDevice m_device{m_window};
   std::shared_ptr<UIManager> m_uiManager = std::make_shared<UIManager>();
   ODRenderer m_renderer{m_window, m_device, m_uiManager};
+  ODAssetRegistry m_assets{m_device};
   ODParticles::ParticleSystem m_particleSystem{m_device, WIDTH, HEIGHT};
   std::unique_ptr<ODDescriptorPool> m_globalDescriptorPool{};
   std::shared_ptr<ODGameObject> m_cameraObject = nullptr;
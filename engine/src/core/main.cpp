@@ -1,13 +1,26 @@
 #include "app.h"
+#include "Renderer/Common/ODModel.h"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 extern ODEngine::App* ODEngine::CreateApp();
 
-int main() {
+int main(int argc, char** argv) {
+    // --bench-import <file.obj> : times OBJ import scaling with the thread count, no window
+    if (argc == 3 && std::string(argv[1]) == "--bench-import") {
+        try {
+            ODEngine::ODModel::Builder::benchmarkImport(argv[2]);
+        } catch(const std::exception &e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     auto app = ODEngine::CreateApp();
     try {
         app->run();
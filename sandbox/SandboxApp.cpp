@@ -24,15 +24,21 @@ namespace ODEngine {
 
         m_textureHandler->addTexture("sandbox/textures/viking_room.png");
         
-        std::shared_ptr<ODModel> roomModel = createModelFromFile("sandbox/models/room.obj");
+        // models stream in while the window is already up, a placeholder cube stands in meanwhile
+        ODModelHandle roomModel = loadModelAsync("sandbox/models/room.obj", {}, [](ODModelHandle, ODAssetRegistry::State state) {
+            std::cout << "room.obj" << (state == ODAssetRegistry::State::Resident ? " loaded" : " failed to load") << std::endl;
+        });
         create3DObjFromFile(glm::vec3(0.f, 0.f, 0.f), glm::vec3(glm::half_pi<float>(), glm::half_pi<float>(), .0f), glm::vec3(1.f, 1.f, 1.f), roomModel);
 
-        std::shared_ptr<ODModel> vaseModel = createModelFromFile("sandbox/models/smooth_vase.obj");
+        ODModelHandle vaseModel = loadModelAsync("sandbox/models/smooth_vase.obj");
         for(int i=0; i<10; i++) {
             for(int k=0; k<10; k++) {
             // create3DObjFromFile(glm::vec3((float)i - 5.f, 0.f, (float)k - 5.f), glm::vec3(.0f, .0f, .0f), glm::vec3(2.f, 2.f, 2.f), vaseModel);
             }
         }
+        // the objects hold their own references to the models from here
+        getAssets().release(roomModel);
+        getAssets().release(vaseModel);
 
         std::vector<glm::vec3> lightColors{
             {1.f, .1f, .1f},
@@ -55,9 +61,9 @@ namespace ODEngine {
         }
     }
 
-        void SandboxApp::create3DObjFromFile(glm::vec3 translation, glm::vec3 rotation, glm::vec3 scale, std::shared_ptr<ODModel> model){
+        void SandboxApp::create3DObjFromFile(glm::vec3 translation, glm::vec3 rotation, glm::vec3 scale, ODModelHandle model){
             auto gameObject = ODGameObject::createGameObject();
-            gameObject.model = model;
+            gameObject.model.reset(getAssets(), model);
             gameObject.transform.translation = translation;
             gameObject.transform.rotation = rotation;
             gameObject.transform.scale = scale;
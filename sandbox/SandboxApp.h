@@ -15,7 +15,7 @@ namespace ODEngine {
 
     private:
 
-        void create3DObjFromFile(glm::vec3 translation, glm::vec3 rotation, glm::vec3 scale,  std::shared_ptr<ODModel> model);
+        void create3DObjFromFile(glm::vec3 translation, glm::vec3 rotation, glm::vec3 scale,  ODModelHandle model);
         
     };
 }